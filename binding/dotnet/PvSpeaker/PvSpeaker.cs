@@ -15,6 +15,8 @@ using System.IO;
 using System.Reflection;
 using System.Runtime.InteropServices;
 using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
 
 namespace Pv
 {
@@ -31,7 +33,8 @@ namespace Pv
         DEVICE_ALREADY_INITIALIZED = 5,
         DEVICE_NOT_INITIALIZED = 6,
         IO_ERROR = 7,
-        RUNTIME_ERROR = 8
+        RUNTIME_ERROR = 8,
+        TIMEOUT = 9
     }
 
     /// <summary>
@@ -40,8 +43,38 @@ namespace Pv
     public class PvSpeaker : IDisposable
     {
         private const string LIBRARY = "libpv_speaker";
+        private const int CANCEL_FADE_MS = 10;
         private IntPtr _libraryPointer = IntPtr.Zero;
 
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        private delegate void NotificationCallback(IntPtr userData);
+
+        // kept in a static field, so that the library never calls into a delegate that was garbage collected
+        private static readonly NotificationCallback _notificationCallback = OnNotification;
+
+        /// <summary>
+        /// Mirrors version 2 of `pv_speaker_config_t`. The library reads the fields a struct of that version has, so
+        /// the fields added by later versions do not need to be declared here.
+        /// </summary>
+        [StructLayout(LayoutKind.Sequential)]
+        private struct PvSpeakerConfig
+        {
+            public int Version;
+            public int SampleRate;
+            public short BitsPerSample;
+            public int DeviceIndex;
+            public int BufferSizeFrames;
+            public int BufferSizeMs;
+            public int PeriodSizeFrames;
+            public int PeriodSizeMs;
+            public int Periods;
+            [MarshalAs(UnmanagedType.U1)]
+            public bool IsLowLatency;
+            public int NumChannels;
+            [MarshalAs(UnmanagedType.U1)]
+            public bool IsFloat;
+        }
+
         static PvSpeaker()
         {
 
@@ -74,6 +107,9 @@ namespace Pv
         [DllImport(LIBRARY, CallingConvention = CallingConvention.Cdecl)]
         private static extern PvSpeakerStatus pv_speaker_init(int sampleRate, int bitsPerSample, int bufferSizeSecs, int deviceIndex, out IntPtr handle);
 
+        [DllImport(LIBRARY, CallingConvention = CallingConvention.Cdecl)]
+        private static extern PvSpeakerStatus pv_speaker_init_ex(ref PvSpeakerConfig config, out IntPtr handle);
+
         [DllImport(LIBRARY, CallingConvention = CallingConvention.Cdecl)]
         private static extern void pv_speaker_delete(IntPtr handle);
 
@@ -89,6 +125,15 @@ namespace Pv
         [DllImport(LIBRARY, CallingConvention = CallingConvention.Cdecl)]
         private static extern PvSpeakerStatus pv_speaker_flush(IntPtr handle, IntPtr pcm, int pcmLength, out int writtenLength);
 
+        [DllImport(LIBRARY, CallingConvention = CallingConvention.Cdecl)]
+        private static extern PvSpeakerStatus pv_speaker_notify_available(IntPtr handle, int length, NotificationCallback callback, IntPtr userData);
+
+        [DllImport(LIBRARY, CallingConvention = CallingConvention.Cdecl)]
+        private static extern PvSpeakerStatus pv_speaker_notify_drained(IntPtr handle, NotificationCallback callback, IntPtr userData);
+
+        [DllImport(LIBRARY, CallingConvention = CallingConvention.Cdecl)]
+        private static extern PvSpeakerStatus pv_speaker_cancel(IntPtr handle, int fadeMs, out int discardedLength);
+
         [DllImport(LIBRARY, CallingConvention = CallingConvention.Cdecl)]
         private static extern PvSpeakerStatus pv_speaker_write_to_file(IntPtr handle, IntPtr outputPath);
 
@@ -123,7 +168,11 @@ namespace Pv
         /// <param name="deviceIndex">
         /// The index of the audio device to play audio from. A value of (-1) will use the default audio device.
         /// </param>
-        public PvSpeaker(int sampleRate, int bitsPerSample, int bufferSizeSecs = 20, int deviceIndex = -1)
+        /// <param name="isFloat">
+        /// Whether samples are 32-bit IEEE floats instead of integers, e.g. to write a `ReadOnlySpan&lt;float&gt;`.
+        /// Requires `bitsPerSample` to be 32.
+        /// </param>
+        public PvSpeaker(int sampleRate, int bitsPerSample, int bufferSizeSecs = 20, int deviceIndex = -1, bool isFloat = false)
         {
             if (sampleRate <= 0)
             {
@@ -145,7 +194,36 @@ namespace Pv
                 throw new PvSpeakerInvalidArgumentException($"Device index of {deviceIndex} is invalid - must be greater than -1.");
             }
 
-            PvSpeakerStatus status = pv_speaker_init(sampleRate, bitsPerSample, bufferSizeSecs, deviceIndex, out _libraryPointer);
+            if (isFloat && bitsPerSample != 32)
+            {
+                throw new PvSpeakerInvalidArgumentException($"Bits per sample of {bitsPerSample} is invalid for float samples - must be 32.");
+            }
+
+            PvSpeakerStatus status;
+            if (isFloat)
+            {
+                if (bufferSizeSecs > int.MaxValue / sampleRate)
+                {
+                    throw new PvSpeakerInvalidArgumentException($"Buffer size (in seconds) of {bufferSizeSecs} is too large.");
+                }
+
+                var config = new PvSpeakerConfig
+                {
+                    Version = 2,
+                    SampleRate = sampleRate,
+                    BitsPerSample = (short)bitsPerSample,
+                    DeviceIndex = deviceIndex,
+                    BufferSizeFrames = bufferSizeSecs * sampleRate,
+                    IsLowLatency = true,
+                    NumChannels = 1,
+                    IsFloat = true
+                };
+                status = pv_speaker_init_ex(ref config, out _libraryPointer);
+            }
+            else
+            {
+                status = pv_speaker_init(sampleRate, bitsPerSample, bufferSizeSecs, deviceIndex, out _libraryPointer);
+            }
             if (status != PvSpeakerStatus.SUCCESS)
             {
                 throw PvSpeakerStatusToException(status, "Failed to initialize PvSpeaker.");
@@ -154,6 +232,7 @@ namespace Pv
             SampleRate = sampleRate;
             BitsPerSample = bitsPerSample;
             BufferSizeSecs = bufferSizeSecs;
+            IsFloat = isFloat;
             SelectedDevice = Marshal.PtrToStringAnsi(pv_speaker_get_selected_device(_libraryPointer));
             Version = Marshal.PtrToStringAnsi(pv_speaker_version());
         }
@@ -191,11 +270,23 @@ namespace Pv
         /// <returns>Number of samples that were successfully written.</returns>
         public int Write(byte[] pcm)
         {
-            GCHandle pinnedArray = GCHandle.Alloc(pcm, GCHandleType.Pinned);
-            IntPtr pcmPtr = pinnedArray.AddrOfPinnedObject();
+            return Write(new ReadOnlySpan<byte>(pcm));
+        }
 
-            PvSpeakerStatus status = pv_speaker_write(_libraryPointer, pcmPtr, pcm.Length / (BitsPerSample / 8), out int writtenLength);
-            pinnedArray.Free();
+        /// <summary>
+        /// Same as `Write(byte[])`, for PCM data in any memory, e.g. a slice of a pooled buffer. The data is pinned
+        /// for the duration of the call and passed to the library without a copy or a managed allocation.
+        /// </summary>
+        /// <param name="pcm">PCM data to be played, in the sample format of the speaker.</param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public unsafe int Write(ReadOnlySpan<byte> pcm)
+        {
+            PvSpeakerStatus status;
+            int writtenLength;
+            fixed (byte* pcmPtr = pcm)
+            {
+                status = pv_speaker_write(_libraryPointer, (IntPtr)pcmPtr, pcm.Length / (BitsPerSample / 8), out writtenLength);
+            }
             if (status != PvSpeakerStatus.SUCCESS)
             {
                 throw PvSpeakerStatusToException(status, "Failed to write to PvSpeaker.");
@@ -203,6 +294,16 @@ namespace Pv
             return writtenLength;
         }
 
+        /// <summary>
+        /// Same as `Write(ReadOnlySpan&lt;byte&gt;)`, for callers that cannot hold a span, e.g. async methods.
+        /// </summary>
+        /// <param name="pcm">PCM data to be played, in the sample format of the speaker.</param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public int Write(ReadOnlyMemory<byte> pcm)
+        {
+            return Write(pcm.Span);
+        }
+
         /// <summary>
         /// Synchronous call to write PCM data to the internal circular buffer for audio playback.
         /// This call blocks the thread until all PCM data has been successfully written and played.
@@ -212,12 +313,23 @@ namespace Pv
         /// <returns>Number of samples that were successfully written.</returns>
         public int Flush(byte[] pcm = null)
         {
-            pcm = pcm ?? Array.Empty<byte>();
-            GCHandle pinnedArray = GCHandle.Alloc(pcm, GCHandleType.Pinned);
-            IntPtr pcmPtr = pinnedArray.AddrOfPinnedObject();
+            return Flush(new ReadOnlySpan<byte>(pcm));
+        }
 
-            PvSpeakerStatus status = pv_speaker_flush(_libraryPointer, pcmPtr, pcm.Length / (BitsPerSample / 8), out int writtenLength);
-            pinnedArray.Free();
+        /// <summary>
+        /// Same as `Flush(byte[])`, for PCM data in any memory. The data is pinned for the duration of the call and
+        /// passed to the library without a copy or a managed allocation.
+        /// </summary>
+        /// <param name="pcm">PCM data to be played, in the sample format of the speaker.</param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public unsafe int Flush(ReadOnlySpan<byte> pcm)
+        {
+            PvSpeakerStatus status;
+            int writtenLength;
+            fixed (byte* pcmPtr = pcm)
+            {
+                status = pv_speaker_flush(_libraryPointer, (IntPtr)pcmPtr, pcm.Length / (BitsPerSample / 8), out writtenLength);
+            }
             if (status != PvSpeakerStatus.SUCCESS)
             {
                 throw PvSpeakerStatusToException(status, "Failed to flush PCM data from PvSpeaker.");
@@ -225,6 +337,164 @@ namespace Pv
             return writtenLength;
         }
 
+        /// <summary>
+        /// Same as `Flush(ReadOnlySpan&lt;byte&gt;)`, for callers that cannot hold a span.
+        /// </summary>
+        /// <param name="pcm">PCM data to be played, in the sample format of the speaker.</param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public int Flush(ReadOnlyMemory<byte> pcm)
+        {
+            return Flush(pcm.Span);
+        }
+
+        /// <summary>
+        /// Asynchronous call to write PCM data to the internal circular buffer for audio playback. Unlike `Write()`, it
+        /// writes all of the PCM data, and waits for the device to play enough of the buffered audio whenever the
+        /// internal circular buffer is full. No thread is blocked while waiting. Call between `Start()` and `Stop()`,
+        /// and only make one asynchronous call at a time.
+        /// </summary>
+        /// <param name="pcm">PCM data to be played, in the sample format of the speaker.</param>
+        /// <param name="cancellationToken">
+        /// Token that cancels the call. Cancelling fades out and discards all buffered audio, like the playback had
+        /// been interrupted, and throws an `OperationCanceledException`.
+        /// </param>
+        /// <returns>
+        /// Number of samples that were successfully written. It is less than the length of `pcm` only if the speaker
+        /// was stopped meanwhile.
+        /// </returns>
+        public ValueTask<int> WriteAsync(ReadOnlyMemory<byte> pcm, CancellationToken cancellationToken = default)
+        {
+            int bytesPerSample = BitsPerSample / 8;
+            return WriteAsyncCore(
+                pcm.Length / bytesPerSample,
+                offset => Write(pcm.Slice(offset * bytesPerSample)),
+                cancellationToken);
+        }
+
+        /// <summary>
+        /// Asynchronous version of `Flush()`. Writes all of the PCM data like `WriteAsync()`, then waits for all
+        /// buffered audio to be played without blocking a thread. Call between `Start()` and `Stop()`, and only make one
+        /// asynchronous call at a time.
+        /// </summary>
+        /// <param name="pcm">PCM data to be played, in the sample format of the speaker.</param>
+        /// <param name="cancellationToken">
+        /// Token that cancels the call. Cancelling fades out and discards all buffered audio, and throws an
+        /// `OperationCanceledException`.
+        /// </param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public async Task<int> FlushAsync(ReadOnlyMemory<byte> pcm = default, CancellationToken cancellationToken = default)
+        {
+            int writtenLength = await WriteAsync(pcm, cancellationToken).ConfigureAwait(false);
+            await DrainAsync(cancellationToken).ConfigureAwait(false);
+            return writtenLength;
+        }
+
+        /// <summary>
+        /// Writes `length` samples with `write`, which takes the offset of the first sample to write and returns the
+        /// number of samples it wrote, and waits for room in between.
+        /// </summary>
+        internal async ValueTask<int> WriteAsyncCore(int length, Func<int, int> write, CancellationToken cancellationToken)
+        {
+            cancellationToken.ThrowIfCancellationRequested();
+
+            if (length == 0)
+            {
+                return 0;
+            }
+
+            int writtenLength = write(0);
+            if (writtenLength == length)
+            {
+                return writtenLength;
+            }
+
+            // waiting for half of the buffer keeps the number of wake-ups low while the device still has audio queued
+            int capacity = SampleRate * BufferSizeSecs;
+            using (cancellationToken.Register(CancelPlayback))
+            {
+                while (writtenLength < length)
+                {
+                    await WaitForNotificationAsync(Math.Min(length - writtenLength, Math.Max(capacity / 2, 1))).ConfigureAwait(false);
+                    cancellationToken.ThrowIfCancellationRequested();
+                    if (!IsStarted)
+                    {
+                        break;
+                    }
+
+                    writtenLength += write(writtenLength);
+                }
+            }
+            return writtenLength;
+        }
+
+        internal async Task DrainAsync(CancellationToken cancellationToken)
+        {
+            cancellationToken.ThrowIfCancellationRequested();
+
+            if (!IsStarted)
+            {
+                return;
+            }
+
+            using (cancellationToken.Register(CancelPlayback))
+            {
+                await WaitForNotificationAsync(0).ConfigureAwait(false);
+                cancellationToken.ThrowIfCancellationRequested();
+            }
+        }
+
+        /// <summary>
+        /// Returns a task that completes once the internal circular buffer has room for `length` samples, or once it
+        /// is drained if `length` is 0. The task also completes when the speaker is stopped, disposed or cancelled.
+        /// </summary>
+        private Task WaitForNotificationAsync(int length)
+        {
+            var completionSource = new TaskCompletionSource<bool>(TaskCreationOptions.RunContinuationsAsynchronously);
+            GCHandle handle = GCHandle.Alloc(completionSource);
+
+            PvSpeakerStatus status = (length > 0) ?
+                pv_speaker_notify_available(_libraryPointer, length, _notificationCallback, GCHandle.ToIntPtr(handle)) :
+                pv_speaker_notify_drained(_libraryPointer, _notificationCallback, GCHandle.ToIntPtr(handle));
+            if (status != PvSpeakerStatus.SUCCESS)
+            {
+                handle.Free();
+                throw PvSpeakerStatusToException(status, "Failed to wait for PvSpeaker.");
+            }
+            return completionSource.Task;
+        }
+
+        private static void OnNotification(IntPtr userData)
+        {
+            GCHandle handle = GCHandle.FromIntPtr(userData);
+            var completionSource = (TaskCompletionSource<bool>)handle.Target;
+            handle.Free();
+            completionSource.TrySetResult(true);
+        }
+
+        /// <summary>
+        /// Fades out and drops the buffered audio. The library then ends pending waits within one device period.
+        /// </summary>
+        private void CancelPlayback()
+        {
+            IntPtr libraryPointer = _libraryPointer;
+            if (libraryPointer != IntPtr.Zero)
+            {
+                // fails only if the speaker was stopped meanwhile, which ends the waits as well, or if the device
+                // stalled, in which case the pending waits are ended all the same
+                pv_speaker_cancel(libraryPointer, CANCEL_FADE_MS, out _);
+            }
+        }
+
+        internal void CheckSampleFormat(int bitsPerSample, bool isFloat)
+        {
+            if (BitsPerSample != bitsPerSample || IsFloat != isFloat)
+            {
+                string sampleFormat = IsFloat ? "float" : "integer";
+                throw new PvSpeakerInvalidArgumentException(
+                    $"PCM data does not match the {BitsPerSample}-bit {sampleFormat} samples of PvSpeaker.");
+            }
+        }
+
         /// <summary>
         /// Writes PCM data passed to PvSpeaker to a specified WAV file.
         /// </summary>
@@ -282,6 +552,14 @@ namespace Pv
             get; private set;
         }
 
+        /// <summary>
+        /// Gets whether samples are 32-bit IEEE floats, matching the value passed to the constructor.
+        /// </summary>
+        public bool IsFloat
+        {
+            get; private set;
+        }
+
         /// <summary>
         /// Gets the current selected audio device.
         /// </summary>
@@ -347,6 +625,8 @@ namespace Pv
                     return new PvSpeakerIOException(message);
                 case PvSpeakerStatus.RUNTIME_ERROR:
                     return new PvSpeakerRuntimeException(message ?? "PvSpeaker runtime error.");
+                case PvSpeakerStatus.TIMEOUT:
+                    return new PvSpeakerTimeoutException(message ?? "PvSpeaker timed out.");
                 default:
                     return new PvSpeakerException("Unknown status returned from PvSpeaker.");
             }
@@ -77,4 +77,11 @@ namespace Pv
 
         public PvSpeakerRuntimeException(string message) : base(message) { }
     }
+
+    public class PvSpeakerTimeoutException : PvSpeakerException
+    {
+        public PvSpeakerTimeoutException() { }
+
+        public PvSpeakerTimeoutException(string message) : base(message) { }
+    }
 }
\ No newline at end of file
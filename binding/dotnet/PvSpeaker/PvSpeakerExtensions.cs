@@ -0,0 +1,218 @@
+﻿/*
+    Copyright 2024 Picovoice Inc.
+
+    You may not use this file except in compliance with the license. A copy of the license is located in the "LICENSE"
+    file accompanying this source.
+
+    Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on
+    an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the
+    specific language governing permissions and limitations under the License.
+*/
+
+using System;
+using System.Runtime.InteropServices;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace Pv
+{
+    /// <summary>
+    /// Overloads of the `PvSpeaker` write methods for 16-bit and 32-bit float samples. They are extension methods so
+    /// that the compiler only considers them when no `byte` overload of `PvSpeaker` applies. A `null` argument, as in
+    /// `speaker.Flush(null)`, thus still binds to the `byte[]` overload instead of being ambiguous.
+    /// </summary>
+    public static class PvSpeakerExtensions
+    {
+        /// <summary>
+        /// Same as `PvSpeaker.Write(byte[])`, for 16-bit samples.
+        /// </summary>
+        /// <param name="speaker">PvSpeaker instance.</param>
+        /// <param name="pcm">PCM data to be played.</param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public static int Write(this PvSpeaker speaker, short[] pcm)
+        {
+            return speaker.Write(new ReadOnlySpan<short>(pcm));
+        }
+
+        /// <summary>
+        /// Same as `PvSpeaker.Write(ReadOnlySpan&lt;byte&gt;)`, for 16-bit samples.
+        /// </summary>
+        /// <param name="speaker">PvSpeaker instance.</param>
+        /// <param name="pcm">PCM data to be played.</param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public static int Write(this PvSpeaker speaker, ReadOnlySpan<short> pcm)
+        {
+            speaker.CheckSampleFormat(16, false);
+            return speaker.Write(MemoryMarshal.AsBytes(pcm));
+        }
+
+        /// <summary>
+        /// Same as `Write(ReadOnlySpan&lt;short&gt;)`, for callers that cannot hold a span, e.g. async methods.
+        /// </summary>
+        /// <param name="speaker">PvSpeaker instance.</param>
+        /// <param name="pcm">PCM data to be played.</param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public static int Write(this PvSpeaker speaker, ReadOnlyMemory<short> pcm)
+        {
+            return speaker.Write(pcm.Span);
+        }
+
+        /// <summary>
+        /// Same as `PvSpeaker.Flush(byte[])`, for 16-bit samples.
+        /// </summary>
+        /// <param name="speaker">PvSpeaker instance.</param>
+        /// <param name="pcm">PCM data to be played.</param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public static int Flush(this PvSpeaker speaker, short[] pcm)
+        {
+            return speaker.Flush(new ReadOnlySpan<short>(pcm));
+        }
+
+        /// <summary>
+        /// Same as `PvSpeaker.Flush(ReadOnlySpan&lt;byte&gt;)`, for 16-bit samples.
+        /// </summary>
+        /// <param name="speaker">PvSpeaker instance.</param>
+        /// <param name="pcm">PCM data to be played.</param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public static int Flush(this PvSpeaker speaker, ReadOnlySpan<short> pcm)
+        {
+            speaker.CheckSampleFormat(16, false);
+            return speaker.Flush(MemoryMarshal.AsBytes(pcm));
+        }
+
+        /// <summary>
+        /// Same as `Flush(ReadOnlySpan&lt;short&gt;)`, for callers that cannot hold a span.
+        /// </summary>
+        /// <param name="speaker">PvSpeaker instance.</param>
+        /// <param name="pcm">PCM data to be played.</param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public static int Flush(this PvSpeaker speaker, ReadOnlyMemory<short> pcm)
+        {
+            return speaker.Flush(pcm.Span);
+        }
+
+        /// <summary>
+        /// Same as `PvSpeaker.WriteAsync(ReadOnlyMemory&lt;byte&gt;, CancellationToken)`, for 16-bit samples.
+        /// </summary>
+        /// <param name="speaker">PvSpeaker instance.</param>
+        /// <param name="pcm">PCM data to be played.</param>
+        /// <param name="cancellationToken">Token that cancels the call and the buffered audio.</param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public static ValueTask<int> WriteAsync(this PvSpeaker speaker, ReadOnlyMemory<short> pcm, CancellationToken cancellationToken = default)
+        {
+            speaker.CheckSampleFormat(16, false);
+            return speaker.WriteAsyncCore(pcm.Length, offset => speaker.Write(pcm.Slice(offset)), cancellationToken);
+        }
+
+        /// <summary>
+        /// Same as `PvSpeaker.FlushAsync(ReadOnlyMemory&lt;byte&gt;, CancellationToken)`, for 16-bit samples.
+        /// </summary>
+        /// <param name="speaker">PvSpeaker instance.</param>
+        /// <param name="pcm">PCM data to be played.</param>
+        /// <param name="cancellationToken">Token that cancels the call and the buffered audio.</param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public static async Task<int> FlushAsync(this PvSpeaker speaker, ReadOnlyMemory<short> pcm, CancellationToken cancellationToken = default)
+        {
+            int writtenLength = await speaker.WriteAsync(pcm, cancellationToken).ConfigureAwait(false);
+            await speaker.DrainAsync(cancellationToken).ConfigureAwait(false);
+            return writtenLength;
+        }
+
+        /// <summary>
+        /// Same as `PvSpeaker.Write(byte[])`, for 32-bit float samples.
+        /// </summary>
+        /// <param name="speaker">PvSpeaker instance.</param>
+        /// <param name="pcm">PCM data to be played.</param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public static int Write(this PvSpeaker speaker, float[] pcm)
+        {
+            return speaker.Write(new ReadOnlySpan<float>(pcm));
+        }
+
+        /// <summary>
+        /// Same as `PvSpeaker.Write(ReadOnlySpan&lt;byte&gt;)`, for 32-bit float samples. The speaker has to be
+        /// created with `isFloat` set.
+        /// </summary>
+        /// <param name="speaker">PvSpeaker instance.</param>
+        /// <param name="pcm">PCM data to be played.</param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public static int Write(this PvSpeaker speaker, ReadOnlySpan<float> pcm)
+        {
+            speaker.CheckSampleFormat(32, true);
+            return speaker.Write(MemoryMarshal.AsBytes(pcm));
+        }
+
+        /// <summary>
+        /// Same as `Write(ReadOnlySpan&lt;float&gt;)`, for callers that cannot hold a span, e.g. async methods.
+        /// </summary>
+        /// <param name="speaker">PvSpeaker instance.</param>
+        /// <param name="pcm">PCM data to be played.</param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public static int Write(this PvSpeaker speaker, ReadOnlyMemory<float> pcm)
+        {
+            return speaker.Write(pcm.Span);
+        }
+
+        /// <summary>
+        /// Same as `PvSpeaker.Flush(byte[])`, for 32-bit float samples.
+        /// </summary>
+        /// <param name="speaker">PvSpeaker instance.</param>
+        /// <param name="pcm">PCM data to be played.</param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public static int Flush(this PvSpeaker speaker, float[] pcm)
+        {
+            return speaker.Flush(new ReadOnlySpan<float>(pcm));
+        }
+
+        /// <summary>
+        /// Same as `PvSpeaker.Flush(ReadOnlySpan&lt;byte&gt;)`, for 32-bit float samples. The speaker has to be
+        /// created with `isFloat` set.
+        /// </summary>
+        /// <param name="speaker">PvSpeaker instance.</param>
+        /// <param name="pcm">PCM data to be played.</param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public static int Flush(this PvSpeaker speaker, ReadOnlySpan<float> pcm)
+        {
+            speaker.CheckSampleFormat(32, true);
+            return speaker.Flush(MemoryMarshal.AsBytes(pcm));
+        }
+
+        /// <summary>
+        /// Same as `Flush(ReadOnlySpan&lt;float&gt;)`, for callers that cannot hold a span.
+        /// </summary>
+        /// <param name="speaker">PvSpeaker instance.</param>
+        /// <param name="pcm">PCM data to be played.</param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public static int Flush(this PvSpeaker speaker, ReadOnlyMemory<float> pcm)
+        {
+            return speaker.Flush(pcm.Span);
+        }
+
+        /// <summary>
+        /// Same as `PvSpeaker.WriteAsync(ReadOnlyMemory&lt;byte&gt;, CancellationToken)`, for 32-bit float samples.
+        /// </summary>
+        /// <param name="speaker">PvSpeaker instance.</param>
+        /// <param name="pcm">PCM data to be played.</param>
+        /// <param name="cancellationToken">Token that cancels the call and the buffered audio.</param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public static ValueTask<int> WriteAsync(this PvSpeaker speaker, ReadOnlyMemory<float> pcm, CancellationToken cancellationToken = default)
+        {
+            speaker.CheckSampleFormat(32, true);
+            return speaker.WriteAsyncCore(pcm.Length, offset => speaker.Write(pcm.Slice(offset)), cancellationToken);
+        }
+
+        /// <summary>
+        /// Same as `PvSpeaker.FlushAsync(ReadOnlyMemory&lt;byte&gt;, CancellationToken)`, for 32-bit float samples.
+        /// </summary>
+        /// <param name="speaker">PvSpeaker instance.</param>
+        /// <param name="pcm">PCM data to be played.</param>
+        /// <param name="cancellationToken">Token that cancels the call and the buffered audio.</param>
+        /// <returns>Number of samples that were successfully written.</returns>
+        public static async Task<int> FlushAsync(this PvSpeaker speaker, ReadOnlyMemory<float> pcm, CancellationToken cancellationToken = default)
+        {
+            int writtenLength = await speaker.WriteAsync(pcm, cancellationToken).ConfigureAwait(false);
+            await speaker.DrainAsync(cancellationToken).ConfigureAwait(false);
+            return writtenLength;
+        }
+    }
+}
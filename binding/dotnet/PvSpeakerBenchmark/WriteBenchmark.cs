@@ -0,0 +1,83 @@
+/*
+    Copyright 2024 Picovoice Inc.
+
+    You may not use this file except in compliance with the license. A copy of the license is located in the "LICENSE"
+    file accompanying this source.
+
+    Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on
+    an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the
+    specific language governing permissions and limitations under the License.
+*/
+
+using System;
+
+using BenchmarkDotNet.Attributes;
+using BenchmarkDotNet.Running;
+
+using Pv;
+
+namespace PvSpeakerBenchmark
+{
+    /// <summary>
+    /// Measures the time and the managed allocations of a single write of a 10 ms frame. The speaker is never
+    /// drained, so after the first writes every call returns without copying; what is left is the cost of the call.
+    /// </summary>
+    [MemoryDiagnoser]
+    public class WriteBenchmark
+    {
+        private const int SAMPLE_RATE = 16000;
+        private const int FRAME_LENGTH = SAMPLE_RATE / 100;
+
+        private PvSpeaker _speaker;
+        private short[] _pcm;
+        private byte[] _pcmBytes;
+
+        [GlobalSetup]
+        public void Setup()
+        {
+            _speaker = new PvSpeaker(SAMPLE_RATE, 16, bufferSizeSecs: 1);
+            _speaker.Start();
+            _pcm = new short[FRAME_LENGTH * 2];
+            _pcmBytes = new byte[FRAME_LENGTH * 2];
+        }
+
+        [GlobalCleanup]
+        public void Cleanup()
+        {
+            _speaker.Stop();
+            _speaker.Dispose();
+        }
+
+        [Benchmark(Baseline = true)]
+        public int WriteByteArray()
+        {
+            return _speaker.Write(_pcmBytes);
+        }
+
+        [Benchmark]
+        public int WriteByteSpan()
+        {
+            return _speaker.Write(_pcmBytes.AsSpan());
+        }
+
+        [Benchmark]
+        public int WriteShortSpanSlice()
+        {
+            return _speaker.Write(_pcm.AsSpan(FRAME_LENGTH / 2, FRAME_LENGTH));
+        }
+
+        [Benchmark]
+        public int WriteShortMemorySlice()
+        {
+            return _speaker.Write(new ReadOnlyMemory<short>(_pcm, FRAME_LENGTH / 2, FRAME_LENGTH));
+        }
+    }
+
+    public class Program
+    {
+        public static void Main(string[] args)
+        {
+            BenchmarkSwitcher.FromAssembly(typeof(Program).Assembly).Run(args);
+        }
+    }
+}
@@ -9,7 +9,10 @@
     specific language governing permissions and limitations under the License.
 */
 
+using System;
 using System.IO;
+using System.Threading;
+using System.Threading.Tasks;
 
 using Microsoft.VisualStudio.TestTools.UnitTesting;
 
@@ -92,6 +95,102 @@ namespace PvSpeakerTest
             }
         }
 
+        [TestMethod]
+        public void TestWriteSpan()
+        {
+            using (var speaker = new PvSpeaker(SAMPLE_RATE, BITS_PER_SAMPLE, BUFFER_SIZE_SECS, deviceIndex: 0))
+            {
+                speaker.Start();
+
+                short[] pcm = new short[SAMPLE_RATE / 10];
+                byte[] pcmBytes = new byte[pcm.Length * 2];
+
+                Assert.AreEqual(speaker.Write(pcm.AsSpan(0, 100)), 100);
+                Assert.AreEqual(speaker.Write(new ReadOnlyMemory<short>(pcm, 100, 100)), 100);
+                Assert.AreEqual(speaker.Write(pcmBytes.AsSpan(0, 200)), 100);
+                Assert.AreEqual(speaker.Write(new ReadOnlyMemory<byte>(pcmBytes, 200, 200)), 100);
+                Assert.AreEqual(speaker.Flush(pcm.AsSpan(200)), pcm.Length - 200);
+                // a null argument binds to the byte[] overload, as before the typed overloads were added
+                Assert.AreEqual(speaker.Flush(null), 0);
+
+                Assert.ThrowsException<PvSpeakerInvalidArgumentException>(() => speaker.Write(new float[100]));
+
+                // spans are pinned in place, so writing them does not allocate
+                ReadOnlyMemory<short> memory = pcm;
+                speaker.Write(memory);
+                long allocatedBytes = GC.GetAllocatedBytesForCurrentThread();
+                for (int i = 0; i < 100; i++)
+                {
+                    speaker.Write(pcm.AsSpan(0, 10));
+                    speaker.Write(memory);
+                }
+                Assert.AreEqual(GC.GetAllocatedBytesForCurrentThread() - allocatedBytes, 0);
+
+                speaker.Stop();
+            }
+        }
+
+        [TestMethod]
+        public async Task TestWriteAsync()
+        {
+            using (var speaker = new PvSpeaker(SAMPLE_RATE, BITS_PER_SAMPLE, BUFFER_SIZE_SECS, deviceIndex: 0))
+            {
+                speaker.Start();
+
+                // more than the internal buffer holds, so that the call has to wait for room
+                short[] pcm = new short[SAMPLE_RATE * BUFFER_SIZE_SECS * 2];
+                Assert.AreEqual(await speaker.WriteAsync(pcm), pcm.Length);
+                Assert.AreEqual(await speaker.FlushAsync(new byte[200]), 100);
+                Assert.AreEqual(await speaker.FlushAsync(), 0);
+
+                speaker.Stop();
+            }
+        }
+
+        [TestMethod]
+        public async Task TestFlushAsyncCancel()
+        {
+            using (var speaker = new PvSpeaker(SAMPLE_RATE, BITS_PER_SAMPLE, BUFFER_SIZE_SECS, deviceIndex: 0))
+            {
+                speaker.Start();
+
+                short[] pcm = new short[SAMPLE_RATE * BUFFER_SIZE_SECS * 2];
+                using (var cancellationTokenSource = new CancellationTokenSource(100))
+                {
+                    await Assert.ThrowsExceptionAsync<OperationCanceledException>(
+                        () => speaker.FlushAsync(pcm, cancellationTokenSource.Token));
+                }
+
+                // cancelling discarded the buffered audio, so the speaker is ready for the next utterance
+                Assert.AreEqual(speaker.Write(pcm), SAMPLE_RATE * BUFFER_SIZE_SECS);
+
+                Task<int> writeTask = speaker.WriteAsync(pcm).AsTask();
+                speaker.Stop();
+                Assert.IsTrue(await writeTask < pcm.Length);
+            }
+        }
+
+        [TestMethod]
+        public void TestWriteFloat()
+        {
+            Assert.ThrowsException<PvSpeakerInvalidArgumentException>(
+                () => new PvSpeaker(SAMPLE_RATE, BITS_PER_SAMPLE, BUFFER_SIZE_SECS, deviceIndex: 0, isFloat: true));
+
+            using (var speaker = new PvSpeaker(SAMPLE_RATE, 32, BUFFER_SIZE_SECS, deviceIndex: 0, isFloat: true))
+            {
+                Assert.IsTrue(speaker.IsFloat);
+                speaker.Start();
+
+                float[] pcm = new float[SAMPLE_RATE / 10];
+                Assert.AreEqual(speaker.Write(pcm.AsSpan(0, 100)), 100);
+                Assert.AreEqual(speaker.Flush(new ReadOnlyMemory<float>(pcm, 100, 100)), 100);
+
+                Assert.ThrowsException<PvSpeakerInvalidArgumentException>(() => speaker.Write(new short[100]));
+
+                speaker.Stop();
+            }
+        }
+
         [TestMethod]
         public void TestGetAudioDevices()
         {
@@ -20,6 +20,7 @@ class PvSpeakerStatusDeviceAlreadyInitializedError extends Error {}
 class PvSpeakerStatusDeviceNotInitializedError extends Error {}
 class PvSpeakerStatusIOError extends Error {}
 class PvSpeakerStatusRuntimeError extends Error {}
+class PvSpeakerStatusTimeoutError extends Error {}
 
 function pvSpeakerStatusToException(status: PvSpeakerStatus, errorMessage: string): Error {
   switch (status) {
@@ -39,6 +40,8 @@ function pvSpeakerStatusToException(status: PvSpeakerStatus, errorMessage: strin
       return new PvSpeakerStatusIOError(errorMessage);
     case PvSpeakerStatus.RUNTIME_ERROR:
       return new PvSpeakerStatusRuntimeError(errorMessage);
+    case PvSpeakerStatus.TIMEOUT:
+      return new PvSpeakerStatusTimeoutError(errorMessage);
     default:
       // eslint-disable-next-line
       console.warn(`Unknown error code: ${status}`);
@@ -11,5 +11,7 @@
 "use strict";
 
 import PvSpeaker from "./pv_speaker";
+import PvSpeakerSharedRing from "./pv_speaker_shared_ring";
+import PvSpeakerWritable from "./pv_speaker_writable";
 
-export { PvSpeaker };
+export { PvSpeaker, PvSpeakerSharedRing, PvSpeakerWritable };
@@ -16,6 +16,7 @@ import * as path from "path";
 
 import PvSpeakerStatus from "./pv_speaker_status_t";
 import pvSpeakerStatusToException from "./errors";
+import { PV_SPEAKER_SHARED_BUFFER_HEADER_SIZE } from "./pv_speaker_shared_ring";
 
 /**
  * PvSpeaker class for playing audio.
@@ -29,6 +30,8 @@ class PvSpeaker {
   private readonly _bitsPerSample: number;
   private readonly _bufferSizeSecs: number;
   private readonly _version: string;
+  private _numPendingCalls = 0;
+  private _sharedBuffer: SharedArrayBuffer | null = null;
 
   /**
    * PvSpeaker constructor.
@@ -154,6 +157,65 @@ class PvSpeaker {
     return result.written_length;
   }
 
+  /**
+   * Asynchronous call to write PCM data to the internal circular buffer for audio playback.
+   * Waits on a worker thread until the internal circular buffer has room for all of the PCM data, so awaiting it
+   * applies backpressure without blocking the event loop. Resolves early if the speaker is stopped.
+   *
+   * @param {ArrayBuffer} pcm PCM data to be played.
+   * @returns {Promise<number>} Length of the PCM data that was successfully written. 0 if `pcm` holds no samples.
+   */
+  public async writeAsync(pcm: ArrayBuffer): Promise<number> {
+    if (pcm.byteLength < this._bitsPerSample / 8) {
+      return 0;
+    }
+
+    return this._callAsync(PvSpeaker._pvSpeaker.write_async, pcm, "Failed to write to device.");
+  }
+
+  /**
+   * Asynchronous version of `flush()`. Waits on a worker thread until all PCM data has been written and played, so
+   * the event loop keeps running in the meantime.
+   *
+   * @param {ArrayBuffer} pcm PCM data to be played.
+   * @returns {Promise<number>} The length of the PCM data that was successfully written.
+   */
+  public async flushAsync(pcm: ArrayBuffer = new ArrayBuffer(0)): Promise<number> {
+    return this._callAsync(PvSpeaker._pvSpeaker.flush_async, pcm, "Failed to flush PCM data.");
+  }
+
+  /**
+   * Replaces the internal circular buffer with a `SharedArrayBuffer` that worker threads can write PCM data into
+   * directly through `PvSpeakerSharedRing`, without a round trip through the main thread. The buffer starts with a
+   * header holding the write and read indices, followed by `sampleRate` * `bufferSizeSecs` samples. Must be called
+   * before `start()`. The worker is then the only source of PCM data: `write()`, `writeAsync()`, and `flush()` or
+   * `flushAsync()` with PCM data throw. Without arguments, `flush()` and `flushAsync()` wait for the shared buffer to
+   * be played.
+   *
+   * @returns {SharedArrayBuffer} The shared buffer. Pass it to a worker thread with `postMessage()`.
+   */
+  public createSharedBuffer(): SharedArrayBuffer {
+    if (this._sharedBuffer !== null) {
+      return this._sharedBuffer;
+    }
+
+    const capacity = Math.floor(this._sampleRate * this._bufferSizeSecs);
+    const sharedBuffer = new SharedArrayBuffer(
+      PV_SPEAKER_SHARED_BUFFER_HEADER_SIZE + (capacity * this._bitsPerSample / 8)
+    );
+    const status = PvSpeaker._pvSpeaker.set_shared_buffer(
+      this._handle,
+      this._bitsPerSample,
+      new Uint8Array(sharedBuffer)
+    );
+    if (status !== PvSpeakerStatus.SUCCESS) {
+      throw pvSpeakerStatusToException(status, "Failed to set shared buffer.");
+    }
+
+    this._sharedBuffer = sharedBuffer;
+    return sharedBuffer;
+  }
+
   /**
    * Writes PCM data passed to PvSpeaker to a specified WAV file.
    *
@@ -183,6 +245,12 @@ class PvSpeaker {
    * Destructor. Releases resources acquired by PvSpeaker.
    */
   public release(): void {
+    if (this._numPendingCalls > 0) {
+      throw pvSpeakerStatusToException(
+        PvSpeakerStatus.INVALID_STATE,
+        "Wait for pending `writeAsync()` and `flushAsync()` calls before releasing."
+      );
+    }
     PvSpeaker._pvSpeaker.delete(this._handle);
   }
 
@@ -199,6 +267,27 @@ class PvSpeaker {
     return devices;
   }
 
+  private async _callAsync(
+    func: (handle: number, bitsPerSample: number, pcm: ArrayBuffer) => Promise<any>,
+    pcm: ArrayBuffer,
+    errorMessage: string
+  ): Promise<number> {
+    let result;
+    this._numPendingCalls++;
+    try {
+      result = await func(this._handle, this._bitsPerSample, pcm);
+    } catch (err: any) {
+      throw pvSpeakerStatusToException(err.code, err);
+    } finally {
+      this._numPendingCalls--;
+    }
+    if (result.status !== PvSpeakerStatus.SUCCESS) {
+      throw pvSpeakerStatusToException(result.status, errorMessage);
+    }
+
+    return result.written_length;
+  }
+
   private static _getLibraryPath(): string {
     let scriptPath;
     if (os.platform() === "win32") {
@@ -0,0 +1,107 @@
+//
+// Copyright 2024 Picovoice Inc.
+//
+// You may not use this file except in compliance with the license. A copy of the license is located in the "LICENSE"
+// file accompanying this source.
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on
+// an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+//
+"use strict";
+
+// Layout of the header of the shared buffer. Matches `PV_SPEAKER_SHARED_BUFFER_*` in `pv_speaker.h`.
+export const PV_SPEAKER_SHARED_BUFFER_HEADER_SIZE = 128;
+const WRITE_INDEX = 0;
+const READ_INDEX = 16;
+
+/**
+ * Writer side of the `SharedArrayBuffer` returned by `PvSpeaker.createSharedBuffer()`. It does not load the native
+ * library, so it can be constructed inside a worker thread that received the buffer through `postMessage()`.
+ * Only one writer may use a given buffer at a time.
+ */
+class PvSpeakerSharedRing {
+  private readonly _indices: Int32Array;
+  private readonly _data: Uint8Array;
+  private readonly _bytesPerSample: number;
+  private readonly _capacity: number;
+
+  /**
+   * PvSpeakerSharedRing constructor.
+   *
+   * @param sharedBuffer The buffer returned by `PvSpeaker.createSharedBuffer()`.
+   * @param bitsPerSample The number of bits per sample of the PvSpeaker instance that created the buffer.
+   */
+  constructor(sharedBuffer: SharedArrayBuffer, bitsPerSample: number) {
+    if (
+      !(sharedBuffer instanceof SharedArrayBuffer) ||
+      (sharedBuffer.byteLength <= PV_SPEAKER_SHARED_BUFFER_HEADER_SIZE)
+    ) {
+      throw new Error("Invalid shared buffer.");
+    }
+    if ((bitsPerSample <= 0) || ((bitsPerSample % 8) !== 0)) {
+      throw new Error("Invalid bits per sample.");
+    }
+
+    this._indices = new Int32Array(sharedBuffer, 0, PV_SPEAKER_SHARED_BUFFER_HEADER_SIZE / 4);
+    this._data = new Uint8Array(sharedBuffer, PV_SPEAKER_SHARED_BUFFER_HEADER_SIZE);
+    this._bytesPerSample = bitsPerSample / 8;
+    this._capacity = Math.min(Math.floor(this._data.byteLength / this._bytesPerSample), 0x3fffffff);
+  }
+
+  /**
+   * @returns {number} The number of samples the shared buffer holds.
+   */
+  get capacity(): number {
+    return this._capacity;
+  }
+
+  /**
+   * @returns {number} The number of samples that can currently be written without overwriting unplayed audio.
+   */
+  get available(): number {
+    const writeIndex = Atomics.load(this._indices, WRITE_INDEX);
+    const readIndex = Atomics.load(this._indices, READ_INDEX);
+    return this._capacity - this._count(writeIndex, readIndex);
+  }
+
+  /**
+   * Writes as much PCM data as currently fits into the shared buffer. The audio thread picks it up without any call
+   * into the native library.
+   *
+   * @param {ArrayBuffer | ArrayBufferView} pcm PCM data to be played.
+   * @returns {number} Length of the PCM data, in samples, that was successfully written.
+   */
+  public write(pcm: ArrayBuffer | ArrayBufferView): number {
+    const bytes = ArrayBuffer.isView(pcm) ?
+      new Uint8Array(pcm.buffer, pcm.byteOffset, pcm.byteLength) :
+      new Uint8Array(pcm);
+
+    // only this writer moves the write index, while the read index may move at any time
+    const writeIndex = Atomics.load(this._indices, WRITE_INDEX);
+    const readIndex = Atomics.load(this._indices, READ_INDEX);
+    const available = this._capacity - this._count(writeIndex, readIndex);
+    const length = Math.min(Math.floor(bytes.byteLength / this._bytesPerSample), available);
+    if (length === 0) {
+      return 0;
+    }
+
+    const start = writeIndex % this._capacity;
+    const first = Math.min(length, this._capacity - start);
+    this._data.set(bytes.subarray(0, first * this._bytesPerSample), start * this._bytesPerSample);
+    if (first < length) {
+      this._data.set(bytes.subarray(first * this._bytesPerSample, length * this._bytesPerSample), 0);
+    }
+
+    // publishes the samples copied above to the audio thread
+    Atomics.store(this._indices, WRITE_INDEX, (writeIndex + length) % (2 * this._capacity));
+
+    return length;
+  }
+
+  private _count(writeIndex: number, readIndex: number): number {
+    return (writeIndex - readIndex + (2 * this._capacity)) % (2 * this._capacity);
+  }
+}
+
+export default PvSpeakerSharedRing;
@@ -20,6 +20,7 @@ enum PvSpeakerStatus {
   DEVICE_NOT_INITIALIZED,
   IO_ERROR,
   RUNTIME_ERROR,
+  TIMEOUT,
 }
 
 export default PvSpeakerStatus;
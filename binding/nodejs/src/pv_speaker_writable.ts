@@ -0,0 +1,68 @@
+//
+// Copyright 2024 Picovoice Inc.
+//
+// You may not use this file except in compliance with the license. A copy of the license is located in the "LICENSE"
+// file accompanying this source.
+//
+// Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on
+// an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+//
+"use strict";
+
+import { Writable, WritableOptions } from "stream";
+
+import PvSpeaker from "./pv_speaker";
+
+/**
+ * Writable stream that plays the PCM data piped into it on a started PvSpeaker instance.
+ * Each chunk is only acknowledged once it fits into the internal circular buffer, so the stream applies backpressure
+ * to its source. Ending the stream waits for the buffered audio to finish playing.
+ */
+class PvSpeakerWritable extends Writable {
+  private readonly _speaker: PvSpeaker;
+  private readonly _bytesPerSample: number;
+  private _remainder: Buffer = Buffer.alloc(0);
+
+  /**
+   * PvSpeakerWritable constructor.
+   *
+   * @param speaker A started PvSpeaker instance. The stream does not start, stop or release it.
+   * @param options Optional `Writable` options.
+   */
+  constructor(speaker: PvSpeaker, options: WritableOptions = {}) {
+    super(options);
+    this._speaker = speaker;
+    this._bytesPerSample = speaker.bitsPerSample / 8;
+  }
+
+  _write(chunk: any, encoding: BufferEncoding, callback: (error?: Error | null) => void): void {
+    const data = Buffer.concat([this._remainder, Buffer.isBuffer(chunk) ? chunk : Buffer.from(chunk, encoding)]);
+    // a chunk does not have to end on a sample boundary, so the trailing bytes wait for the next one
+    const length = data.length - (data.length % this._bytesPerSample);
+    this._remainder = data.subarray(length);
+    if (length === 0) {
+      callback();
+      return;
+    }
+
+    this._play(data.subarray(0, length), false).then(() => callback(), callback);
+  }
+
+  _final(callback: (error?: Error | null) => void): void {
+    this._play(Buffer.alloc(0), true).then(() => callback(), callback);
+  }
+
+  private async _play(data: Buffer, isFlush: boolean): Promise<void> {
+    const pcm = data.buffer.slice(data.byteOffset, data.byteOffset + data.length);
+    const numSamples = data.length / this._bytesPerSample;
+    const writtenLength = isFlush ?
+      await this._speaker.flushAsync(pcm) :
+      await this._speaker.writeAsync(pcm);
+    if (writtenLength < numSamples) {
+      throw new Error("PvSpeaker stopped before all PCM data was written.");
+    }
+  }
+}
+
+export default PvSpeakerWritable;
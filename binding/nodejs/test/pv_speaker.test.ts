@@ -1,4 +1,7 @@
-import { PvSpeaker } from "../src";
+import { pipeline, Readable } from "stream";
+import { promisify } from "util";
+
+import { PvSpeaker, PvSpeakerSharedRing, PvSpeakerWritable } from "../src";
 
 const fs = require('fs');
 const path = require('path');
@@ -73,6 +76,107 @@ describe("Test PvSpeaker", () => {
     fs.unlinkSync(outputPath);
   });
 
+  test("write and flush async", async () => {
+    const bufferSizeSecs = 1;
+    const circularBufferSize = SAMPLE_RATE * bufferSizeSecs;
+    const bytesPerSample = (BITS_PER_SAMPLE / 8);
+    const pcm = new ArrayBuffer(circularBufferSize * bytesPerSample * 2);
+    const pcmLength = pcm.byteLength / bytesPerSample;
+
+    const speaker = new PvSpeaker(SAMPLE_RATE, BITS_PER_SAMPLE, { bufferSizeSecs });
+    speaker.start();
+
+    let numTicks = 0;
+    const timer = setInterval(() => numTicks++, 10);
+    const pending = speaker.writeAsync(pcm);
+    expect(() => speaker.release()).toThrow(Error);
+    expect(await pending).toBe(pcmLength);
+    expect(await speaker.flushAsync(pcm)).toBe(pcmLength);
+    expect(await speaker.flushAsync()).toBe(0);
+    clearInterval(timer);
+    // the event loop kept running while the audio played
+    expect(numTicks).toBeGreaterThan(0);
+
+    speaker.stop();
+    await expect(speaker.writeAsync(pcm)).rejects.toThrow(Error);
+    speaker.release();
+  });
+
+  test("writable stream", async () => {
+    const bytesPerSample = (BITS_PER_SAMPLE / 8);
+    const speaker = new PvSpeaker(SAMPLE_RATE, BITS_PER_SAMPLE, { bufferSizeSecs: 1 });
+    speaker.start();
+
+    // chunks that do not end on a sample boundary
+    const chunks = [];
+    for (let i = 0; i < 20; i++) {
+      chunks.push(Buffer.alloc((SAMPLE_RATE / 10) * bytesPerSample + (i % 2)));
+    }
+    await promisify(pipeline)(Readable.from(chunks), new PvSpeakerWritable(speaker));
+
+    speaker.stop();
+    speaker.release();
+  });
+
+  test("writable stream with chunks shorter than a sample", async () => {
+    const bytesPerSample = (BITS_PER_SAMPLE / 8);
+    const speaker = new PvSpeaker(SAMPLE_RATE, BITS_PER_SAMPLE, { bufferSizeSecs: 1 });
+    speaker.start();
+
+    const chunks = [];
+    for (let i = 0; i < 100 * bytesPerSample; i++) {
+      chunks.push(Buffer.alloc(1));
+    }
+    await promisify(pipeline)(Readable.from(chunks), new PvSpeakerWritable(speaker));
+    expect(await speaker.writeAsync(new ArrayBuffer(0))).toBe(0);
+
+    speaker.stop();
+    speaker.release();
+  });
+
+  test("shared buffer", async () => {
+    const bufferSizeSecs = 1;
+    const circularBufferSize = SAMPLE_RATE * bufferSizeSecs;
+    const bytesPerSample = (BITS_PER_SAMPLE / 8);
+    const pcm = new Int16Array(circularBufferSize * 2);
+
+    const speaker = new PvSpeaker(SAMPLE_RATE, BITS_PER_SAMPLE, { bufferSizeSecs });
+    const sharedBuffer = speaker.createSharedBuffer();
+    expect(speaker.createSharedBuffer()).toBe(sharedBuffer);
+
+    const ring = new PvSpeakerSharedRing(sharedBuffer, BITS_PER_SAMPLE);
+    expect(ring.capacity).toBe(circularBufferSize);
+    expect(ring.available).toBe(circularBufferSize);
+    expect(() => new PvSpeakerSharedRing(new SharedArrayBuffer(16), BITS_PER_SAMPLE)).toThrow(Error);
+
+    speaker.start();
+    expect(() => speaker.createSharedBuffer()).not.toThrow();
+    expect(ring.write(pcm)).toBe(circularBufferSize);
+    expect(ring.available).toBe(0);
+    expect(ring.write(pcm)).toBe(0);
+
+    // the worker is the only writer of the shared buffer
+    expect(() => speaker.write(pcm.buffer)).toThrow(Error);
+    expect(() => speaker.flush(pcm.buffer)).toThrow(Error);
+    await expect(speaker.writeAsync(pcm.buffer)).rejects.toThrow(Error);
+
+    // the audio thread reads from the shared buffer without any write() call
+    let written = circularBufferSize;
+    while (written < pcm.length) {
+      written += ring.write(pcm.subarray(written));
+      await new Promise(resolve => setTimeout(resolve, 10));
+    }
+    expect(await speaker.flushAsync()).toBe(0);
+    expect(ring.available).toBe(circularBufferSize);
+
+    // a partial sample is not written
+    expect(ring.write(new ArrayBuffer(bytesPerSample + 1))).toBe(1);
+
+    speaker.stop();
+    expect(ring.available).toBe(circularBufferSize);
+    speaker.release();
+  });
+
   test("is started", () => {
     const speaker = new PvSpeaker(SAMPLE_RATE, BITS_PER_SAMPLE);
 
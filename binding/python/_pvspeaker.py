@@ -9,16 +9,19 @@
 # specific language governing permissions and limitations under the License.
 #
 
+import asyncio
+import ctypes
 import os
 import platform
 import subprocess
 
+from array import array
 from ctypes import *
 from enum import Enum
-from struct import pack
 from typing import *
 
 CALLBACK = CFUNCTYPE(None, POINTER(c_int16))
+NOTIFICATION_CALLBACK = CFUNCTYPE(None, c_void_p)
 
 
 def default_library_path(relative: str = ''):
@@ -62,6 +65,7 @@ class PvSpeaker(object):
         DEVICE_NOT_INITIALIZED = 6
         IO_ERROR = 7
         RUNTIME_ERROR = 8
+        TIMEOUT = 9
 
     _PVSPEAKER_STATUS_TO_EXCEPTION = {
         PvSpeakerStatuses.OUT_OF_MEMORY: MemoryError,
@@ -71,9 +75,14 @@ class PvSpeaker(object):
         PvSpeakerStatuses.DEVICE_ALREADY_INITIALIZED: ValueError,
         PvSpeakerStatuses.DEVICE_NOT_INITIALIZED: ValueError,
         PvSpeakerStatuses.IO_ERROR: IOError,
-        PvSpeakerStatuses.RUNTIME_ERROR: RuntimeError
+        PvSpeakerStatuses.RUNTIME_ERROR: RuntimeError,
+        PvSpeakerStatuses.TIMEOUT: TimeoutError
     }
 
+    _ARRAY_TYPECODES = {8: 'B', 16: 'h', 24: 'i', 32: 'i'}
+
+    _CANCEL_FADE_MS = 10
+
     class CPvSpeaker(Structure):
         pass
 
@@ -131,13 +140,34 @@ class PvSpeaker(object):
         self._stop_func.restype = self.PvSpeakerStatuses
 
         self._write_func = library.pv_speaker_write
-        self._write_func.argtypes = [POINTER(self.CPvSpeaker), c_char_p, c_int32, POINTER(c_int32)]
+        self._write_func.argtypes = [POINTER(self.CPvSpeaker), c_void_p, c_int32, POINTER(c_int32)]
         self._write_func.restype = self.PvSpeakerStatuses
 
         self._flush_func = library.pv_speaker_flush
-        self._flush_func.argtypes = [POINTER(self.CPvSpeaker), c_char_p, c_int32, POINTER(c_int32)]
+        self._flush_func.argtypes = [POINTER(self.CPvSpeaker), c_void_p, c_int32, POINTER(c_int32)]
         self._flush_func.restype = self.PvSpeakerStatuses
 
+        self._cancel_func = library.pv_speaker_cancel
+        self._cancel_func.argtypes = [POINTER(self.CPvSpeaker), c_int32, POINTER(c_int32)]
+        self._cancel_func.restype = self.PvSpeakerStatuses
+
+        self._notify_available_func = library.pv_speaker_notify_available
+        self._notify_available_func.argtypes = [POINTER(self.CPvSpeaker), c_int32, c_void_p, c_void_p]
+        self._notify_available_func.restype = self.PvSpeakerStatuses
+
+        self._notify_drained_func = library.pv_speaker_notify_drained
+        self._notify_drained_func.argtypes = [POINTER(self.CPvSpeaker), c_void_p, c_void_p]
+        self._notify_drained_func.restype = self.PvSpeakerStatuses
+
+        # signals a file descriptor from the audio thread, without taking the GIL
+        self._signal_fd_func = ctypes.cast(library.pv_speaker_signal_fd, c_void_p)
+        self._notification_fds = None
+        self._notification_callback = None
+
+        self._pack_int24_func = library.pv_speaker_pack_int24
+        self._pack_int24_func.argtypes = [c_void_p, c_int32, c_void_p]
+        self._pack_int24_func.restype = self.PvSpeakerStatuses
+
         self._get_is_started_func = library.pv_speaker_get_is_started
         self._get_is_started_func.argtypes = [POINTER(self.CPvSpeaker)]
         self._get_is_started_func.restype = c_bool
@@ -159,6 +189,11 @@ class PvSpeaker(object):
 
         self._delete_func(self._handle)
 
+        if self._notification_fds is not None:
+            for fd in set(self._notification_fds):
+                os.close(fd)
+            self._notification_fds = None
+
     def start(self) -> None:
         """Starts the audio output device."""
 
@@ -173,17 +208,51 @@ class PvSpeaker(object):
         if status is not self.PvSpeakerStatuses.SUCCESS:
             raise self._PVSPEAKER_STATUS_TO_EXCEPTION[status]("Failed to stop device.")
 
-    def _pcm_to_bytes(self, pcm) -> bytes:
-        byte_data = None
-        if self._bits_per_sample == 8:
-            byte_data = pack('B' * len(pcm), *pcm)
-        elif self._bits_per_sample == 16:
-            byte_data = pack('h' * len(pcm), *pcm)
-        elif self._bits_per_sample == 24:
-            byte_data = b''.join(pack('<i', sample)[0:3] for sample in pcm)
-        elif self._bits_per_sample == 32:
-            byte_data = pack('i' * len(pcm), *pcm)
-        return byte_data
+    @staticmethod
+    def _buffer_address(view: memoryview):
+        if not view.readonly:
+            return (c_char * view.nbytes).from_buffer(view)
+        if isinstance(view.obj, bytes) and (view.nbytes == len(view.obj)):
+            # ctypes passes a pointer to the internal storage of `bytes`
+            return view.obj
+        return bytes(view)
+
+    def _pcm_to_buffer(self, pcm) -> Tuple[Any, int]:
+        """
+        Returns a pointer to the PCM data that can be passed to the library, and the number of samples. Objects that
+        support the buffer protocol are passed without a copy, as long as they hold integer samples of the speaker's
+        width or raw bytes. Other sequences, e.g. lists, are converted. 24-bit samples stored in 32-bit integers are
+        packed by the library.
+        """
+
+        bytes_per_sample = self._bits_per_sample // 8
+        try:
+            view = memoryview(pcm)
+        except TypeError:
+            view = memoryview(array(self._ARRAY_TYPECODES[self._bits_per_sample], pcm))
+
+        if not view.c_contiguous:
+            raise ValueError("PCM data must be contiguous in memory.")
+        if view.format[-1] in 'efd':
+            raise ValueError("PCM data must hold integer samples.")
+
+        if (self._bits_per_sample == 24) and (view.itemsize == 4):
+            num_samples = view.nbytes // 4
+            packed = bytearray(num_samples * 3)
+            status = self._pack_int24_func(
+                self._buffer_address(view), num_samples, (c_char * len(packed)).from_buffer(packed))
+            if status is not self.PvSpeakerStatuses.SUCCESS:
+                raise self._PVSPEAKER_STATUS_TO_EXCEPTION[status]("Failed to pack 24-bit PCM data.")
+            view = memoryview(packed)
+        elif (view.itemsize != 1) and (view.itemsize != bytes_per_sample):
+            raise ValueError(
+                "PCM data has %d-byte samples - expected %d-byte samples or raw bytes." %
+                (view.itemsize, bytes_per_sample))
+
+        if view.nbytes % bytes_per_sample != 0:
+            raise ValueError("PCM data must hold whole %d-byte samples." % bytes_per_sample)
+
+        return self._buffer_address(view), view.nbytes // bytes_per_sample
 
     def write(self, pcm) -> int:
         """
@@ -191,12 +260,14 @@ class PvSpeaker(object):
         Only writes as much PCM data as the internal circular buffer can currently fit, and
         returns the length of the PCM data that was successfully written.
 
+        :param pcm: PCM data to be played. Any object supporting the buffer protocol (e.g. `bytes`, `bytearray` or a
+        NumPy array of integers) is passed to the library without a copy. Lists of samples are also accepted.
         :return: Length of the PCM data that was successfully written.
         """
 
+        pcm_buffer, num_samples = self._pcm_to_buffer(pcm)
         written_length = c_int32()
-        status = self._write_func(
-            self._handle, c_char_p(self._pcm_to_bytes(pcm)), c_int32(len(pcm)), byref(written_length))
+        status = self._write_func(self._handle, pcm_buffer, c_int32(num_samples), byref(written_length))
         if status is not self.PvSpeakerStatuses.SUCCESS:
             raise self._PVSPEAKER_STATUS_TO_EXCEPTION[status]("Failed to write to device.")
 
@@ -207,19 +278,135 @@ class PvSpeaker(object):
         Synchronous call to write PCM data to the internal circular buffer for audio playback.
         This call blocks the thread until all PCM data has been successfully written and played.
 
+        :param pcm: PCM data to be played, in any of the forms that `write()` accepts.
         :return: Length of the PCM data that was successfully written.
         """
 
-        if pcm is None:
-            pcm = []
+        pcm_buffer, num_samples = (None, 0) if pcm is None else self._pcm_to_buffer(pcm)
         written_length = c_int32()
-        status = self._flush_func(
-            self._handle, c_char_p(self._pcm_to_bytes(pcm)), c_int32(len(pcm)), byref(written_length))
+        status = self._flush_func(self._handle, pcm_buffer, c_int32(num_samples), byref(written_length))
         if status is not self.PvSpeakerStatuses.SUCCESS:
             raise self._PVSPEAKER_STATUS_TO_EXCEPTION[status]("Failed to flush PCM data.")
 
         return written_length.value
 
+    async def write_async(self, pcm) -> int:
+        """
+        Writes all of the PCM data to the internal circular buffer for audio playback. Whenever the buffer is full, the
+        coroutine waits on the event loop for the device to play enough of the buffered audio, so any number of
+        speakers can share one loop thread. Only one of `write_async()` and `flush_async()` can be awaited at a time.
+        Cancelling the coroutine fades out and discards all buffered audio, e.g. when the user interrupts playback.
+
+        :param pcm: PCM data to be played, in any of the forms that `write()` accepts.
+        :return: Length of the PCM data that was successfully written. It is less than the length of `pcm` only if the
+        speaker was stopped meanwhile.
+        """
+
+        pcm_buffer, num_samples = self._pcm_to_buffer(pcm)
+        if num_samples == 0:
+            return 0
+
+        # the library reads `pcm_buffer` from this address across awaits, so it must stay referenced until the end
+        address = addressof(pcm_buffer) if isinstance(pcm_buffer, Array) else ctypes.cast(pcm_buffer, c_void_p).value
+        bytes_per_sample = self._bits_per_sample // 8
+        # waiting for half of the buffer keeps the number of wake-ups low while the device still has audio queued
+        wait_length = max((self._sample_rate * self._buffer_size_secs) // 2, 1)
+
+        written_length = 0
+        while True:
+            length = c_int32()
+            status = self._write_func(
+                self._handle,
+                c_void_p(address + (written_length * bytes_per_sample)),
+                c_int32(num_samples - written_length),
+                byref(length))
+            if status is not self.PvSpeakerStatuses.SUCCESS:
+                raise self._PVSPEAKER_STATUS_TO_EXCEPTION[status]("Failed to write to device.")
+            written_length += length.value
+            if written_length == num_samples:
+                break
+
+            await self._wait_for_notification(
+                self._notify_available_func,
+                c_int32(min(num_samples - written_length, wait_length)))
+            if not self.is_started:
+                break
+
+        return written_length
+
+    async def flush_async(self, pcm=None) -> int:
+        """
+        Asynchronous version of `flush()`. Writes all of the PCM data like `write_async()`, then waits on the event loop
+        for all buffered audio to be played. Cancelling the coroutine fades out and discards all buffered audio.
+
+        :param pcm: PCM data to be played, in any of the forms that `write()` accepts.
+        :return: Length of the PCM data that was successfully written.
+        """
+
+        written_length = 0 if pcm is None else await self.write_async(pcm)
+        if self.is_started:
+            await self._wait_for_notification(self._notify_drained_func)
+
+        return written_length
+
+    async def _wait_for_notification(self, notify_func, *args) -> None:
+        """
+        Arms a notification of the library and waits for it. Stopping the speaker ends the wait as well. On POSIX
+        systems the library signals a file descriptor that the event loop watches. Event loops on Windows cannot watch
+        pipes, so there the audio thread schedules the wake-up on the loop instead.
+        """
+
+        loop = asyncio.get_running_loop()
+        future = loop.create_future()
+
+        def wake_up():
+            if not future.done():
+                future.set_result(None)
+
+        try:
+            if platform.system() != "Windows":
+                read_fd, write_fd = self._get_notification_fds()
+                try:
+                    # a notification that fired after its waiter was cancelled leaves a stale signal behind
+                    os.read(read_fd, 64)
+                except BlockingIOError:
+                    pass
+
+                status = notify_func(self._handle, *args, self._signal_fd_func, c_void_p(write_fd))
+                if status is not self.PvSpeakerStatuses.SUCCESS:
+                    raise self._PVSPEAKER_STATUS_TO_EXCEPTION[status]("Failed to wait for device.")
+
+                loop.add_reader(read_fd, wake_up)
+                try:
+                    await future
+                finally:
+                    loop.remove_reader(read_fd)
+            else:
+                # kept referenced until the library calls it, which happens at the latest when the speaker is stopped
+                self._notification_callback = NOTIFICATION_CALLBACK(lambda _: loop.call_soon_threadsafe(wake_up))
+                status = notify_func(self._handle, *args, self._notification_callback, None)
+                if status is not self.PvSpeakerStatuses.SUCCESS:
+                    raise self._PVSPEAKER_STATUS_TO_EXCEPTION[status]("Failed to wait for device.")
+
+                await future
+        except asyncio.CancelledError:
+            # also calls the pending notification, so the next wait can arm a new one
+            self._cancel_func(self._handle, c_int32(self._CANCEL_FADE_MS), byref(c_int32()))
+            raise
+
+    def _get_notification_fds(self) -> Tuple[int, int]:
+        if self._notification_fds is None:
+            if hasattr(os, 'eventfd'):
+                fd = os.eventfd(0, os.EFD_NONBLOCK | os.EFD_CLOEXEC)
+                self._notification_fds = (fd, fd)
+            else:
+                read_fd, write_fd = os.pipe()
+                # the audio thread must never block on a full pipe
+                os.set_blocking(read_fd, False)
+                os.set_blocking(write_fd, False)
+                self._notification_fds = (read_fd, write_fd)
+        return self._notification_fds
+
     def write_to_file(self, output_path: str) -> None:
         """Writes PCM data passed to PvSpeaker to a specified WAV file."""
 
@@ -9,8 +9,12 @@
 #    specific language governing permissions and limitations under the License.
 #
 
+import asyncio
 import os
 import unittest
+import wave
+
+from array import array
 
 from _pvspeaker import *
 
@@ -74,6 +78,93 @@ class PvSpeakerTestCase(unittest.TestCase):
         speaker.delete()
         os.remove(output_path)
 
+    def test_write_buffer_protocol(self):
+        speaker = PvSpeaker(16000, 16, 1)
+        speaker.start()
+
+        samples = array('h', [0] * 1000)
+        for pcm in [samples, memoryview(samples), samples.tobytes(), bytearray(samples.tobytes())]:
+            write_count = speaker.write(pcm)
+            self.assertEqual(write_count, 1000)
+            speaker.flush()
+
+        with self.assertRaises(ValueError):
+            speaker.write(array('i', [0] * 1000))
+        with self.assertRaises(ValueError):
+            speaker.write(b'\x00' * 999)
+        with self.assertRaises(ValueError):
+            speaker.write(array('f', [0] * 1000))
+
+        speaker.stop()
+        speaker.delete()
+
+    def test_write_int24(self):
+        samples = [0, 1, -1, 8388607, -8388608, 0x123456]
+        expected = b'\x00\x00\x00\x01\x00\x00\xff\xff\xff\xff\xff\x7f\x00\x00\x80\x56\x34\x12'
+
+        output_path = "tmp.wav"
+        speaker = PvSpeaker(16000, 24, 1)
+        speaker.start()
+        speaker.write_to_file(output_path)
+        self.assertEqual(speaker.write(samples), len(samples))
+        self.assertEqual(speaker.write(array('i', samples)), len(samples))
+        self.assertEqual(speaker.flush(expected), len(samples))
+        speaker.stop()
+        speaker.delete()
+
+        with wave.open(output_path, 'rb') as f:
+            self.assertEqual(f.readframes(f.getnframes()), expected * 3)
+        os.remove(output_path)
+
+    def test_write_async(self):
+        sample_rate = 16000
+        buffer_size_secs = 1
+        pcm = array('h', [0] * (sample_rate * buffer_size_secs * 2))
+
+        async def play(speaker):
+            self.assertEqual(await speaker.write_async(pcm), len(pcm))
+            self.assertEqual(await speaker.flush_async(pcm.tobytes()[:2000]), 1000)
+            self.assertEqual(await speaker.flush_async(), 0)
+
+        speakers = [PvSpeaker(sample_rate, 16, buffer_size_secs) for _ in range(4)]
+        for speaker in speakers:
+            speaker.start()
+
+        async def play_all():
+            await asyncio.gather(*[play(speaker) for speaker in speakers])
+
+        asyncio.run(play_all())
+
+        for speaker in speakers:
+            speaker.stop()
+            speaker.delete()
+
+    def test_flush_async_cancel(self):
+        sample_rate = 16000
+        buffer_size_secs = 1
+        pcm = array('h', [0] * (sample_rate * buffer_size_secs * 2))
+
+        speaker = PvSpeaker(sample_rate, 16, buffer_size_secs)
+        speaker.start()
+
+        async def interrupt():
+            task = asyncio.ensure_future(speaker.flush_async(pcm))
+            await asyncio.sleep(0.1)
+            task.cancel()
+            with self.assertRaises(asyncio.CancelledError):
+                await task
+
+            # cancelling discarded the buffered audio, so the speaker is ready for the next utterance
+            self.assertEqual(await speaker.flush_async(pcm[:1000]), 1000)
+
+            task = asyncio.ensure_future(speaker.write_async(pcm))
+            await asyncio.sleep(0.1)
+            speaker.stop()
+            self.assertLess(await task, len(pcm))
+
+        asyncio.run(interrupt())
+        speaker.delete()
+
     def test_is_started(self):
         speaker = PvSpeaker(16000, 16, 20)
         speaker.start()
@@ -86,54 +86,39 @@ typedef struct {
     uint32_t subchunk2_size;
 } wav_header;
 
-void *read_wav_file(const char *filename, uint32_t *num_samples, uint32_t *sample_rate, uint16_t *bits_per_sample) {
+bool read_wav_header(const char *filename, uint32_t *sample_rate, uint16_t *bits_per_sample) {
     FILE *file = fopen(filename, "rb");
     if (!file) {
         perror("Unable to open file");
-        return NULL;
+        return false;
     }
 
     wav_header header;
 
     fread(&header, sizeof(header), 1, file);
 
+    fclose(file);
+
     if (header.chunk_id[0] != 'R' || header.chunk_id[1] != 'I' || header.chunk_id[2] != 'F' || header.chunk_id[3] != 'F' ||
         header.format[0] != 'W' || header.format[1] != 'A' || header.format[2] != 'V' || header.format[3] != 'E') {
-        fclose(file);
         fprintf(stderr, "Invalid WAV file\n");
-        return NULL;
+        return false;
     }
 
     if (header.audio_format != 1) {
-        fclose(file);
         fprintf(stderr, "WAV file format must be PCM type\n");
-        return NULL;
+        return false;
     }
 
     if (header.num_channels != 1) {
-        fclose(file);
         fprintf(stderr, "WAV file must have a single channel (MONO)\n");
-        return NULL;
+        return false;
     }
 
     *sample_rate = header.sample_rate;
     *bits_per_sample = header.bits_per_sample;
-    uint32_t bytes_per_sample = header.bits_per_sample / 8;
-    *num_samples = header.subchunk2_size / bytes_per_sample;
-
-    void *pcm_data = malloc(header.subchunk2_size);
-
-    if (!pcm_data) {
-        perror("Memory allocation failed");
-        fclose(file);
-        return NULL;
-    }
-
-    fread(pcm_data, header.subchunk2_size, 1, file);
 
-    fclose(file);
-
-    return pcm_data;
+    return true;
 }
 
 int main(int argc, char *argv[]) {
@@ -173,9 +158,11 @@ int main(int argc, char *argv[]) {
     signal(SIGINT, interrupt_handler);
     fprintf(stdout, "pv_speaker version: %s\n", pv_speaker_version());
 
-    uint32_t num_samples, sample_rate;
+    uint32_t sample_rate;
     uint16_t bits_per_sample;
-    void *pcm_data = read_wav_file(input_wav_path, &num_samples, &sample_rate, &bits_per_sample);
+    if (!read_wav_header(input_wav_path, &sample_rate, &bits_per_sample)) {
+        exit(1);
+    }
 
     fprintf(stdout, "Initializing pv_speaker...\n");
     pv_speaker_status_t status = pv_speaker_init(
@@ -203,37 +190,10 @@ int main(int argc, char *argv[]) {
     }
 
     fprintf(stdout, "Playing audio...\n");
-    if (pcm_data) {
-        int8_t *pcm = (int8_t *) pcm_data;
-        int32_t total_written_length = 0;
-
-        while (!is_interrupted && total_written_length < num_samples) {
-            int32_t written_length = 0;
-            status = pv_speaker_write(
-                    speaker,
-                    &pcm[total_written_length * bits_per_sample / 8],
-                    num_samples - total_written_length,
-                    &written_length);
-            if (status != PV_SPEAKER_STATUS_SUCCESS) {
-                fprintf(stderr, "Failed to write with %s.\n", pv_speaker_status_to_string(status));
-                exit(1);
-            }
-            total_written_length += written_length;
-        }
-
-        free(pcm);
-    }
-
-    if (!is_interrupted) {
-        fprintf(stdout, "Waiting for audio to finish...\n");
-        int8_t *pcm = NULL;
-        int32_t pcm_length = 0;
-        int32_t written_length = 0;
-        status = pv_speaker_flush(speaker, pcm, pcm_length, &written_length);
-        if (status != PV_SPEAKER_STATUS_SUCCESS) {
-            fprintf(stderr, "Failed to flush pcm with %s.\n", pv_speaker_status_to_string(status));
-            exit(1);
-        }
+    status = pv_speaker_play_file(speaker, input_wav_path);
+    if ((status != PV_SPEAKER_STATUS_SUCCESS) && !is_interrupted) {
+        fprintf(stderr, "Failed to play audio with %s.\n", pv_speaker_status_to_string(status));
+        exit(1);
     }
 
     if (!is_interrupted) {
@@ -17,6 +17,8 @@
 
 /**
 * Forward declaration of pv_circular_buffer object. It handles reading and writing to a circular buffer.
+* The buffer is lock-free for a single producer thread calling `pv_circular_buffer_write()` and a single consumer
+* thread calling `pv_circular_buffer_read()` concurrently.
 */
 typedef struct pv_circular_buffer pv_circular_buffer_t;
 
@@ -44,6 +46,48 @@ pv_circular_buffer_status_t pv_circular_buffer_init(
         int32_t element_size,
         pv_circular_buffer_t **object);
 
+/**
+* Constructor for a mirrored pv_circular_buffer object. On Linux the ring is mapped twice back to back in virtual
+* memory, so every read, write and reservation is a single contiguous region. The ring is rounded up to whole pages
+* while the capacity stays at `element_count`. Other platforms fall back to `pv_circular_buffer_init()`.
+*
+* @param element_count Capacity of the buffer to read and write.
+* @param element_size Size of each element in the buffer.
+* @param object[out] Circular buffer object.
+* @return Status Code. Returns PV_CIRCULAR_BUFFER_STATUS_OUT_OF_MEMORY or PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT
+* on failure.
+*/
+pv_circular_buffer_status_t pv_circular_buffer_init_mirrored(
+        int32_t element_count,
+        int32_t element_size,
+        pv_circular_buffer_t **object);
+
+/**
+* Constructor for a pv_circular_buffer object whose ring and indices live in memory owned by the caller, e.g. memory
+* shared with a producer that runs outside of this library and follows the same protocol: both indices run over
+* [0, 2 * `element_count`) and the producer publishes elements by storing the advanced write index with release
+* semantics. Every write index loaded from the caller's memory is range-checked, and one that is out of range reads as
+* an empty buffer and reserves no space. The consumer keeps its own copy of the read index and only publishes it to
+* `read_index`, which it never reads back. The buffer starts out empty at the current write index, which is left
+* unchanged. The memory must outlive the object.
+*
+* @param element_count Capacity of the buffer to read and write.
+* @param element_size Size of each element in the buffer.
+* @param buffer Memory for `element_count` elements.
+* @param write_index Index of the next element to write.
+* @param read_index Index of the next element to read, as published by the consumer.
+* @param object[out] Circular buffer object.
+* @return Status Code. Returns PV_CIRCULAR_BUFFER_STATUS_OUT_OF_MEMORY or PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT
+* on failure.
+*/
+pv_circular_buffer_status_t pv_circular_buffer_init_external(
+        int32_t element_count,
+        int32_t element_size,
+        void *buffer,
+        int32_t *write_index,
+        int32_t *read_index,
+        pv_circular_buffer_t **object);
+
 /**
 * Destructor for pv_circular_buffer object.
 *
@@ -66,6 +110,45 @@ pv_circular_buffer_status_t pv_circular_buffer_read(
         int32_t buffer_length,
         int32_t *read_length);
 
+/**
+* Drops elements from the front of the buffer without copying them. Like `pv_circular_buffer_read()`, it must only be
+* called by the consumer thread.
+*
+* @param object Circular buffer object.
+* @param length The maximum number of elements to drop.
+* @param skipped_length[out] Actual number of elements dropped.
+* @return Status Code. Returns PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT on failure.
+*/
+pv_circular_buffer_status_t pv_circular_buffer_skip(
+        pv_circular_buffer_t *object,
+        int32_t length,
+        int32_t *skipped_length);
+
+/**
+* Gets the current position of the producer, which `pv_circular_buffer_skip_to()` takes later on to drop only the
+* elements written before it.
+*
+* @param object Circular buffer object.
+* @param position[out] Position of the next element to write.
+* @return Status Code. Returns PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT on failure.
+*/
+pv_circular_buffer_status_t pv_circular_buffer_get_write_position(pv_circular_buffer_t *object, int32_t *position);
+
+/**
+* Drops the elements in front of `position`, which `pv_circular_buffer_get_write_position()` returned earlier. Elements
+* written after it stay in the buffer, and nothing is dropped if the consumer has already read past it. Like
+* `pv_circular_buffer_read()`, it must only be called by the consumer thread.
+*
+* @param object Circular buffer object.
+* @param position Write position to drop the elements up to.
+* @param skipped_length[out] Actual number of elements dropped.
+* @return Status Code. Returns PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT on failure.
+*/
+pv_circular_buffer_status_t pv_circular_buffer_skip_to(
+        pv_circular_buffer_t *object,
+        int32_t position,
+        int32_t *skipped_length);
+
 /**
 * Writes and copies the elements of `buffer` to the object's buffer. Does not write frames if the buffer
 * is full and returns PV_CIRCULAR_BUFFER_STATUS_WRITE_OVERFLOW which is not a failure.
@@ -80,6 +163,36 @@ pv_circular_buffer_status_t pv_circular_buffer_write(
         const void *buffer,
         int32_t buffer_length);
 
+/**
+* Gets the writable regions of the object's buffer so that the producer can fill them in place. The space is split in
+* two regions when it wraps around the end of the buffer. Nothing becomes readable until
+* `pv_circular_buffer_write_commit()` is called.
+*
+* @param object Circular buffer object.
+* @param max_length The maximum number of elements to reserve.
+* @param region1[out] Start of the first writable region.
+* @param region1_length[out] Number of elements in the first region.
+* @param region2[out] Start of the second writable region, or NULL if the space does not wrap around.
+* @param region2_length[out] Number of elements in the second region.
+* @return Status Code. Returns PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT on failure.
+*/
+pv_circular_buffer_status_t pv_circular_buffer_write_reserve(
+        pv_circular_buffer_t *object,
+        int32_t max_length,
+        void **region1,
+        int32_t *region1_length,
+        void **region2,
+        int32_t *region2_length);
+
+/**
+* Publishes `length` elements previously filled through `pv_circular_buffer_write_reserve()`.
+*
+* @param object Circular buffer object.
+* @param length The number of elements to publish. Must not exceed the reserved length.
+* @return Status Code. Returns PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT on failure.
+*/
+pv_circular_buffer_status_t pv_circular_buffer_write_commit(pv_circular_buffer_t *object, int32_t length);
+
 /**
 * Gets the current amount of available space in the object's buffer.
 *
@@ -99,7 +212,9 @@ pv_circular_buffer_status_t pv_circular_buffer_get_available(pv_circular_buffer_
 pv_circular_buffer_status_t pv_circular_buffer_get_count(pv_circular_buffer_t *object, int32_t *count);
 
 /**
-* Reset the buffer pointers to start.
+* Reset the buffer pointers to start. Must not be called while the producer or the consumer is active. A buffer created
+* by `pv_circular_buffer_init_external()` is emptied instead by moving only the read index up to the current write
+* index, so its producer may keep running.
 *
 * @param object Circular buffer object.
 */
@@ -0,0 +1,43 @@
+/*
+    Copyright 2024 Picovoice Inc.
+
+    You may not use this file except in compliance with the license. A copy of the license is located in the "LICENSE"
+    file accompanying this source.
+
+    Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on
+    an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the
+    specific language governing permissions and limitations under the License.
+*/
+
+#ifndef PV_GAIN_H
+#define PV_GAIN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+* Multiplies interleaved PCM samples by a gain in place. Integer samples saturate instead of wrapping around, and float
+* samples are left unclipped. 16-bit integer and 32-bit float samples use SSE2 or AVX2 kernels on x86 (AVX2 is picked
+* at runtime when the CPU supports it) and NEON kernels on ARM. Other formats use scalar code.
+*
+* The gain of sample `i` is `gain + (i * gain_step / num_channels)`, i.e. the ramp advances by `gain_step` per frame and
+* is spread evenly over the samples of the frame, so that the kernels do not depend on the channel count.
+*
+* @param pcm Interleaved PCM samples.
+* @param bits_per_sample The number of bits per sample. One of 8, 16, 24 and 32.
+* @param is_float Whether samples are 32-bit IEEE floats.
+* @param num_channels The number of channels per frame.
+* @param num_frames The number of frames in `pcm`.
+* @param gain The gain of the first frame.
+* @param gain_step The change of the gain from one frame to the next. 0 applies a constant gain.
+*/
+void pv_gain_apply(
+        void *pcm,
+        int32_t bits_per_sample,
+        bool is_float,
+        int32_t num_channels,
+        int32_t num_frames,
+        float gain,
+        float gain_step);
+
+#endif //PV_GAIN_H
@@ -0,0 +1,131 @@
+/*
+    Copyright 2024 Picovoice Inc.
+
+    You may not use this file except in compliance with the license. A copy of the license is located in the "LICENSE"
+    file accompanying this source.
+
+    Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on
+    an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the
+    specific language governing permissions and limitations under the License.
+*/
+
+#ifndef PV_RESAMPLER_H
+#define PV_RESAMPLER_H
+
+#include <stdint.h>
+
+/**
+* Forward declaration of pv_resampler object. It converts a stream of interleaved 32-bit float frames from one sample
+* rate to another. The object is not thread-safe and keeps its filter history between calls, so one object serves one
+* continuous stream.
+*/
+typedef struct pv_resampler pv_resampler_t;
+
+/**
+* Status codes.
+*/
+typedef enum {
+    PV_RESAMPLER_STATUS_SUCCESS = 0,
+    PV_RESAMPLER_STATUS_OUT_OF_MEMORY,
+    PV_RESAMPLER_STATUS_INVALID_ARGUMENT,
+} pv_resampler_status_t;
+
+/**
+* Interpolation used by the resampler.
+*
+* PV_RESAMPLER_QUALITY_LINEAR interpolates between the two nearest input frames. It is the cheapest option and has the
+* same quality as miniaudio's default resampler.
+*
+* PV_RESAMPLER_QUALITY_SINC is a Kaiser-windowed sinc filter stored as a polyphase table. The filter is widened when
+* downsampling so that it also acts as the anti-aliasing filter.
+*/
+typedef enum {
+    PV_RESAMPLER_QUALITY_LINEAR = 0,
+    PV_RESAMPLER_QUALITY_SINC,
+} pv_resampler_quality_t;
+
+/**
+* Number of frames the resampler requests from its source at most in a single call.
+*/
+#define PV_RESAMPLER_MAX_SOURCE_FRAMES (512)
+
+/**
+* Source of input frames for `pv_resampler_read()`.
+*
+* @param context The context passed to `pv_resampler_read()`.
+* @param input[out] Buffer to receive interleaved 32-bit float frames.
+* @param max_length The maximum number of frames to write into `input`. Never exceeds PV_RESAMPLER_MAX_SOURCE_FRAMES.
+* @return The number of frames written. Returning 0 tells the resampler that no input is available right now.
+*/
+typedef int32_t (*pv_resampler_source_t)(void *context, float *input, int32_t max_length);
+
+/**
+* Constructor for pv_resampler object. All memory is allocated here, so `pv_resampler_read()` is safe to call from a
+* real-time audio thread.
+*
+* @param input_sample_rate The sample rate of the input frames.
+* @param output_sample_rate The sample rate of the output frames.
+* @param num_channels The number of interleaved channels per frame.
+* @param quality The interpolation to use.
+* @param object[out] Resampler object.
+* @return Status Code. Returns PV_RESAMPLER_STATUS_OUT_OF_MEMORY or PV_RESAMPLER_STATUS_INVALID_ARGUMENT on failure.
+*/
+pv_resampler_status_t pv_resampler_init(
+        int32_t input_sample_rate,
+        int32_t output_sample_rate,
+        int32_t num_channels,
+        pv_resampler_quality_t quality,
+        pv_resampler_t **object);
+
+/**
+* Destructor for pv_resampler object.
+*
+* @param object Resampler object.
+*/
+void pv_resampler_delete(pv_resampler_t *object);
+
+/**
+* Produces up to `output_length` frames, pulling as many input frames from `source` as it needs. Input frames that are
+* pulled but not consumed yet are kept for the next call. Output frame `n` of the stream lines up with input time
+* `n * input_sample_rate / output_sample_rate`, so the resampler adds no delay. In return it holds back a few input
+* frames of lookahead (half the filter length) until the frames after them arrive.
+*
+* @param object Resampler object.
+* @param output[out] Buffer to receive interleaved 32-bit float frames.
+* @param output_length The maximum number of frames to write into `output`.
+* @param source Source of input frames.
+* @param context Context passed to `source`.
+* @return The number of frames written to `output`. It is less than `output_length` only if `source` ran dry.
+*/
+int32_t pv_resampler_read(
+        pv_resampler_t *object,
+        float *output,
+        int32_t output_length,
+        pv_resampler_source_t source,
+        void *context);
+
+/**
+* Gets the number of input frames the resampler holds back as lookahead. Feeding this many frames of silence after the
+* end of a stream flushes every output frame that depends on real input.
+*
+* @param object Resampler object.
+* @return Lookahead in input frames.
+*/
+int32_t pv_resampler_get_lookahead(const pv_resampler_t *object);
+
+/**
+* Drops the filter history so that the next call to `pv_resampler_read()` starts a new stream.
+*
+* @param object Resampler object.
+*/
+void pv_resampler_reset(pv_resampler_t *object);
+
+/**
+* Provides string representations of status codes.
+*
+* @param status Status code.
+* @return String representation.
+*/
+const char *pv_resampler_status_to_string(pv_resampler_status_t status);
+
+#endif //PV_RESAMPLER_H
@@ -14,6 +14,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #if __PV_PLATFORM_WINDOWS__
 
@@ -30,6 +31,11 @@
 */
 typedef struct pv_speaker pv_speaker_t;
 
+/**
+* Struct representing an additional stream mixed into the output of a PvSpeaker object in mixer mode.
+*/
+typedef struct pv_speaker_stream pv_speaker_stream_t;
+
 /**
 * Status codes.
 */
@@ -42,9 +48,208 @@ typedef enum {
     PV_SPEAKER_STATUS_DEVICE_ALREADY_INITIALIZED,
     PV_SPEAKER_STATUS_DEVICE_NOT_INITIALIZED,
     PV_SPEAKER_STATUS_IO_ERROR,
-    PV_SPEAKER_STATUS_RUNTIME_ERROR
+    PV_SPEAKER_STATUS_RUNTIME_ERROR,
+    PV_SPEAKER_STATUS_TIMEOUT
 } pv_speaker_status_t;
 
+/**
+* What happens to PCM data written while recording to a WAV file when the file writer cannot keep up.
+*/
+typedef enum {
+    PV_SPEAKER_FILE_OVERFLOW_POLICY_BLOCK = 0,
+    PV_SPEAKER_FILE_OVERFLOW_POLICY_DROP
+} pv_speaker_file_overflow_policy_t;
+
+/**
+* Version of `pv_speaker_config_t` declared by this header.
+*/
+#define PV_SPEAKER_CONFIG_VERSION (4)
+
+/**
+* Resampler used when the audio device runs at a different sample rate than the PCM data.
+*
+* PV_SPEAKER_RESAMPLER_QUALITY_LINEAR interpolates between neighbouring frames. It is the cheapest option.
+*
+* PV_SPEAKER_RESAMPLER_QUALITY_SINC uses a windowed-sinc filter, which keeps imaging and aliasing below audibility at
+* a few times the cost.
+*/
+typedef enum {
+    PV_SPEAKER_RESAMPLER_QUALITY_LINEAR = 0,
+    PV_SPEAKER_RESAMPLER_QUALITY_SINC,
+} pv_speaker_resampler_quality_t;
+
+/**
+* Configuration for `pv_speaker_init_ex()`. Initialize it with `pv_speaker_config_init()` before setting any fields, so
+* that fields added in later versions keep their defaults.
+*/
+typedef struct {
+    /**
+    * Version of the struct, set by `pv_speaker_config_init()`.
+    */
+    int32_t version;
+
+    /**
+    * The sample rate of the audio to be played.
+    */
+    int32_t sample_rate;
+
+    /**
+    * The number of bits per sample.
+    */
+    int16_t bits_per_sample;
+
+    /**
+    * The index of the audio device to use. A value of (-1) will resort to default device.
+    */
+    int32_t device_index;
+
+    /**
+    * Capacity of the internal circular buffer in frames. If 0, `buffer_size_ms` is used instead.
+    */
+    int32_t buffer_size_frames;
+
+    /**
+    * Capacity of the internal circular buffer in milliseconds. Defaults to 1000.
+    */
+    int32_t buffer_size_ms;
+
+    /**
+    * Size of a device period in frames. If 0, `period_size_ms` is used instead.
+    */
+    int32_t period_size_frames;
+
+    /**
+    * Size of a device period in milliseconds. If both period sizes are 0, the backend picks one.
+    */
+    int32_t period_size_ms;
+
+    /**
+    * Number of device periods. If 0, the backend picks it.
+    */
+    int32_t periods;
+
+    /**
+    * Whether the backend should prefer low latency over robustness to scheduling jitter. Defaults to true.
+    */
+    bool is_low_latency;
+
+    /**
+    * Number of channels. Multichannel PCM data is interleaved, and every length passed to or returned by PvSpeaker
+    * counts frames, i.e. one sample per channel. Defaults to 1. Added in version 2.
+    */
+    int32_t num_channels;
+
+    /**
+    * Whether samples are 32-bit IEEE floats instead of integers. Requires `bits_per_sample` to be 32. Added in
+    * version 2.
+    */
+    bool is_float;
+
+    /**
+    * The sample rate to open the audio device at. If 0 or equal to `sample_rate`, the device runs at `sample_rate`.
+    * Otherwise PvSpeaker resamples the PCM data with `resampler_quality` and feeds the device 32-bit floats. Lengths
+    * passed to or returned by PvSpeaker keep counting frames at `sample_rate`; only the period sizes are device frames.
+    * Added in version 3.
+    */
+    int32_t device_sample_rate;
+
+    /**
+    * Resampler used when `device_sample_rate` differs from `sample_rate`. Defaults to
+    * PV_SPEAKER_RESAMPLER_QUALITY_SINC. Added in version 3.
+    */
+    pv_speaker_resampler_quality_t resampler_quality;
+
+    /**
+    * Whether to run as a mixer, so that streams created with `pv_speaker_stream_init()` play on top of the PCM data
+    * written to the PvSpeaker object itself. The device then receives 32-bit floats. Added in version 4.
+    */
+    bool is_mixer;
+} pv_speaker_config_t;
+
+/**
+* Maximum number of streams a PvSpeaker object in mixer mode plays at the same time.
+*/
+#define PV_SPEAKER_MAX_STREAMS (16)
+
+/**
+* Number of buckets in the callback duration histogram of `pv_speaker_stats_t`.
+*/
+#define PV_SPEAKER_STATS_NUM_CALLBACK_DURATION_BUCKETS (10)
+
+/**
+* Playback statistics reported by `pv_speaker_get_stats()`. Counters accumulate over the lifetime of the instance.
+*/
+typedef struct {
+    /**
+    * Number of times the audio device ran out of PCM data while playing.
+    */
+    int64_t num_underruns;
+
+    /**
+    * Number of frames passed to the audio device.
+    */
+    int64_t frames_played;
+
+    /**
+    * Number of frames written to the internal circular buffer.
+    */
+    int64_t frames_written;
+
+    /**
+    * Number of frames currently in the internal circular buffer.
+    */
+    int32_t fill;
+
+    /**
+    * Largest number of frames the internal circular buffer has held.
+    */
+    int32_t peak_fill;
+
+    /**
+    * Estimated time until a sample written now is heard: the buffered samples plus the audio device's own buffer.
+    */
+    float estimated_latency_ms;
+
+    /**
+    * Histogram of audio callback durations. Bucket `i` counts callbacks that took less than 2^(i + 3) microseconds
+    * (i.e. 8 us, 16 us, ...), the last bucket counts all slower ones.
+    */
+    int64_t callback_durations[PV_SPEAKER_STATS_NUM_CALLBACK_DURATION_BUCKETS];
+} pv_speaker_stats_t;
+
+/**
+* Callback invoked from the audio thread when the frame of a marker added by `pv_speaker_add_marker()` has been played.
+*
+* @param user_data Pointer passed to `pv_speaker_add_marker()`.
+* @param frame_index Index of the frame the marker was added for.
+*/
+typedef void (*pv_speaker_marker_callback_t)(void *user_data, int64_t frame_index);
+
+/**
+* Maximum number of markers added by `pv_speaker_add_marker()` that the audio thread has not picked up yet. The audio
+* thread holds up to as many again until they fire.
+*/
+#define PV_SPEAKER_MAX_MARKERS (64)
+
+/**
+* Callback invoked once for a notification requested with `pv_speaker_notify_available()` or
+* `pv_speaker_notify_drained()`. It runs on the audio thread, or on the thread that stops or deletes the PvSpeaker
+* object, and must return quickly.
+*
+* @param user_data Pointer passed along with the callback.
+*/
+typedef void (*pv_speaker_notification_callback_t)(void *user_data);
+
+/**
+* Callback that renders PCM data on demand. It is invoked from the audio thread whenever the device needs more data and
+* must fill `pcm` with `num_samples` frames; frames it does not write are played as silence. It must not block.
+*
+* @param user_data Pointer passed to `pv_speaker_set_render_callback()`.
+* @param pcm Device buffer to render the PCM data into.
+* @param num_samples Number of frames requested.
+*/
+typedef void (*pv_speaker_render_callback_t)(void *user_data, int8_t *pcm, int32_t num_samples);
+
 /**
 * Creates a PvSpeaker instance. When finished with the instance, resources should be released
 * using the `pv_speaker_delete() function.
@@ -65,6 +270,42 @@ PV_API pv_speaker_status_t pv_speaker_init(
         int32_t device_index,
         pv_speaker_t **object);
 
+/**
+* Sets all fields of the given configuration to their defaults, and its `version` to PV_SPEAKER_CONFIG_VERSION. It is
+* compiled into the caller, so that it only ever touches the fields of the struct the caller was built with, and
+* stamps the version of that struct even when running against a newer library.
+*
+* @param[out] config Configuration to initialize.
+* @return Status Code. Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT on failure.
+*/
+static inline pv_speaker_status_t pv_speaker_config_init(pv_speaker_config_t *config) {
+    if (!config) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+
+    memset(config, 0, sizeof(pv_speaker_config_t));
+    config->version = PV_SPEAKER_CONFIG_VERSION;
+    config->device_index = -1;
+    config->buffer_size_ms = 1000;
+    config->is_low_latency = true;
+    config->num_channels = 1;
+    config->resampler_quality = PV_SPEAKER_RESAMPLER_QUALITY_SINC;
+
+    return PV_SPEAKER_STATUS_SUCCESS;
+}
+
+/**
+* Creates a PvSpeaker instance from a configuration, which allows millisecond control over buffering and the audio
+* device's periods. When finished with the instance, resources should be released using the `pv_speaker_delete()`
+* function.
+*
+* @param config Configuration initialized with `pv_speaker_config_init()`.
+* @param[out] object PvSpeaker object to be initialized.
+* @return Status Code. PV_SPEAKER_STATUS_INVALID_ARGUMENT, PV_SPEAKER_STATUS_BACKEND_ERROR,
+* PV_SPEAKER_STATUS_DEVICE_INITIALIZED or PV_SPEAKER_STATUS_OUT_OF_MEMORY on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_init_ex(const pv_speaker_config_t *config, pv_speaker_t **object);
+
 /**
 * Releases resources acquired by PvSpeaker.
 *
@@ -82,6 +323,67 @@ PV_API void pv_speaker_delete(pv_speaker_t *object);
 */
 PV_API pv_speaker_status_t pv_speaker_start(pv_speaker_t *object);
 
+/**
+* Switches PvSpeaker to pull mode: instead of playing what is passed to `pv_speaker_write()`, the device asks
+* `render_callback` for each period of audio directly. This skips the internal circular buffer, so the latency is a
+* single device period. While a render callback is set, the write, flush and play file functions return
+* PV_SPEAKER_STATUS_INVALID_STATE. Passing NULL switches back to writing PCM data. Can only be called while stopped.
+*
+* @param object PvSpeaker object.
+* @param render_callback Callback that renders PCM data, or NULL.
+* @param user_data Pointer that is passed to `render_callback`.
+* @return Status Code. Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT or PV_SPEAKER_STATUS_INVALID_STATE on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_set_render_callback(
+        pv_speaker_t *object,
+        pv_speaker_render_callback_t render_callback,
+        void *user_data);
+
+/**
+* Size in bytes of the header of a shared buffer set with `pv_speaker_set_shared_buffer()`. The ring of frames follows
+* the header.
+*/
+#define PV_SPEAKER_SHARED_BUFFER_HEADER_SIZE (128)
+
+/**
+* Position of the write index among the 32-bit integers of a shared buffer header.
+*/
+#define PV_SPEAKER_SHARED_BUFFER_WRITE_INDEX (0)
+
+/**
+* Position of the read index among the 32-bit integers of a shared buffer header. It is on a cache line of its own.
+*/
+#define PV_SPEAKER_SHARED_BUFFER_READ_INDEX (16)
+
+/**
+* Replaces the internal circular buffer with one in memory owned by the caller, e.g. a JavaScript `SharedArrayBuffer`,
+* so that code outside of this library can write PCM data into it directly. The memory holds a header of
+* `PV_SPEAKER_SHARED_BUFFER_HEADER_SIZE` bytes followed by a ring of `length` frames. The header holds two 32-bit
+* indices that run over [0, 2 * `length`): the write index, which only the writer stores, and the read index, which
+* only the audio thread stores. Frames become playable once the writer stores the advanced write index with release
+* semantics, e.g. with `Atomics.store()`. The frame at write index `i` is at ring offset `i` modulo `length`. A write
+* index that is out of range, or more than `length` frames ahead of the read index, reads as an empty buffer. The audio
+* thread keeps its own copy of the read index and never reads it back from the header.
+*
+* The writer is the only source of PCM data while a shared buffer is set. `pv_speaker_write()`,
+* `pv_speaker_write_blocking()`, `pv_speaker_write_reserve()`, `pv_speaker_write_commit()` and
+* `pv_speaker_play_file()` return PV_SPEAKER_STATUS_INVALID_STATE, as do `pv_speaker_flush()` and
+* `pv_speaker_flush_timeout()` when given PCM data. Without PCM data they wait for the shared buffer to be played.
+* Frames written directly are not counted in `frames_written` of `pv_speaker_get_stats()` and are not recorded by
+* `pv_speaker_write_to_file()`. `pv_speaker_stop()` drops the frames left in the shared buffer by moving the read index
+* up to the write index, which it never stores. The buffer starts out empty at the write index found in the header.
+* Can only be called while stopped.
+*
+* @param object PvSpeaker object.
+* @param memory Memory of at least `PV_SPEAKER_SHARED_BUFFER_HEADER_SIZE` + `length` * frame size bytes, aligned to 4
+* bytes. It has to stay valid until PvSpeaker is deleted or another buffer is set. NULL switches back to the internal
+* circular buffer.
+* @param length Capacity of the ring in frames.
+* @return Status Code. Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT, PV_SPEAKER_STATUS_INVALID_STATE or
+* PV_SPEAKER_STATUS_OUT_OF_MEMORY on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_set_shared_buffer(pv_speaker_t *object, int8_t *memory, int32_t length);
+
 /**
 * Synchronous call to write PCM data to the internal circular buffer for audio playback.
 * Only writes as much PCM data as the internal circular buffer can currently fit.
@@ -96,6 +398,74 @@ PV_API pv_speaker_status_t pv_speaker_start(pv_speaker_t *object);
 */
 PV_API pv_speaker_status_t pv_speaker_write(pv_speaker_t *object, int8_t *pcm, int32_t pcm_length, int32_t *written_length);
 
+/**
+* Same as `pv_speaker_write()`, but waits for room in the internal circular buffer until all PCM data is written. The
+* calling thread sleeps until the audio callback has freed up room, so it does not spin while the buffer is full.
+* Unlike `pv_speaker_flush()`, it returns as soon as the last frame is buffered, without waiting for it to be played.
+*
+* @param object PvSpeaker object.
+* @param pcm Pointer to the PCM data that will be written.
+* @param pcm_length Length of the PCM data that is passed in.
+* @param timeout_ms Maximum time to wait in milliseconds, honoured even if the audio device stops calling back. A
+* negative value waits without a timeout.
+* @param written_length[out] Length of the PCM data that was successfully written. It is less than `pcm_length` if the
+* call timed out, or if `pv_speaker_stop()` or `pv_speaker_cancel()` was called meanwhile.
+* @return Status Code. Returns PV_SPEAKER_STATUS_TIMEOUT if the PCM data was not fully written in time. Returns
+* PV_SPEAKER_STATUS_INVALID_ARGUMENT, PV_SPEAKER_STATUS_INVALID_STATE or PV_SPEAKER_STATUS_RUNTIME_ERROR on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_write_blocking(
+        pv_speaker_t *object,
+        int8_t *pcm,
+        int32_t pcm_length,
+        int32_t timeout_ms,
+        int32_t *written_length);
+
+/**
+* Packs 24-bit samples that are stored in the low three bytes of 32-bit integers (e.g. an `int32` NumPy array) into the
+* 3-byte little-endian layout that `pv_speaker_write()` expects from a speaker with 24 bits per sample.
+*
+* @param pcm Pointer to the 32-bit samples.
+* @param pcm_length Number of samples.
+* @param packed_pcm[out] Pointer to at least `3 * pcm_length` bytes that receive the packed samples.
+* @return Status Code. Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_pack_int24(const int32_t *pcm, int32_t pcm_length, int8_t *packed_pcm);
+
+/**
+* Gets the writable regions of the internal circular buffer so that PCM data can be rendered into it directly, without
+* an intermediate copy. The free space is split in two regions when it wraps around the end of the circular buffer.
+* Call `pv_speaker_write_commit()` once the regions are filled. Reservations must not overlap with calls to
+* `pv_speaker_write()` or `pv_speaker_flush()`. Returns PV_SPEAKER_STATUS_INVALID_STATE while a shared buffer is set
+* with `pv_speaker_set_shared_buffer()`, so the regions are always in the internal circular buffer.
+*
+* @param object PvSpeaker object.
+* @param max_length The maximum number of samples to reserve.
+* @param pcm1[out] Start of the first writable region.
+* @param pcm1_length[out] Number of samples that fit in the first region.
+* @param pcm2[out] Start of the second writable region, or NULL if the free space does not wrap around. Always NULL on
+* Linux, where the circular buffer is mirrored in virtual memory.
+* @param pcm2_length[out] Number of samples that fit in the second region.
+* @return Status Code. Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT, PV_SPEAKER_STATUS_INVALID_STATE or
+* PV_SPEAKER_STATUS_RUNTIME_ERROR on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_write_reserve(
+        pv_speaker_t *object,
+        int32_t max_length,
+        int8_t **pcm1,
+        int32_t *pcm1_length,
+        int8_t **pcm2,
+        int32_t *pcm2_length);
+
+/**
+* Queues samples previously rendered into the regions returned by `pv_speaker_write_reserve()` for playback.
+*
+* @param object PvSpeaker object.
+* @param length Number of samples to queue. Must not exceed the total reserved length.
+* @return Status Code. Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT, PV_SPEAKER_STATUS_INVALID_STATE or
+* PV_SPEAKER_STATUS_RUNTIME_ERROR on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_write_commit(pv_speaker_t *object, int32_t length);
+
 /**
 * Synchronous call to write PCM data to the internal circular buffer for audio playback.
 * This call blocks the thread until all PCM data have been successfully written and played.
@@ -110,6 +480,82 @@ PV_API pv_speaker_status_t pv_speaker_write(pv_speaker_t *object, int8_t *pcm, i
 */
 PV_API pv_speaker_status_t pv_speaker_flush(pv_speaker_t *object, int8_t *pcm, int32_t pcm_length, int32_t *written_length);
 
+/**
+* Same as `pv_speaker_flush()`, but gives up once `timeout_ms` milliseconds have passed. The timeout is honoured even if
+* the audio device stops calling back.
+*
+* @param object PvSpeaker object.
+* @param pcm Pointer to the PCM data that will be written.
+* @param pcm_length Length of the PCM data that is passed in.
+* @param timeout_ms Maximum time to wait for the PCM data to be written and played, in milliseconds.
+* @param written_length[out] Length of the PCM data that was successfully written.
+* @return Status Code. Returns PV_SPEAKER_STATUS_TIMEOUT if the PCM data was not fully written and played in time.
+* Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT, PV_SPEAKER_INVALID_STATE or PV_SPEAKER_IO_ERROR on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_flush_timeout(
+        pv_speaker_t *object,
+        int8_t *pcm,
+        int32_t pcm_length,
+        int32_t timeout_ms,
+        int32_t *written_length);
+
+/**
+* Requests a single call of `callback` once at least `length` frames fit into the internal circular buffer, so that a
+* writer can wait for room without blocking a thread. If there is room already, `callback` is called before this
+* function returns. Cancelling, stopping or deleting the PvSpeaker object calls a pending callback right away, e.g. for
+* the waiter to check `pv_speaker_get_is_started()`.
+*
+* @param object PvSpeaker object.
+* @param length Number of frames to wait room for. It is capped at the capacity of the internal circular buffer.
+* @param callback Callback to call once.
+* @param user_data Pointer that is passed to `callback`.
+* @return Status Code. Returns PV_SPEAKER_STATUS_INVALID_STATE if the speaker is not started, is in pull mode or has a
+* notification of this kind pending already. Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_notify_available(
+        pv_speaker_t *object,
+        int32_t length,
+        pv_speaker_notification_callback_t callback,
+        void *user_data);
+
+/**
+* Requests a single call of `callback` once all PCM data in the internal circular buffer has been passed to the audio
+* device, i.e. when `pv_speaker_flush()` would return. Cancelling, stopping or deleting the PvSpeaker object calls a
+* pending callback right away. It should not be combined with a `pv_speaker_flush()` running at the same time.
+*
+* @param object PvSpeaker object.
+* @param callback Callback to call once.
+* @param user_data Pointer that is passed to `callback`.
+* @return Status Code. Returns PV_SPEAKER_STATUS_INVALID_STATE if the speaker is not started, is in pull mode or has a
+* notification of this kind pending already. Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_notify_drained(
+        pv_speaker_t *object,
+        pv_speaker_notification_callback_t callback,
+        void *user_data);
+
+/**
+* Notification callback that signals a file descriptor, for event loops that wait on file descriptors instead of
+* running code on the audio thread. It writes a 64-bit count of 1, as an eventfd expects, to the descriptor stored in
+* `user_data` as `(void *) (intptr_t) fd`. An eventfd or the non-blocking write end of a pipe are suitable.
+*
+* @param user_data File descriptor to signal.
+*/
+PV_API void pv_speaker_signal_fd(void *user_data);
+
+/**
+* Plays a WAV file whose sample rate, bits per sample, number of channels and sample format match the ones PvSpeaker
+* was initialized with, and waits for it to finish like `pv_speaker_flush()`. The file is memory-mapped and fed to the
+* audio device as it plays, so start-up time and memory use do not depend on its length. Playback can be aborted by
+* calling `pv_speaker_stop()` from another thread.
+*
+* @param object PvSpeaker object.
+* @param input_wav_path Path to the WAV file to play.
+* @return Status Code. Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT if the file is not a supported WAV file,
+* PV_SPEAKER_STATUS_IO_ERROR if it cannot be read, or PV_SPEAKER_STATUS_INVALID_STATE on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_play_file(pv_speaker_t *object, const char *input_wav_path);
+
 /**
 * Stops the audio output device.
 *
@@ -118,6 +564,160 @@ PV_API pv_speaker_status_t pv_speaker_flush(pv_speaker_t *object, int8_t *pcm, i
 */
 PV_API pv_speaker_status_t pv_speaker_stop(pv_speaker_t *object);
 
+/**
+* Cancels playback of everything buffered so far without stopping the audio output device, e.g. for barge-in. The output
+* fades out over `fade_ms` milliseconds, the PCM data left after the fade is discarded, and a blocked
+* `pv_speaker_flush()` returns. Mixed streams keep playing. Returns after the audio device has dropped the data, which
+* takes at most `fade_ms` plus one device period. If the device stops calling back, it gives up after `fade_ms` plus a
+* few device periods (at least 100 ms), and the data buffered before the call is dropped whenever the device calls back
+* again. PCM data written after the call is never dropped. Pending notifications are fired either way.
+*
+* @param object PvSpeaker object.
+* @param fade_ms Duration of the fade out in milliseconds. 0 cuts the output off at the next device period.
+* @param[out] discarded_length The number of frames that were discarded without being played. Together with
+* `frames_played` of `pv_speaker_get_stats()` it tells exactly how much of the written PCM data was heard. 0 if the
+* call timed out, since the data is only dropped later on.
+* @return Status Code. Returns PV_SPEAKER_STATUS_TIMEOUT if the audio device did not call back in time. Returns
+* PV_SPEAKER_STATUS_INVALID_ARGUMENT or PV_SPEAKER_STATUS_INVALID_STATE on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_cancel(pv_speaker_t *object, int32_t fade_ms, int32_t *discarded_length);
+
+/**
+* Pauses playback without stopping the audio output device. The output fades out over a few milliseconds and then stays
+* silent, and PCM data that has not been played yet stays buffered. `pv_speaker_write()` keeps accepting data until the
+* buffer is full, and `pv_speaker_flush()` waits until playback is resumed.
+*
+* @param object PvSpeaker object.
+* @return Status Code. Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT or PV_SPEAKER_STATUS_INVALID_STATE on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_pause(pv_speaker_t *object);
+
+/**
+* Resumes playback paused by `pv_speaker_pause()` from where it was paused, fading back in. The device keeps running
+* while paused, so playback resumes within one device period.
+*
+* @param object PvSpeaker object.
+* @return Status Code. Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT or PV_SPEAKER_STATUS_INVALID_STATE on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_resume(pv_speaker_t *object);
+
+/**
+* Creates a stream that is mixed into the output of a PvSpeaker object in mixer mode. Each stream has its own circular
+* buffer, sample rate, sample format and gain, and has the channel count of the PvSpeaker object. Streams are added to
+* and removed from the mix without blocking the audio thread.
+*
+* @param object PvSpeaker object. Must have been initialized with `is_mixer` set.
+* @param sample_rate The sample rate of the stream. It is resampled to the device rate if the two differ.
+* @param bits_per_sample The number of bits per sample.
+* @param is_float Whether samples are 32-bit IEEE floats. Requires `bits_per_sample` to be 32.
+* @param buffer_size_frames Capacity of the stream's circular buffer in frames.
+* @param stream[out] Stream object.
+* @return Status Code. Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT, PV_SPEAKER_STATUS_INVALID_STATE or
+* PV_SPEAKER_STATUS_OUT_OF_MEMORY on failure. PV_SPEAKER_STATUS_INVALID_STATE means that the object is not a mixer or
+* already plays PV_SPEAKER_MAX_STREAMS streams.
+*/
+PV_API pv_speaker_status_t pv_speaker_stream_init(
+        pv_speaker_t *object,
+        int32_t sample_rate,
+        int16_t bits_per_sample,
+        bool is_float,
+        int32_t buffer_size_frames,
+        pv_speaker_stream_t **stream);
+
+/**
+* Removes a stream from the mix and releases it. Waits for the audio thread to finish the period it is mixing, if
+* any. Frames still in the stream's buffer are dropped. Deleting the PvSpeaker object first detaches its streams, which
+* then still have to be released with this function.
+*
+* @param stream Stream object.
+*/
+PV_API void pv_speaker_stream_delete(pv_speaker_stream_t *stream);
+
+/**
+* Writes PCM data to the stream's circular buffer. Only writes as much PCM data as currently fits. Calls for the same
+* stream must not overlap, while different streams can be written from different threads.
+*
+* @param stream Stream object.
+* @param pcm Pointer to the PCM data that will be written.
+* @param pcm_length Length of the PCM data in frames.
+* @param written_length[out] Number of frames that were written.
+* @return Status Code. Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_stream_write(
+        pv_speaker_stream_t *stream,
+        const int8_t *pcm,
+        int32_t pcm_length,
+        int32_t *written_length);
+
+/**
+* Sets the gain a stream is mixed with. Takes effect from the next device period.
+*
+* @param stream Stream object.
+* @param gain Linear gain. 1 plays the stream unchanged and 0 mutes it.
+* @return Status Code. Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_stream_set_gain(pv_speaker_stream_t *stream, float gain);
+
+/**
+* Sets the output gain, which scales everything the device plays, streams included. The gain is applied in the audio
+* callback, and a change ramps linearly from the current gain over `ramp_ms` to avoid clicks. A gain of 0 mutes the
+* output; integer samples saturate when a gain above 1 would overflow them.
+*
+* @param object PvSpeaker object.
+* @param gain Linear gain. Defaults to 1.
+* @param ramp_ms Duration of the ramp to the new gain in milliseconds. 0 applies the gain from the next device period.
+* @return Status Code. Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_set_gain(pv_speaker_t *object, float gain, int32_t ramp_ms);
+
+/**
+* Gets playback statistics. The counters are updated with relaxed atomics, so they are cheap to keep on, but are not a
+* consistent snapshot of one instant.
+*
+* @param object PvSpeaker object.
+* @param[out] stats Playback statistics.
+* @return Status Code. Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_get_stats(pv_speaker_t *object, pv_speaker_stats_t *stats);
+
+/**
+* Gets the frame that is audible right now. It counts the frames passed to `pv_speaker_write()` and the other write
+* functions since initialization, including frames dropped by `pv_speaker_cancel()` or `pv_speaker_stop()`, so it is an
+* index into everything written. The audio callback records where playback is once per device period, and the
+* position is interpolated from there and corrected by the latency of the device's own buffer. Safe to call from any
+* thread at any rate.
+*
+* @param object PvSpeaker object.
+* @param[out] frames_played Index of the frame audible at `timestamp_ns`.
+* @param[out] timestamp_ns Time of the query on the monotonic clock (`CLOCK_MONOTONIC`, or `QueryPerformanceCounter()`
+* on Windows) in nanoseconds.
+* @return Status Code. Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_get_position(
+        pv_speaker_t *object,
+        int64_t *frames_played,
+        uint64_t *timestamp_ns);
+
+/**
+* Adds a marker that invokes `callback` once frame `frame_index` has been played, counted like `frames_played` of
+* `pv_speaker_get_position()`. Markers are checked once per device period, so the callback fires up to one period late.
+* Markers may be added in any order. Markers for frames dropped by `pv_speaker_cancel()` or `pv_speaker_stop()` are
+* dropped without being invoked.
+*
+* @param object PvSpeaker object.
+* @param frame_index Index of the frame to wait for. A frame that was played already fires in the next period.
+* @param callback Callback invoked from the audio thread. It must return quickly and must not call PvSpeaker functions
+* other than `pv_speaker_get_position()`.
+* @param user_data Pointer that is passed to `callback`.
+* @return Status Code. Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT, or PV_SPEAKER_STATUS_INVALID_STATE if
+* PV_SPEAKER_MAX_MARKERS markers are already waiting to be picked up by the audio thread.
+*/
+PV_API pv_speaker_status_t pv_speaker_add_marker(
+        pv_speaker_t *object,
+        int64_t frame_index,
+        pv_speaker_marker_callback_t callback,
+        void *user_data);
+
 /**
 * Gets whether the given `pv_speaker_t` instance has started and is available to receive PCM data.
 *
@@ -126,6 +726,14 @@ PV_API pv_speaker_status_t pv_speaker_stop(pv_speaker_t *object);
 */
 PV_API bool pv_speaker_get_is_started(pv_speaker_t *object);
 
+/**
+* Gets whether playback of the given `pv_speaker_t` instance is paused by `pv_speaker_pause()`.
+*
+* @param object PvSpeaker object.
+* @returns A boolean indicating whether playback is paused.
+*/
+PV_API bool pv_speaker_get_is_paused(pv_speaker_t *object);
+
 /**
 * Gets the audio device that the given `pv_speaker_t` instance is using.
 *
@@ -138,6 +746,10 @@ PV_API const char *pv_speaker_get_selected_device(pv_speaker_t *object);
 * Gets the list of available audio devices that can be used for playing audio.
 * Free the returned `device_list` array using `pv_speaker_free_device_list()`.
 *
+* The list is enumerated once and cached for the process, together with the audio backend context that all PvSpeaker
+* instances share. The cache is dropped when a device reports that the default output was rerouted. Call
+* `pv_speaker_refresh_available_devices()` to enumerate again after a device was plugged in or removed.
+*
 * @param[out] device_list_length The number of available audio devices.
 * @param[out] device_list The output array containing the list of available audio devices.
 * @return Status Code. Returns PV_SPEAKER_STATUS_OUT_OF_MEMORY, PV_SPEAKER_STATUS_BACKEND_ERROR or
@@ -147,6 +759,15 @@ PV_API pv_speaker_status_t pv_speaker_get_available_devices(
         int32_t *device_list_length,
         char ***device_list);
 
+/**
+* Enumerates the audio devices again and replaces the cached list that `pv_speaker_get_available_devices()` and
+* `pv_speaker_init()` use to look up device indices.
+*
+* @return Status Code. Returns PV_SPEAKER_STATUS_OUT_OF_MEMORY, PV_SPEAKER_STATUS_BACKEND_ERROR or
+* PV_SPEAKER_STATUS_INVALID_STATE on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_refresh_available_devices(void);
+
 /**
 * Frees the device list initialized by `pv_speaker_get_available_devices()`.
 *
@@ -173,13 +794,41 @@ PV_API const char *pv_speaker_status_to_string(pv_speaker_status_t status);
 PV_API const char *pv_speaker_version(void);
 
 /**
-* Writes PCM data passed to PvSpeaker to a specified WAV file.
+* Writes PCM data passed to PvSpeaker to a specified WAV file. The data is written by a background thread in large
+* batches, so a slow disk does not stall `pv_speaker_write()` or playback. The file is finalized by
+* `pv_speaker_stop()` or `pv_speaker_delete()`.
 *
 * @param object PvSpeaker object.
 * @param output_wav_path Path to the output WAV file where the PCM data will be written.
-* @return Status Code. Returns PV_SPEAKER_STATUS_RUNTIME_ERROR or PV_SPEAKER_STATUS_INVALID_ARGUMENT on failure.
+* @return Status Code. Returns PV_SPEAKER_STATUS_RUNTIME_ERROR, PV_SPEAKER_STATUS_OUT_OF_MEMORY or
+* PV_SPEAKER_STATUS_INVALID_ARGUMENT on failure.
 */
 
 PV_API pv_speaker_status_t pv_speaker_write_to_file(pv_speaker_t *object, const char *output_wav_path);
 
+/**
+* Sets what happens when PCM data is written faster than the WAV file writer can store it. With
+* PV_SPEAKER_FILE_OVERFLOW_POLICY_BLOCK (default) the write call waits for the file writer. With
+* PV_SPEAKER_FILE_OVERFLOW_POLICY_DROP the data that does not fit is left out of the file and counted by
+* `pv_speaker_get_file_dropped_bytes()`. Data is only ever dropped in whole frames, so the WAV file stays
+* frame-aligned. Playback is not affected by either policy.
+*
+* @param object PvSpeaker object.
+* @param policy Overflow policy.
+* @return Status Code. Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_set_file_overflow_policy(
+        pv_speaker_t *object,
+        pv_speaker_file_overflow_policy_t policy);
+
+/**
+* Gets the number of bytes of PCM data left out of the current WAV file by PV_SPEAKER_FILE_OVERFLOW_POLICY_DROP.
+* This is always a multiple of the frame size.
+*
+* @param object PvSpeaker object.
+* @param[out] dropped_bytes Number of dropped bytes.
+* @return Status Code. Returns PV_SPEAKER_STATUS_INVALID_ARGUMENT on failure.
+*/
+PV_API pv_speaker_status_t pv_speaker_get_file_dropped_bytes(pv_speaker_t *object, int64_t *dropped_bytes);
+
 #endif //PV_SPEAKER_H
\ No newline at end of file
@@ -431,6 +431,279 @@ napi_value napi_pv_speaker_flush(napi_env env, napi_callback_info info) {
     return object_js;
 }
 
+typedef struct {
+    napi_async_work work;
+    napi_deferred deferred;
+    pv_speaker_t *object;
+    int8_t *pcm;
+    int32_t num_samples;
+    bool is_flush;
+    int32_t written_length;
+    pv_speaker_status_t pv_speaker_status;
+} napi_pv_speaker_async_t;
+
+static void napi_pv_speaker_async_execute(napi_env env, void *data) {
+    (void) env;
+
+    napi_pv_speaker_async_t *async = (napi_pv_speaker_async_t *) data;
+    if (async->is_flush) {
+        async->pv_speaker_status = pv_speaker_flush(
+                async->object,
+                async->pcm,
+                async->num_samples,
+                &async->written_length);
+    } else {
+        async->pv_speaker_status = pv_speaker_write_blocking(
+                async->object,
+                async->pcm,
+                async->num_samples,
+                -1,
+                &async->written_length);
+    }
+}
+
+static void napi_pv_speaker_async_complete(napi_env env, napi_status status, void *data) {
+    napi_pv_speaker_async_t *async = (napi_pv_speaker_async_t *) data;
+
+    napi_value object_js = NULL;
+    napi_value status_js = NULL;
+    napi_value written_length_js = NULL;
+    if (status == napi_ok) {
+        status = napi_create_object(env, &object_js);
+    }
+    if (status == napi_ok) {
+        status = napi_create_int32(env, async->pv_speaker_status, &status_js);
+    }
+    if (status == napi_ok) {
+        status = napi_set_named_property(env, object_js, "status", status_js);
+    }
+    if (status == napi_ok) {
+        status = napi_create_int32(env, async->written_length, &written_length_js);
+    }
+    if (status == napi_ok) {
+        status = napi_set_named_property(env, object_js, "written_length", written_length_js);
+    }
+
+    if (status == napi_ok) {
+        napi_resolve_deferred(env, async->deferred, object_js);
+    } else {
+        napi_value code_js = NULL;
+        napi_value message_js = NULL;
+        napi_value error_js = NULL;
+        napi_create_string_utf8(
+                env,
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_RUNTIME_ERROR),
+                NAPI_AUTO_LENGTH,
+                &code_js);
+        napi_create_string_utf8(env, "Unable to allocate memory for the async result", NAPI_AUTO_LENGTH, &message_js);
+        napi_create_error(env, code_js, message_js, &error_js);
+        napi_reject_deferred(env, async->deferred, error_js);
+    }
+
+    napi_delete_async_work(env, async->work);
+    free(async->pcm);
+    free(async);
+}
+
+static napi_value napi_pv_speaker_queue_async(napi_env env, napi_callback_info info, bool is_flush) {
+    size_t argc = 3;
+    napi_value args[argc];
+    napi_status status = napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+    if (status != napi_ok) {
+        napi_throw_error(
+                env,
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_RUNTIME_ERROR),
+                "Unable to get input arguments");
+        return NULL;
+    }
+
+    uint64_t object_id = 0;
+    bool lossless = false;
+    status = napi_get_value_bigint_uint64(env, args[0], &object_id, &lossless);
+    if ((status != napi_ok) || !lossless) {
+        napi_throw_error(
+                env,
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_RUNTIME_ERROR),
+                "Unable to get the address of the instance of PvSpeaker properly");
+        return NULL;
+    }
+
+    int32_t bits_per_sample;
+    status = napi_get_value_int32(env, args[1], &bits_per_sample);
+    if (status != napi_ok) {
+        napi_throw_error(
+                env,
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT),
+                "Unable to get the bits per sample");
+        return NULL;
+    }
+
+    void* data = NULL;
+    size_t byte_length = 0;
+    status = napi_get_arraybuffer_info(env, args[2], &data, &byte_length);
+    if (status != napi_ok) {
+        napi_throw_error(
+                env,
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_RUNTIME_ERROR),
+                "Unable to get buffer");
+        return NULL;
+    }
+
+    napi_pv_speaker_async_t *async = calloc(1, sizeof(napi_pv_speaker_async_t));
+    if (!async) {
+        napi_throw_error(
+                env,
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_OUT_OF_MEMORY),
+                "Unable to allocate memory for the async call");
+        return NULL;
+    }
+
+    // the worker thread reads the PCM data after this call returns, while JavaScript is free to reuse the buffer
+    async->pcm = malloc(byte_length > 0 ? byte_length : 1);
+    if (!async->pcm) {
+        free(async);
+        napi_throw_error(
+                env,
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_OUT_OF_MEMORY),
+                "Unable to allocate memory for the async call");
+        return NULL;
+    }
+    if (byte_length > 0) {
+        memcpy(async->pcm, data, byte_length);
+    }
+    async->object = (pv_speaker_t *)(uintptr_t) object_id;
+    async->num_samples = (int32_t) byte_length / (bits_per_sample / 8);
+    async->is_flush = is_flush;
+
+    napi_value promise_js = NULL;
+    napi_value resource_name_js = NULL;
+    status = napi_create_promise(env, &async->deferred, &promise_js);
+    if (status == napi_ok) {
+        status = napi_create_string_utf8(
+                env,
+                is_flush ? "PvSpeakerFlush" : "PvSpeakerWrite",
+                NAPI_AUTO_LENGTH,
+                &resource_name_js);
+    }
+    if (status == napi_ok) {
+        status = napi_create_async_work(
+                env,
+                NULL,
+                resource_name_js,
+                napi_pv_speaker_async_execute,
+                napi_pv_speaker_async_complete,
+                async,
+                &async->work);
+    }
+    if (status == napi_ok) {
+        status = napi_queue_async_work(env, async->work);
+        if (status != napi_ok) {
+            napi_delete_async_work(env, async->work);
+        }
+    }
+    if (status != napi_ok) {
+        free(async->pcm);
+        free(async);
+        napi_throw_error(
+                env,
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_RUNTIME_ERROR),
+                "Unable to queue the async call");
+        return NULL;
+    }
+
+    return promise_js;
+}
+
+napi_value napi_pv_speaker_write_async(napi_env env, napi_callback_info info) {
+    return napi_pv_speaker_queue_async(env, info, false);
+}
+
+napi_value napi_pv_speaker_flush_async(napi_env env, napi_callback_info info) {
+    return napi_pv_speaker_queue_async(env, info, true);
+}
+
+napi_value napi_pv_speaker_set_shared_buffer(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[argc];
+    napi_status status = napi_get_cb_info(env, info, &argc, args, NULL, NULL);
+    if (status != napi_ok) {
+        napi_throw_error(
+                env,
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_RUNTIME_ERROR),
+                "Unable to get input arguments");
+        return NULL;
+    }
+
+    uint64_t object_id = 0;
+    bool lossless = false;
+    status = napi_get_value_bigint_uint64(env, args[0], &object_id, &lossless);
+    if ((status != napi_ok) || !lossless) {
+        napi_throw_error(
+                env,
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_RUNTIME_ERROR),
+                "Unable to get the address of the instance of PvSpeaker properly");
+        return NULL;
+    }
+
+    int32_t bits_per_sample = 0;
+    status = napi_get_value_int32(env, args[1], &bits_per_sample);
+    if ((status != napi_ok) || (bits_per_sample <= 0) || ((bits_per_sample % 8) != 0)) {
+        napi_throw_error(
+                env,
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT),
+                "Unable to get the bits per sample");
+        return NULL;
+    }
+
+    // a view of the `SharedArrayBuffer`, or null to switch back to the internal buffer. The length of the ring is
+    // derived from the size of the view so that it can never run past the end of the buffer. Keeping the buffer alive
+    // is up to the caller.
+    void *data = NULL;
+    size_t byte_length = 0;
+    napi_valuetype type;
+    status = napi_typeof(env, args[2], &type);
+    if ((status == napi_ok) && (type != napi_null)) {
+        status = napi_get_typedarray_info(env, args[2], NULL, &byte_length, &data, NULL, NULL);
+    }
+    if (status != napi_ok) {
+        napi_throw_error(
+                env,
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_RUNTIME_ERROR),
+                "Unable to get shared buffer");
+        return NULL;
+    }
+
+    int32_t length = 0;
+    if (data != NULL) {
+        if (byte_length <= PV_SPEAKER_SHARED_BUFFER_HEADER_SIZE) {
+            napi_throw_error(
+                    env,
+                    pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT),
+                    "Shared buffer is too small");
+            return NULL;
+        }
+        size_t num_samples = (byte_length - PV_SPEAKER_SHARED_BUFFER_HEADER_SIZE) / (size_t) (bits_per_sample / 8);
+        length = (num_samples > (INT32_MAX / 2)) ? (INT32_MAX / 2) : (int32_t) num_samples;
+    }
+
+    pv_speaker_status_t pv_speaker_status = pv_speaker_set_shared_buffer(
+            (pv_speaker_t *)(uintptr_t) object_id,
+            (int8_t *) data,
+            length);
+
+    napi_value result;
+    status = napi_create_int32(env, pv_speaker_status, &result);
+    if (status != napi_ok) {
+        napi_throw_error(
+                env,
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_RUNTIME_ERROR),
+                "Unable to allocate memory for the set shared buffer result");
+        return NULL;
+    }
+
+    return result;
+}
+
 napi_value napi_pv_speaker_get_is_started(napi_env env, napi_callback_info info) {
     size_t argc = 1;
     napi_value args[argc];
@@ -668,6 +941,18 @@ napi_value Init(napi_env env, napi_value exports) {
     status = napi_define_properties(env, exports, 1, &desc);
     assert(status == napi_ok);
 
+    desc = DECLARE_NAPI_METHOD("write_async", napi_pv_speaker_write_async);
+    status = napi_define_properties(env, exports, 1, &desc);
+    assert(status == napi_ok);
+
+    desc = DECLARE_NAPI_METHOD("flush_async", napi_pv_speaker_flush_async);
+    status = napi_define_properties(env, exports, 1, &desc);
+    assert(status == napi_ok);
+
+    desc = DECLARE_NAPI_METHOD("set_shared_buffer", napi_pv_speaker_set_shared_buffer);
+    status = napi_define_properties(env, exports, 1, &desc);
+    assert(status == napi_ok);
+
     desc = DECLARE_NAPI_METHOD("get_is_started", napi_pv_speaker_get_is_started);
     status = napi_define_properties(env, exports, 1, &desc);
     assert(status == napi_ok);
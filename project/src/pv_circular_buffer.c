@@ -12,22 +12,104 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__PV_SPEAKER_PLATFORM_LINUX__) || defined(__PV_SPEAKER_PLATFORM_RASPBERRYPI__)
+
+#define PV_CIRCULAR_BUFFER_MIRRORING
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#endif
+
 #include "pv_circular_buffer.h"
 
+#define PV_CIRCULAR_BUFFER_CACHE_LINE_SIZE (64)
+#define PV_CIRCULAR_BUFFER_INDEX_STRIDE (PV_CIRCULAR_BUFFER_CACHE_LINE_SIZE / sizeof(int32_t))
+
+// Single-producer/single-consumer ring. `write_index` is only stored by the producer and `read_index` only by the
+// consumer, so neither side needs a lock. Both indices run over [0, 2 * size) which tells a full buffer apart from an
+// empty one without a shared counter. They live on separate cache lines to avoid false sharing between the threads.
+// `size` is the length of the ring itself and `capacity` the most elements it holds at once. They only differ for
+// mirrored buffers, whose ring is rounded up to whole pages. External buffers keep the ring and both indices in memory
+// owned by the caller. There `write_index` points to the caller's write index, while the consumer keeps its own copy of
+// the read index in `indices` and only publishes it to `published_read_index`, which is never read back.
 struct pv_circular_buffer {
     void *buffer;
     int32_t capacity;
-    int32_t count;
+    int32_t size;
     int32_t element_size;
-    int32_t read_index;
-    int32_t write_index;
+    bool is_mirrored;
+    bool is_external;
+    int32_t *write_index;
+    int32_t *read_index;
+    int32_t *published_read_index;
+    int8_t padding[PV_CIRCULAR_BUFFER_CACHE_LINE_SIZE];
+    int32_t indices[2 * PV_CIRCULAR_BUFFER_INDEX_STRIDE];
 };
 
+static inline int32_t pv_circular_buffer_offset(const pv_circular_buffer_t *object, int32_t index) {
+    return (index < object->size) ? index : (index - object->size);
+}
+
+static inline int32_t pv_circular_buffer_advance(const pv_circular_buffer_t *object, int32_t index, int32_t length) {
+    index += length;
+    return (index < (2 * object->size)) ? index : (index - (2 * object->size));
+}
+
+// number of elements that can be accessed in one piece starting at `offset`
+static inline int32_t pv_circular_buffer_contiguous(const pv_circular_buffer_t *object, int32_t offset) {
+    return object->is_mirrored ? object->size : (object->size - offset);
+}
+
+static inline int32_t pv_circular_buffer_distance(
+        const pv_circular_buffer_t *object,
+        int32_t write_index,
+        int32_t read_index) {
+    const int32_t distance = write_index - read_index;
+    return (distance >= 0) ? distance : (distance + (2 * object->size));
+}
+
+static inline bool pv_circular_buffer_is_valid_index(const pv_circular_buffer_t *object, int32_t index) {
+    return (index >= 0) && (index < (2 * object->size));
+}
+
+// the producer of an external buffer may run outside of this library, so every write index loaded from the caller's
+// memory is checked before it is used. The read index is the consumer's own copy and always valid.
+static inline bool pv_circular_buffer_is_valid_write_index(
+        const pv_circular_buffer_t *object,
+        int32_t write_index,
+        int32_t read_index) {
+    return !object->is_external ||
+           (pv_circular_buffer_is_valid_index(object, write_index) &&
+            (pv_circular_buffer_distance(object, write_index, read_index) <= object->capacity));
+}
+
+// an invalid write index is treated as an empty buffer, so the consumer never reads out of bounds
+static inline int32_t pv_circular_buffer_check_write_index(
+        const pv_circular_buffer_t *object,
+        int32_t write_index,
+        int32_t read_index) {
+    return pv_circular_buffer_is_valid_write_index(object, write_index, read_index) ? write_index : read_index;
+}
+
+static inline void pv_circular_buffer_store_read_index(pv_circular_buffer_t *object, int32_t read_index) {
+    __atomic_store_n(object->read_index, read_index, __ATOMIC_RELEASE);
+    if (object->published_read_index != NULL) {
+        __atomic_store_n(object->published_read_index, read_index, __ATOMIC_RELEASE);
+    }
+}
+
+static void pv_circular_buffer_use_own_indices(pv_circular_buffer_t *object) {
+    object->write_index = &object->indices[0];
+    object->read_index = &object->indices[PV_CIRCULAR_BUFFER_INDEX_STRIDE];
+}
+
 pv_circular_buffer_status_t pv_circular_buffer_init(
         int32_t element_count,
         int32_t element_size,
         pv_circular_buffer_t **object) {
-    if (element_count <= 0) {
+    if ((element_count <= 0) || (element_count > (INT32_MAX / 2))) {
         return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
     }
     if (element_size <= 0) {
@@ -44,14 +126,155 @@ pv_circular_buffer_status_t pv_circular_buffer_init(
         return PV_CIRCULAR_BUFFER_STATUS_OUT_OF_MEMORY;
     }
 
-    o->buffer = malloc(element_count * element_size);
+    o->buffer = malloc((size_t) element_count * (size_t) element_size);
     if (!(o->buffer)) {
         pv_circular_buffer_delete(o);
         return PV_CIRCULAR_BUFFER_STATUS_OUT_OF_MEMORY;
     }
 
     o->capacity = element_count;
+    o->size = element_count;
+    o->element_size = element_size;
+    pv_circular_buffer_use_own_indices(o);
+
+    *object = o;
+
+    return PV_CIRCULAR_BUFFER_STATUS_SUCCESS;
+}
+
+#if defined(PV_CIRCULAR_BUFFER_MIRRORING)
+
+static size_t pv_circular_buffer_gcd(size_t a, size_t b) {
+    while (b != 0) {
+        const size_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+pv_circular_buffer_status_t pv_circular_buffer_init_mirrored(
+        int32_t element_count,
+        int32_t element_size,
+        pv_circular_buffer_t **object) {
+    if ((element_count <= 0) || (element_count > (INT32_MAX / 2))) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
+    if (element_size <= 0) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!object) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
+
+    *object = NULL;
+
+    // the ring has to be a whole number of pages and of elements at the same time
+    const long page_size = sysconf(_SC_PAGESIZE);
+    if (page_size <= 0) {
+        return PV_CIRCULAR_BUFFER_STATUS_OUT_OF_MEMORY;
+    }
+    const size_t unit = ((size_t) page_size / pv_circular_buffer_gcd((size_t) page_size, (size_t) element_size)) * (size_t) element_size;
+    const size_t requested = (size_t) element_count * (size_t) element_size;
+    const size_t num_bytes = ((requested + unit - 1) / unit) * unit;
+    if ((num_bytes / (size_t) element_size) > (INT32_MAX / 2)) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
+
+    pv_circular_buffer_t *o = calloc(1, sizeof(pv_circular_buffer_t));
+    if (!o) {
+        return PV_CIRCULAR_BUFFER_STATUS_OUT_OF_MEMORY;
+    }
+
+    const int fd = (int) syscall(SYS_memfd_create, "pv_circular_buffer", 0);
+    if (fd < 0) {
+        free(o);
+        return PV_CIRCULAR_BUFFER_STATUS_OUT_OF_MEMORY;
+    }
+    if (ftruncate(fd, (off_t) num_bytes) != 0) {
+        close(fd);
+        free(o);
+        return PV_CIRCULAR_BUFFER_STATUS_OUT_OF_MEMORY;
+    }
+
+    // reserve twice the address space, then map the same pages into both halves
+    int8_t *address = mmap(NULL, 2 * num_bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (address == MAP_FAILED) {
+        close(fd);
+        free(o);
+        return PV_CIRCULAR_BUFFER_STATUS_OUT_OF_MEMORY;
+    }
+    if ((mmap(address, num_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) ||
+        (mmap(address + num_bytes, num_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)) {
+        munmap(address, 2 * num_bytes);
+        close(fd);
+        free(o);
+        return PV_CIRCULAR_BUFFER_STATUS_OUT_OF_MEMORY;
+    }
+    close(fd);
+
+    o->buffer = address;
+    o->capacity = element_count;
+    o->size = (int32_t) (num_bytes / (size_t) element_size);
+    o->element_size = element_size;
+    o->is_mirrored = true;
+    pv_circular_buffer_use_own_indices(o);
+
+    *object = o;
+
+    return PV_CIRCULAR_BUFFER_STATUS_SUCCESS;
+}
+
+#else
+
+pv_circular_buffer_status_t pv_circular_buffer_init_mirrored(
+        int32_t element_count,
+        int32_t element_size,
+        pv_circular_buffer_t **object) {
+    return pv_circular_buffer_init(element_count, element_size, object);
+}
+
+#endif
+
+pv_circular_buffer_status_t pv_circular_buffer_init_external(
+        int32_t element_count,
+        int32_t element_size,
+        void *buffer,
+        int32_t *write_index,
+        int32_t *read_index,
+        pv_circular_buffer_t **object) {
+    if ((element_count <= 0) || (element_count > (INT32_MAX / 2))) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
+    if (element_size <= 0) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!buffer || !write_index || !read_index) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!object) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
+
+    *object = NULL;
+
+    pv_circular_buffer_t *o = calloc(1, sizeof(pv_circular_buffer_t));
+    if (!o) {
+        return PV_CIRCULAR_BUFFER_STATUS_OUT_OF_MEMORY;
+    }
+
+    o->buffer = buffer;
+    o->capacity = element_count;
+    o->size = element_count;
     o->element_size = element_size;
+    o->is_external = true;
+    pv_circular_buffer_use_own_indices(o);
+    o->write_index = write_index;
+    o->published_read_index = read_index;
+
+    // the producer's index is left alone, and the buffer starts out empty at wherever the producer is
+    const int32_t initial_index = __atomic_load_n(write_index, __ATOMIC_ACQUIRE);
+    pv_circular_buffer_store_read_index(o, pv_circular_buffer_is_valid_index(o, initial_index) ? initial_index : 0);
 
     *object = o;
 
@@ -60,6 +283,21 @@ pv_circular_buffer_status_t pv_circular_buffer_init(
 
 void pv_circular_buffer_delete(pv_circular_buffer_t *object) {
     if (object) {
+        if (object->is_external) {
+            free(object);
+            return;
+        }
+
+#if defined(PV_CIRCULAR_BUFFER_MIRRORING)
+
+        if (object->is_mirrored) {
+            munmap(object->buffer, 2 * (size_t) object->size * (size_t) object->element_size);
+            free(object);
+            return;
+        }
+
+#endif
+
         free(object->buffer);
         free(object);
     }
@@ -76,41 +314,119 @@ pv_circular_buffer_status_t pv_circular_buffer_read(
     if (!buffer) {
         return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
     }
-    if (!buffer_length) {
-        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
-    }
-    if ((buffer_length <= 0) || (buffer_length > object->capacity)) {
+    if (buffer_length <= 0) {
         return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
     }
 
+    const int32_t read_index = __atomic_load_n(object->read_index, __ATOMIC_RELAXED);
+    const int32_t write_index = pv_circular_buffer_check_write_index(
+            object,
+            __atomic_load_n(object->write_index, __ATOMIC_ACQUIRE),
+            read_index);
+    const int32_t count = pv_circular_buffer_distance(object, write_index, read_index);
+    const int32_t offset = pv_circular_buffer_offset(object, read_index);
+
     void *dst_ptr = buffer;
-    const void *src_ptr = (int8_t *) object->buffer + (object->read_index * object->element_size);
+    const void *src_ptr = (int8_t *) object->buffer + (offset * object->element_size);
 
-    const int32_t available = object->capacity - object->read_index;
-    const int32_t max_copy = (object->count < buffer_length) ? object->count : buffer_length;
+    const int32_t available = pv_circular_buffer_contiguous(object, offset);
+    const int32_t max_copy = (count < buffer_length) ? count : buffer_length;
     const int32_t to_copy = (max_copy < available) ? max_copy : available;
 
     memcpy(dst_ptr, src_ptr, to_copy * object->element_size);
 
-    object->read_index = (object->read_index + to_copy) % object->capacity;
-
     const int32_t remaining = max_copy - to_copy;
     if (remaining > 0) {
         dst_ptr = (int8_t *) buffer + (to_copy * object->element_size);
         src_ptr = object->buffer;
 
         memcpy(dst_ptr, src_ptr, remaining * object->element_size);
-
-        object->read_index = remaining;
     }
 
-    object->count -= max_copy;
+    pv_circular_buffer_store_read_index(object, pv_circular_buffer_advance(object, read_index, max_copy));
 
     *read_length = max_copy;
 
     return PV_CIRCULAR_BUFFER_STATUS_SUCCESS;
 }
 
+pv_circular_buffer_status_t pv_circular_buffer_skip(
+        pv_circular_buffer_t *object,
+        int32_t length,
+        int32_t *skipped_length) {
+    if (!object) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
+    if (length < 0) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!skipped_length) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
+
+    const int32_t read_index = __atomic_load_n(object->read_index, __ATOMIC_RELAXED);
+    const int32_t write_index = pv_circular_buffer_check_write_index(
+            object,
+            __atomic_load_n(object->write_index, __ATOMIC_ACQUIRE),
+            read_index);
+    const int32_t count = pv_circular_buffer_distance(object, write_index, read_index);
+    const int32_t to_skip = (count < length) ? count : length;
+
+    pv_circular_buffer_store_read_index(object, pv_circular_buffer_advance(object, read_index, to_skip));
+
+    *skipped_length = to_skip;
+
+    return PV_CIRCULAR_BUFFER_STATUS_SUCCESS;
+}
+
+pv_circular_buffer_status_t pv_circular_buffer_get_write_position(pv_circular_buffer_t *object, int32_t *position) {
+    if (!object) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!position) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
+
+    const int32_t write_index = __atomic_load_n(object->write_index, __ATOMIC_ACQUIRE);
+    const int32_t read_index = __atomic_load_n(object->read_index, __ATOMIC_ACQUIRE);
+    *position = pv_circular_buffer_check_write_index(object, write_index, read_index);
+
+    return PV_CIRCULAR_BUFFER_STATUS_SUCCESS;
+}
+
+pv_circular_buffer_status_t pv_circular_buffer_skip_to(
+        pv_circular_buffer_t *object,
+        int32_t position,
+        int32_t *skipped_length) {
+    if (!object) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!pv_circular_buffer_is_valid_index(object, position)) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!skipped_length) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
+
+    const int32_t read_index = __atomic_load_n(object->read_index, __ATOMIC_RELAXED);
+    const int32_t write_index = pv_circular_buffer_check_write_index(
+            object,
+            __atomic_load_n(object->write_index, __ATOMIC_ACQUIRE),
+            read_index);
+    const int32_t count = pv_circular_buffer_distance(object, write_index, read_index);
+
+    // a position the consumer has read past lies further ahead than the producer, since the buffer never holds more
+    // than `capacity` elements
+    const int32_t distance = pv_circular_buffer_distance(object, position, read_index);
+    const int32_t to_skip = (distance <= count) ? distance : 0;
+
+    pv_circular_buffer_store_read_index(object, pv_circular_buffer_advance(object, read_index, to_skip));
+
+    *skipped_length = to_skip;
+
+    return PV_CIRCULAR_BUFFER_STATUS_SUCCESS;
+}
+
 pv_circular_buffer_status_t pv_circular_buffer_write(
         pv_circular_buffer_t *object,
         const void *buffer,
@@ -124,31 +440,91 @@ pv_circular_buffer_status_t pv_circular_buffer_write(
     if ((buffer_length <= 0) || (buffer_length > object->capacity)) {
         return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
     }
-    if (object->count + buffer_length > object->capacity) {
+
+    void *region1 = NULL;
+    int32_t region1_length = 0;
+    void *region2 = NULL;
+    int32_t region2_length = 0;
+    pv_circular_buffer_status_t status = pv_circular_buffer_write_reserve(
+            object,
+            buffer_length,
+            &region1,
+            &region1_length,
+            &region2,
+            &region2_length);
+    if (status != PV_CIRCULAR_BUFFER_STATUS_SUCCESS) {
+        return status;
+    }
+    if (region1_length + region2_length < buffer_length) {
         return PV_CIRCULAR_BUFFER_STATUS_WRITE_OVERFLOW;
     }
 
-    const int32_t available = object->capacity - object->write_index;
-    const int32_t to_copy = (buffer_length < available) ? buffer_length : available;
+    memcpy(region1, buffer, region1_length * object->element_size);
+    if (region2_length > 0) {
+        memcpy(region2, (const int8_t *) buffer + (region1_length * object->element_size), region2_length * object->element_size);
+    }
 
-    void *dst_ptr = (int8_t *) object->buffer + (object->write_index * object->element_size);
-    const void *src_ptr = buffer;
+    return pv_circular_buffer_write_commit(object, buffer_length);
+}
 
-    memcpy(dst_ptr, src_ptr, to_copy * object->element_size);
+pv_circular_buffer_status_t pv_circular_buffer_write_reserve(
+        pv_circular_buffer_t *object,
+        int32_t max_length,
+        void **region1,
+        int32_t *region1_length,
+        void **region2,
+        int32_t *region2_length) {
+    if (!object) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
+    if (max_length <= 0) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!region1 || !region1_length || !region2 || !region2_length) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
 
-    object->write_index = (object->write_index + to_copy) % object->capacity;
+    const int32_t write_index = __atomic_load_n(object->write_index, __ATOMIC_RELAXED);
+    const int32_t read_index = __atomic_load_n(object->read_index, __ATOMIC_ACQUIRE);
+    if (!pv_circular_buffer_is_valid_write_index(object, write_index, read_index)) {
+        // nothing can be reserved safely past an index that is out of range
+        *region1 = NULL;
+        *region1_length = 0;
+        *region2 = NULL;
+        *region2_length = 0;
+        return PV_CIRCULAR_BUFFER_STATUS_SUCCESS;
+    }
 
-    const int32_t remaining = buffer_length - to_copy;
-    if (remaining > 0) {
-        dst_ptr = (int8_t *) object->buffer + (object->write_index * object->element_size);
-        src_ptr = (int8_t *) buffer + (to_copy * object->element_size);
+    const int32_t available = object->capacity - pv_circular_buffer_distance(object, write_index, read_index);
+    const int32_t length = (max_length < available) ? max_length : available;
 
-        memcpy(dst_ptr, src_ptr, remaining * object->element_size);
+    const int32_t offset = pv_circular_buffer_offset(object, write_index);
+    const int32_t contiguous = pv_circular_buffer_contiguous(object, offset);
+
+    *region1 = (int8_t *) object->buffer + (offset * object->element_size);
+    *region1_length = (length < contiguous) ? length : contiguous;
+    *region2 = (length > contiguous) ? object->buffer : NULL;
+    *region2_length = (length > contiguous) ? (length - contiguous) : 0;
 
-        object->write_index = remaining;
+    return PV_CIRCULAR_BUFFER_STATUS_SUCCESS;
+}
+
+pv_circular_buffer_status_t pv_circular_buffer_write_commit(pv_circular_buffer_t *object, int32_t length) {
+    if (!object) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
+    if (length < 0) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
     }
 
-    object->count += buffer_length;
+    const int32_t write_index = __atomic_load_n(object->write_index, __ATOMIC_RELAXED);
+    const int32_t read_index = __atomic_load_n(object->read_index, __ATOMIC_ACQUIRE);
+    if (!pv_circular_buffer_is_valid_write_index(object, write_index, read_index) ||
+        (pv_circular_buffer_distance(object, write_index, read_index) + length > object->capacity)) {
+        return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
+    }
+
+    __atomic_store_n(object->write_index, pv_circular_buffer_advance(object, write_index, length), __ATOMIC_RELEASE);
 
     return PV_CIRCULAR_BUFFER_STATUS_SUCCESS;
 }
@@ -158,7 +534,10 @@ pv_circular_buffer_status_t pv_circular_buffer_get_available(pv_circular_buffer_
         return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
     }
 
-    *available = object->capacity - object->count;
+    const int32_t write_index = __atomic_load_n(object->write_index, __ATOMIC_ACQUIRE);
+    const int32_t read_index = __atomic_load_n(object->read_index, __ATOMIC_ACQUIRE);
+    const int32_t checked_write_index = pv_circular_buffer_check_write_index(object, write_index, read_index);
+    *available = object->capacity - pv_circular_buffer_distance(object, checked_write_index, read_index);
 
     return PV_CIRCULAR_BUFFER_STATUS_SUCCESS;
 }
@@ -168,15 +547,26 @@ pv_circular_buffer_status_t pv_circular_buffer_get_count(pv_circular_buffer_t *o
         return PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT;
     }
 
-    *count = object->count;
+    const int32_t write_index = __atomic_load_n(object->write_index, __ATOMIC_ACQUIRE);
+    const int32_t read_index = __atomic_load_n(object->read_index, __ATOMIC_ACQUIRE);
+    const int32_t checked_write_index = pv_circular_buffer_check_write_index(object, write_index, read_index);
+    *count = pv_circular_buffer_distance(object, checked_write_index, read_index);
 
     return PV_CIRCULAR_BUFFER_STATUS_SUCCESS;
 }
 
 void pv_circular_buffer_reset(pv_circular_buffer_t *object) {
-    object->count = 0;
-    object->read_index = 0;
-    object->write_index = 0;
+    if (object->is_external) {
+        // the write index belongs to the producer, so the consumer catches up with it instead
+        const int32_t read_index = __atomic_load_n(object->read_index, __ATOMIC_RELAXED);
+        const int32_t write_index = __atomic_load_n(object->write_index, __ATOMIC_ACQUIRE);
+        const int32_t checked_write_index = pv_circular_buffer_check_write_index(object, write_index, read_index);
+        pv_circular_buffer_store_read_index(object, checked_write_index);
+        return;
+    }
+
+    __atomic_store_n(object->read_index, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(object->write_index, 0, __ATOMIC_RELEASE);
 }
 
 const char *pv_circular_buffer_status_to_string(pv_circular_buffer_status_t status) {
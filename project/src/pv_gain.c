@@ -0,0 +1,290 @@
+/*
+    Copyright 2024 Picovoice Inc.
+
+    You may not use this file except in compliance with the license. A copy of the license is located in the "LICENSE"
+    file accompanying this source.
+
+    Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on
+    an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the
+    specific language governing permissions and limitations under the License.
+*/
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+
+#define PV_GAIN_X86
+
+#include <immintrin.h>
+
+#elif defined(__ARM_NEON)
+
+#define PV_GAIN_NEON
+
+#include <arm_neon.h>
+
+#endif
+
+#include "pv_gain.h"
+
+// Every kernel processes samples [start, end) and leaves the rest to the scalar tail, so that the vector loops need no
+// masking. The gain of sample `i` is computed as `gain + i * step` rather than accumulated, which keeps long ramps
+// exact to float precision.
+
+static inline float pv_gain_clamp(float x, float min, float max) {
+    return (x < min) ? min : ((x > max) ? max : x);
+}
+
+static void pv_gain_f32_scalar(float *pcm, int32_t start, int32_t end, float gain, float step) {
+    for (int32_t i = start; i < end; i++) {
+        pcm[i] *= gain + ((float) i * step);
+    }
+}
+
+static void pv_gain_s16_scalar(int16_t *pcm, int32_t start, int32_t end, float gain, float step) {
+    for (int32_t i = start; i < end; i++) {
+        const float y = (float) pcm[i] * (gain + ((float) i * step));
+        pcm[i] = (int16_t) lrintf(pv_gain_clamp(y, -32768.f, 32767.f));
+    }
+}
+
+#if defined(PV_GAIN_X86)
+
+static int32_t pv_gain_f32_sse2(float *pcm, int32_t length, float gain, float step) {
+    const __m128 lanes = _mm_set_ps(3.f, 2.f, 1.f, 0.f);
+    const __m128 steps = _mm_set1_ps(step);
+
+    int32_t i = 0;
+    for (; (i + 4) <= length; i += 4) {
+        const __m128 g = _mm_add_ps(_mm_set1_ps(gain + ((float) i * step)), _mm_mul_ps(lanes, steps));
+        _mm_storeu_ps(&pcm[i], _mm_mul_ps(_mm_loadu_ps(&pcm[i]), g));
+    }
+    return i;
+}
+
+static int32_t pv_gain_s16_sse2(int16_t *pcm, int32_t length, float gain, float step) {
+    const __m128 lanes_lo = _mm_set_ps(3.f, 2.f, 1.f, 0.f);
+    const __m128 lanes_hi = _mm_set_ps(7.f, 6.f, 5.f, 4.f);
+    const __m128 steps = _mm_set1_ps(step);
+    const __m128 min = _mm_set1_ps(-32768.f);
+    const __m128 max = _mm_set1_ps(32767.f);
+
+    int32_t i = 0;
+    for (; (i + 8) <= length; i += 8) {
+        const __m128i x = _mm_loadu_si128((const __m128i *) &pcm[i]);
+        const __m128i x_lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+        const __m128i x_hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+
+        const __m128 base = _mm_set1_ps(gain + ((float) i * step));
+        __m128 y_lo = _mm_mul_ps(_mm_cvtepi32_ps(x_lo), _mm_add_ps(base, _mm_mul_ps(lanes_lo, steps)));
+        __m128 y_hi = _mm_mul_ps(_mm_cvtepi32_ps(x_hi), _mm_add_ps(base, _mm_mul_ps(lanes_hi, steps)));
+
+        // `_mm_cvtps_epi32` turns products beyond the 32-bit range into INT32_MIN, so they are clamped first. It
+        // rounds to nearest like `lrintf()`.
+        y_lo = _mm_min_ps(_mm_max_ps(y_lo, min), max);
+        y_hi = _mm_min_ps(_mm_max_ps(y_hi, min), max);
+        const __m128i y = _mm_packs_epi32(_mm_cvtps_epi32(y_lo), _mm_cvtps_epi32(y_hi));
+        _mm_storeu_si128((__m128i *) &pcm[i], y);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static int32_t pv_gain_f32_avx2(float *pcm, int32_t length, float gain, float step) {
+    const __m256 lanes = _mm256_set_ps(7.f, 6.f, 5.f, 4.f, 3.f, 2.f, 1.f, 0.f);
+    const __m256 steps = _mm256_set1_ps(step);
+
+    int32_t i = 0;
+    for (; (i + 8) <= length; i += 8) {
+        const __m256 g = _mm256_add_ps(_mm256_set1_ps(gain + ((float) i * step)), _mm256_mul_ps(lanes, steps));
+        _mm256_storeu_ps(&pcm[i], _mm256_mul_ps(_mm256_loadu_ps(&pcm[i]), g));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static int32_t pv_gain_s16_avx2(int16_t *pcm, int32_t length, float gain, float step) {
+    const __m256 lanes_lo = _mm256_set_ps(7.f, 6.f, 5.f, 4.f, 3.f, 2.f, 1.f, 0.f);
+    const __m256 lanes_hi = _mm256_set_ps(15.f, 14.f, 13.f, 12.f, 11.f, 10.f, 9.f, 8.f);
+    const __m256 steps = _mm256_set1_ps(step);
+    const __m256 min = _mm256_set1_ps(-32768.f);
+    const __m256 max = _mm256_set1_ps(32767.f);
+
+    int32_t i = 0;
+    for (; (i + 16) <= length; i += 16) {
+        const __m256i x = _mm256_loadu_si256((const __m256i *) &pcm[i]);
+        const __m256i x_lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(x));
+        const __m256i x_hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(x, 1));
+
+        const __m256 base = _mm256_set1_ps(gain + ((float) i * step));
+        const __m256 g_lo = _mm256_add_ps(base, _mm256_mul_ps(lanes_lo, steps));
+        const __m256 g_hi = _mm256_add_ps(base, _mm256_mul_ps(lanes_hi, steps));
+        const __m256 y_lo = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(x_lo), g_lo), min), max);
+        const __m256 y_hi = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(x_hi), g_hi), min), max);
+
+        // `_mm256_packs_epi32` packs within 128-bit lanes, so the 64-bit quarters are put back in order afterwards
+        const __m256i y = _mm256_packs_epi32(_mm256_cvtps_epi32(y_lo), _mm256_cvtps_epi32(y_hi));
+        _mm256_storeu_si256((__m256i *) &pcm[i], _mm256_permute4x64_epi64(y, 0xD8));
+    }
+    return i;
+}
+
+static bool pv_gain_has_avx2(void) {
+    static int32_t has_avx2 = -1;
+
+    int32_t value = __atomic_load_n(&has_avx2, __ATOMIC_RELAXED);
+    if (value < 0) {
+        __builtin_cpu_init();
+        value = __builtin_cpu_supports("avx2") ? 1 : 0;
+        __atomic_store_n(&has_avx2, value, __ATOMIC_RELAXED);
+    }
+    return value == 1;
+}
+
+#elif defined(PV_GAIN_NEON)
+
+static int32_t pv_gain_f32_neon(float *pcm, int32_t length, float gain, float step) {
+    const float lanes_values[4] = {0.f, 1.f, 2.f, 3.f};
+    const float32x4_t lanes = vmulq_n_f32(vld1q_f32(lanes_values), step);
+
+    int32_t i = 0;
+    for (; (i + 4) <= length; i += 4) {
+        const float32x4_t g = vaddq_f32(vdupq_n_f32(gain + ((float) i * step)), lanes);
+        vst1q_f32(&pcm[i], vmulq_f32(vld1q_f32(&pcm[i]), g));
+    }
+    return i;
+}
+
+static inline int32x4_t pv_gain_round_neon(float32x4_t x) {
+
+#if defined(__aarch64__) || defined(__ARM_FEATURE_DIRECTED_ROUNDING)
+
+    return vcvtnq_s32_f32(x);
+
+#else
+
+    // rounds half away from zero, which differs from the scalar code only on exact halves
+    const float32x4_t half = vbslq_f32(vdupq_n_u32(0x80000000), x, vdupq_n_f32(0.5f));
+    return vcvtq_s32_f32(vaddq_f32(x, half));
+
+#endif
+
+}
+
+static int32_t pv_gain_s16_neon(int16_t *pcm, int32_t length, float gain, float step) {
+    const float lanes_values[8] = {0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f};
+    const float32x4_t lanes_lo = vmulq_n_f32(vld1q_f32(&lanes_values[0]), step);
+    const float32x4_t lanes_hi = vmulq_n_f32(vld1q_f32(&lanes_values[4]), step);
+
+    int32_t i = 0;
+    for (; (i + 8) <= length; i += 8) {
+        const int16x8_t x = vld1q_s16(&pcm[i]);
+        const float32x4_t x_lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(x)));
+        const float32x4_t x_hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(x)));
+
+        const float32x4_t base = vdupq_n_f32(gain + ((float) i * step));
+        const float32x4_t y_lo = vmulq_f32(x_lo, vaddq_f32(base, lanes_lo));
+        const float32x4_t y_hi = vmulq_f32(x_hi, vaddq_f32(base, lanes_hi));
+
+        // `vqmovn_s32` saturates to the 16-bit range
+        vst1q_s16(&pcm[i], vcombine_s16(vqmovn_s32(pv_gain_round_neon(y_lo)), vqmovn_s32(pv_gain_round_neon(y_hi))));
+    }
+    return i;
+}
+
+#endif
+
+static void pv_gain_f32(float *pcm, int32_t length, float gain, float step) {
+    int32_t i = 0;
+
+#if defined(PV_GAIN_X86)
+
+    i = pv_gain_has_avx2() ? pv_gain_f32_avx2(pcm, length, gain, step) : pv_gain_f32_sse2(pcm, length, gain, step);
+
+#elif defined(PV_GAIN_NEON)
+
+    i = pv_gain_f32_neon(pcm, length, gain, step);
+
+#endif
+
+    pv_gain_f32_scalar(pcm, i, length, gain, step);
+}
+
+static void pv_gain_s16(int16_t *pcm, int32_t length, float gain, float step) {
+    int32_t i = 0;
+
+#if defined(PV_GAIN_X86)
+
+    i = pv_gain_has_avx2() ? pv_gain_s16_avx2(pcm, length, gain, step) : pv_gain_s16_sse2(pcm, length, gain, step);
+
+#elif defined(PV_GAIN_NEON)
+
+    i = pv_gain_s16_neon(pcm, length, gain, step);
+
+#endif
+
+    pv_gain_s16_scalar(pcm, i, length, gain, step);
+}
+
+static void pv_gain_u8(uint8_t *pcm, int32_t length, float gain, float step) {
+    for (int32_t i = 0; i < length; i++) {
+        const float y = ((float) pcm[i] - 128.f) * (gain + ((float) i * step));
+        pcm[i] = (uint8_t) (lrintf(pv_gain_clamp(y, -128.f, 127.f)) + 128);
+    }
+}
+
+static void pv_gain_s24(uint8_t *pcm, int32_t length, float gain, float step) {
+    for (int32_t i = 0; i < length; i++) {
+        uint8_t *sample = &pcm[3 * i];
+        const int32_t x = (int32_t) (((uint32_t) sample[0] << 8) | ((uint32_t) sample[1] << 16) |
+                                     ((uint32_t) sample[2] << 24)) >> 8;
+        const float y = (float) x * (gain + ((float) i * step));
+        const int32_t z = (int32_t) lrintf(pv_gain_clamp(y, -8388608.f, 8388607.f));
+        sample[0] = (uint8_t) z;
+        sample[1] = (uint8_t) (z >> 8);
+        sample[2] = (uint8_t) (z >> 16);
+    }
+}
+
+static void pv_gain_s32(int32_t *pcm, int32_t length, float gain, float step) {
+    // floats cannot hold 32-bit samples exactly, so these go through doubles
+    for (int32_t i = 0; i < length; i++) {
+        double y = (double) pcm[i] * ((double) gain + ((double) i * step));
+        y = (y < -2147483648.0) ? -2147483648.0 : ((y > 2147483647.0) ? 2147483647.0 : y);
+        pcm[i] = (int32_t) llrint(y);
+    }
+}
+
+void pv_gain_apply(
+        void *pcm,
+        int32_t bits_per_sample,
+        bool is_float,
+        int32_t num_channels,
+        int32_t num_frames,
+        float gain,
+        float gain_step) {
+    const int32_t length = num_frames * num_channels;
+    const float step = gain_step / (float) num_channels;
+
+    switch (bits_per_sample) {
+        case 8:
+            pv_gain_u8((uint8_t *) pcm, length, gain, step);
+            break;
+        case 16:
+            pv_gain_s16((int16_t *) pcm, length, gain, step);
+            break;
+        case 24:
+            pv_gain_s24((uint8_t *) pcm, length, gain, step);
+            break;
+        case 32:
+            if (is_float) {
+                pv_gain_f32((float *) pcm, length, gain, step);
+            } else {
+                pv_gain_s32((int32_t *) pcm, length, gain, step);
+            }
+            break;
+        default:
+            break;
+    }
+}
@@ -0,0 +1,364 @@
+/*
+    Copyright 2024 Picovoice Inc.
+
+    You may not use this file except in compliance with the license. A copy of the license is located in the "LICENSE"
+    file accompanying this source.
+
+    Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on
+    an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the
+    specific language governing permissions and limitations under the License.
+*/
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE__)
+
+#include <xmmintrin.h>
+
+#elif defined(__ARM_NEON)
+
+#include <arm_neon.h>
+
+#endif
+
+#include "pv_resampler.h"
+
+#define PV_RESAMPLER_MAX_RATIO (64)
+#define PV_RESAMPLER_SINC_NUM_PHASES (128)
+#define PV_RESAMPLER_SINC_ZERO_CROSSINGS (16)
+#define PV_RESAMPLER_SINC_MAX_HALF_LENGTH (256)
+#define PV_RESAMPLER_SINC_ROLLOFF (0.95)
+#define PV_RESAMPLER_SINC_KAISER_BETA (8.0)
+
+// Input is kept planar so that every filter tap of a channel is contiguous. For output frame `n` the filter covers the
+// input frames `[position - (half_length - 1), position - (half_length - 1) + row_length)` where `position` is the
+// integer part of `n * input_sample_rate / output_sample_rate` and `fraction / output_sample_rate` is the fractional
+// part. The history starts with `half_length - 1` frames of silence so that the first output lines up with the first
+// input frame.
+struct pv_resampler {
+    pv_resampler_quality_t quality;
+    int32_t num_channels;
+    int32_t input_sample_rate;
+    int32_t output_sample_rate;
+    int32_t step;
+    int32_t fraction_step;
+
+    int32_t half_length;
+    int32_t row_length;
+    int32_t lookahead;
+    float *coefficients;
+
+    int32_t capacity;
+    float *history;
+    float *scratch;
+    int32_t length;
+    int32_t position;
+    int32_t fraction;
+};
+
+static int32_t pv_resampler_gcd(int32_t a, int32_t b) {
+    while (b != 0) {
+        int32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static double pv_resampler_bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int32_t k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < (sum * 1e-12)) {
+            break;
+        }
+    }
+    return sum;
+}
+
+static void pv_resampler_init_coefficients(pv_resampler_t *object, double cutoff) {
+    const double pi = 3.14159265358979323846;
+    const double window_scale = 1.0 / pv_resampler_bessel_i0(PV_RESAMPLER_SINC_KAISER_BETA);
+
+    for (int32_t phase = 0; phase <= PV_RESAMPLER_SINC_NUM_PHASES; phase++) {
+        float *row = &object->coefficients[phase * object->row_length];
+        const double t = (double) phase / PV_RESAMPLER_SINC_NUM_PHASES;
+
+        double sum = 0.0;
+        for (int32_t j = 0; j < (2 * object->half_length); j++) {
+            const double x = (double) (j - (object->half_length - 1)) - t;
+            const double r = x / object->half_length;
+            if (fabs(r) >= 1.0) {
+                row[j] = 0.f;
+                continue;
+            }
+
+            const double window = pv_resampler_bessel_i0(PV_RESAMPLER_SINC_KAISER_BETA * sqrt(1.0 - (r * r))) *
+                                  window_scale;
+            const double sinc = (x == 0.0) ? 1.0 : (sin(pi * cutoff * x) / (pi * cutoff * x));
+            const double h = cutoff * sinc * window;
+            row[j] = (float) h;
+            sum += h;
+        }
+
+        // Normalizing every phase keeps the passband gain flat across fractional positions.
+        for (int32_t j = 0; j < (2 * object->half_length); j++) {
+            row[j] = (float) (row[j] / sum);
+        }
+    }
+}
+
+static inline float pv_resampler_dot(const float *x, const float *h, int32_t length) {
+#if defined(__SSE__)
+
+    __m128 acc = _mm_setzero_ps();
+    for (int32_t i = 0; i < length; i += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(&x[i]), _mm_loadu_ps(&h[i])));
+    }
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 0x55));
+    return _mm_cvtss_f32(acc);
+
+#elif defined(__ARM_NEON)
+
+    float32x4_t acc = vdupq_n_f32(0.f);
+    for (int32_t i = 0; i < length; i += 4) {
+        acc = vmlaq_f32(acc, vld1q_f32(&x[i]), vld1q_f32(&h[i]));
+    }
+    float32x2_t sum = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    return vget_lane_f32(vpadd_f32(sum, sum), 0);
+
+#else
+
+    float acc[4] = {0.f, 0.f, 0.f, 0.f};
+    for (int32_t i = 0; i < length; i += 4) {
+        acc[0] += x[i] * h[i];
+        acc[1] += x[i + 1] * h[i + 1];
+        acc[2] += x[i + 2] * h[i + 2];
+        acc[3] += x[i + 3] * h[i + 3];
+    }
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+
+#endif
+}
+
+pv_resampler_status_t pv_resampler_init(
+        int32_t input_sample_rate,
+        int32_t output_sample_rate,
+        int32_t num_channels,
+        pv_resampler_quality_t quality,
+        pv_resampler_t **object) {
+    if (input_sample_rate <= 0) {
+        return PV_RESAMPLER_STATUS_INVALID_ARGUMENT;
+    }
+    if (output_sample_rate <= 0) {
+        return PV_RESAMPLER_STATUS_INVALID_ARGUMENT;
+    }
+    if ((input_sample_rate / output_sample_rate) >= PV_RESAMPLER_MAX_RATIO ||
+        (output_sample_rate / input_sample_rate) >= PV_RESAMPLER_MAX_RATIO) {
+        return PV_RESAMPLER_STATUS_INVALID_ARGUMENT;
+    }
+    if (num_channels <= 0) {
+        return PV_RESAMPLER_STATUS_INVALID_ARGUMENT;
+    }
+    if ((quality != PV_RESAMPLER_QUALITY_LINEAR) && (quality != PV_RESAMPLER_QUALITY_SINC)) {
+        return PV_RESAMPLER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!object) {
+        return PV_RESAMPLER_STATUS_INVALID_ARGUMENT;
+    }
+
+    *object = NULL;
+
+    pv_resampler_t *o = calloc(1, sizeof(pv_resampler_t));
+    if (!o) {
+        return PV_RESAMPLER_STATUS_OUT_OF_MEMORY;
+    }
+
+    const int32_t gcd = pv_resampler_gcd(input_sample_rate, output_sample_rate);
+    o->quality = quality;
+    o->num_channels = num_channels;
+    o->input_sample_rate = input_sample_rate / gcd;
+    o->output_sample_rate = output_sample_rate / gcd;
+    o->step = o->input_sample_rate / o->output_sample_rate;
+    o->fraction_step = o->input_sample_rate % o->output_sample_rate;
+
+    if (quality == PV_RESAMPLER_QUALITY_LINEAR) {
+        o->half_length = 1;
+        o->row_length = 2;
+    } else {
+        double cutoff = PV_RESAMPLER_SINC_ROLLOFF;
+        if (output_sample_rate < input_sample_rate) {
+            cutoff *= (double) output_sample_rate / input_sample_rate;
+        }
+
+        o->half_length = (int32_t) ceil(PV_RESAMPLER_SINC_ZERO_CROSSINGS / cutoff);
+        if (o->half_length > PV_RESAMPLER_SINC_MAX_HALF_LENGTH) {
+            o->half_length = PV_RESAMPLER_SINC_MAX_HALF_LENGTH;
+        }
+        // Rows are padded with zero taps to a multiple of four so that the dot product needs no scalar tail.
+        o->row_length = ((2 * o->half_length) + 3) & ~3;
+
+        o->coefficients = calloc((size_t) (PV_RESAMPLER_SINC_NUM_PHASES + 1) * (size_t) o->row_length, sizeof(float));
+        if (!o->coefficients) {
+            pv_resampler_delete(o);
+            return PV_RESAMPLER_STATUS_OUT_OF_MEMORY;
+        }
+        pv_resampler_init_coefficients(o, cutoff);
+    }
+    o->lookahead = o->row_length - (o->half_length - 1);
+
+    o->capacity = o->row_length + o->step + 1 + PV_RESAMPLER_MAX_SOURCE_FRAMES;
+    o->history = malloc((size_t) num_channels * (size_t) o->capacity * sizeof(float));
+    if (!o->history) {
+        pv_resampler_delete(o);
+        return PV_RESAMPLER_STATUS_OUT_OF_MEMORY;
+    }
+
+    o->scratch = malloc((size_t) num_channels * PV_RESAMPLER_MAX_SOURCE_FRAMES * sizeof(float));
+    if (!o->scratch) {
+        pv_resampler_delete(o);
+        return PV_RESAMPLER_STATUS_OUT_OF_MEMORY;
+    }
+
+    pv_resampler_reset(o);
+
+    *object = o;
+
+    return PV_RESAMPLER_STATUS_SUCCESS;
+}
+
+void pv_resampler_delete(pv_resampler_t *object) {
+    if (object) {
+        free(object->scratch);
+        free(object->history);
+        free(object->coefficients);
+        free(object);
+    }
+}
+
+static bool pv_resampler_fill(pv_resampler_t *object, pv_resampler_source_t source, void *context) {
+    const int32_t num_channels = object->num_channels;
+
+    int32_t drop = object->position - (object->half_length - 1);
+    if (drop > object->length) {
+        drop = object->length;
+    }
+    if (drop > 0) {
+        for (int32_t c = 0; c < num_channels; c++) {
+            float *history = &object->history[c * object->capacity];
+            memmove(history, &history[drop], (size_t) (object->length - drop) * sizeof(float));
+        }
+        object->length -= drop;
+        object->position -= drop;
+    }
+
+    int32_t max_length = object->capacity - object->length;
+    if (max_length > PV_RESAMPLER_MAX_SOURCE_FRAMES) {
+        max_length = PV_RESAMPLER_MAX_SOURCE_FRAMES;
+    }
+
+    const int32_t length = source(context, object->scratch, max_length);
+    if (length <= 0) {
+        return false;
+    }
+
+    for (int32_t c = 0; c < num_channels; c++) {
+        float *history = &object->history[(c * object->capacity) + object->length];
+        for (int32_t i = 0; i < length; i++) {
+            history[i] = object->scratch[(i * num_channels) + c];
+        }
+    }
+    object->length += length;
+
+    return true;
+}
+
+int32_t pv_resampler_read(
+        pv_resampler_t *object,
+        float *output,
+        int32_t output_length,
+        pv_resampler_source_t source,
+        void *context) {
+    const int32_t num_channels = object->num_channels;
+    const int32_t capacity = object->capacity;
+    const int32_t row_length = object->row_length;
+    const float output_scale = 1.f / (float) object->output_sample_rate;
+
+    int32_t produced = 0;
+    while (produced < output_length) {
+        if ((object->position + object->lookahead) > object->length) {
+            if (!pv_resampler_fill(object, source, context)) {
+                break;
+            }
+            continue;
+        }
+
+        const int32_t start = object->position - (object->half_length - 1);
+        float *frame = &output[produced * num_channels];
+
+        if (object->quality == PV_RESAMPLER_QUALITY_LINEAR) {
+            const float t = (float) object->fraction * output_scale;
+            for (int32_t c = 0; c < num_channels; c++) {
+                const float *x = &object->history[(c * capacity) + start];
+                frame[c] = x[0] + ((x[1] - x[0]) * t);
+            }
+        } else {
+            const int64_t scaled = (int64_t) object->fraction * PV_RESAMPLER_SINC_NUM_PHASES;
+            const int32_t phase = (int32_t) (scaled / object->output_sample_rate);
+            const float w = (float) (scaled % object->output_sample_rate) * output_scale;
+            const float *row0 = &object->coefficients[phase * row_length];
+            const float *row1 = &row0[row_length];
+            for (int32_t c = 0; c < num_channels; c++) {
+                const float *x = &object->history[(c * capacity) + start];
+                const float a = pv_resampler_dot(x, row0, row_length);
+                const float b = pv_resampler_dot(x, row1, row_length);
+                frame[c] = a + ((b - a) * w);
+            }
+        }
+        produced++;
+
+        object->position += object->step;
+        object->fraction += object->fraction_step;
+        if (object->fraction >= object->output_sample_rate) {
+            object->fraction -= object->output_sample_rate;
+            object->position++;
+        }
+    }
+
+    return produced;
+}
+
+int32_t pv_resampler_get_lookahead(const pv_resampler_t *object) {
+    return object->lookahead;
+}
+
+void pv_resampler_reset(pv_resampler_t *object) {
+    if (!object) {
+        return;
+    }
+
+    memset(object->history, 0, (size_t) object->num_channels * (size_t) object->capacity * sizeof(float));
+    object->length = object->half_length - 1;
+    object->position = object->half_length - 1;
+    object->fraction = 0;
+}
+
+const char *pv_resampler_status_to_string(pv_resampler_status_t status) {
+    static const char *const STRINGS[] = {
+            "SUCCESS",
+            "OUT_OF_MEMORY",
+            "INVALID_ARGUMENT"};
+
+    int32_t size = sizeof(STRINGS) / sizeof(STRINGS[0]);
+    if (status < PV_RESAMPLER_STATUS_SUCCESS || status >= (PV_RESAMPLER_STATUS_SUCCESS + size)) {
+        return NULL;
+    }
+
+    return STRINGS[status - PV_RESAMPLER_STATUS_SUCCESS];
+}
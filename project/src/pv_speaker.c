@@ -19,59 +19,2539 @@
 
 #pragma GCC diagnostic pop
 
+#include <math.h>
+
+#if defined(__PV_SPEAKER_PLATFORM_WINDOWS__)
+
+#include <io.h>
+
+#else
+
+#include <pthread.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#endif
+
+#if defined(__PV_SPEAKER_PLATFORM_LINUX__) || defined(__PV_SPEAKER_PLATFORM_RASPBERRYPI__)
+
+#include <fcntl.h>
+
+#endif
+
 #include "pv_circular_buffer.h"
+#include "pv_gain.h"
+#include "pv_resampler.h"
 #include "pv_speaker.h"
 
-#define PV_SPEAKER_DEFAULT_DEVICE_INDEX (-1)
+#define PV_SPEAKER_DEFAULT_DEVICE_INDEX (-1)
+
+#define PV_SPEAKER_VERSION "1.0.0"
+
+#define PV_SPEAKER_FILE_BATCH_BYTES (64 * 1024)
+
+#define PV_SPEAKER_PLAY_FILE_CHUNK_FRAMES (16 * 1024)
+
+#define PV_SPEAKER_PAUSE_FADE_MS (5)
+
+#define PV_SPEAKER_CANCEL_TIMEOUT_PERIODS (4)
+
+#define PV_SPEAKER_CANCEL_MIN_TIMEOUT_MS (100)
+
+#if defined(__PV_SPEAKER_PLATFORM_WINDOWS__)
+
+typedef HANDLE pv_speaker_thread_t;
+
+#else
+
+typedef pthread_t pv_speaker_thread_t;
+
+#endif
+
+// lets API threads wait for the audio callback with a deadline, which `ma_event` cannot do. Every wake-up is a
+// broadcast, so that any number of blocked writers and flushes make progress together.
+typedef struct {
+
+#if defined(__PV_SPEAKER_PLATFORM_WINDOWS__)
+
+    SRWLOCK lock;
+    CONDITION_VARIABLE condition;
+
+#else
+
+    pthread_mutex_t lock;
+    pthread_cond_t condition;
+
+#endif
+
+} pv_speaker_waiters_t;
+
+typedef struct {
+    int64_t frame_index;
+    pv_speaker_marker_callback_t callback;
+    void *user_data;
+} pv_speaker_marker_t;
+
+// a one-shot callback armed by an API thread and fired by whichever thread sees its condition first. `state` counts
+// the times it was armed in the upper bits and holds whether it is pending in the lowest one, so that a thread that
+// read the callback of an earlier arming cannot fire it
+typedef struct {
+    uint32_t state;
+    pv_speaker_notification_callback_t callback;
+    void *user_data;
+    int32_t length;
+} pv_speaker_notification_t;
+
+struct pv_speaker {
+    ma_context *context;
+    ma_device device;
+    pv_circular_buffer_t *buffer;
+    int32_t buffer_capacity;
+    pv_circular_buffer_t *internal_buffer;
+    int32_t internal_buffer_capacity;
+    int32_t sample_rate;
+    int32_t bits_per_sample;
+    int32_t num_channels;
+    bool is_float;
+    int32_t frame_size;
+    ma_format format;
+    int32_t device_sample_rate;
+    bool is_float_device;
+    pv_resampler_t *resampler;
+    int8_t *staging;
+    int32_t resampler_padding;
+    bool is_mixer;
+    pv_speaker_stream_t *streams[PV_SPEAKER_MAX_STREAMS];
+    uint64_t mix_sequence;
+    float *mix_buffer;
+    float requested_gain;
+    int32_t requested_gain_ramp_frames;
+    uint32_t gain_generation;
+    uint32_t applied_gain_generation;
+    float gain;
+    float gain_step;
+    float gain_target;
+    int32_t gain_ramp_frames;
+    bool is_paused;
+    float pause_gain;
+    int32_t pause_fade_frames;
+    int32_t requested_cancel_fade_frames;
+    int32_t requested_cancel_end_position;
+    uint32_t cancel_generation;
+    uint32_t applied_cancel_generation;
+    uint32_t completed_cancel_generation;
+    bool is_cancelling;
+    int32_t cancel_fade_length;
+    int32_t cancel_fade_frames;
+    int32_t cancel_end_position;
+    int32_t cancel_discarded_length;
+    int64_t frames_discarded;
+    uint64_t latency_ns;
+    uint32_t position_sequence;
+    int64_t position_frames;
+    int64_t position_played_frames;
+    int64_t position_end_frames;
+    uint64_t position_time_ns;
+    pv_circular_buffer_t *marker_buffer;
+    pv_speaker_marker_t pending_markers[PV_SPEAKER_MAX_MARKERS];
+    int32_t num_pending_markers;
+    pv_speaker_notification_t available_notification;
+    pv_speaker_notification_t drained_notification;
+    bool is_started;
+    pv_speaker_render_callback_t render_callback;
+    void *render_user_data;
+    ma_mutex mutex;
+    pv_speaker_waiters_t waiters;
+    int32_t num_waiters;
+    bool is_stop_flush;
+    bool is_flushed_and_empty;
+    bool is_data_requested_while_empty;
+    bool is_draining;
+    bool is_starved;
+    int64_t num_underruns;
+    int64_t frames_played;
+    int64_t frames_written;
+    int32_t peak_fill;
+    int64_t callback_durations[PV_SPEAKER_STATS_NUM_CALLBACK_DURATION_BUCKETS];
+    FILE *file;
+    pv_circular_buffer_t *file_buffer;
+    int8_t *file_batch;
+    ma_event file_data_event;
+    ma_event file_space_event;
+    pv_speaker_thread_t file_thread;
+    bool is_file_stopping;
+    pv_speaker_file_overflow_policy_t file_overflow_policy;
+    int64_t file_dropped_bytes;
+    uint32_t file_data_bytes;
+};
+
+struct pv_speaker_stream {
+    pv_speaker_t *speaker;
+    pv_circular_buffer_t *buffer;
+    ma_format format;
+    pv_resampler_t *resampler;
+    int8_t *staging;
+    float gain;
+};
+
+// one backend context for the whole process. Initializing a context connects to the audio server (e.g. PulseAudio) and
+// enumerating devices queries it, which together take up to hundreds of milliseconds, so both are done once and shared
+typedef struct {
+    int32_t ref_count;
+    ma_context context;
+    bool has_device_list;
+    bool is_device_list_stale;
+    ma_device_info *devices;
+    int32_t num_devices;
+} pv_speaker_shared_context_t;
+
+static pv_speaker_shared_context_t pv_speaker_shared_context;
+
+#if defined(__PV_SPEAKER_PLATFORM_WINDOWS__)
+
+static SRWLOCK pv_speaker_shared_context_lock = SRWLOCK_INIT;
+
+static void pv_speaker_shared_context_lock_acquire(void) {
+    AcquireSRWLockExclusive(&pv_speaker_shared_context_lock);
+}
+
+static void pv_speaker_shared_context_lock_release(void) {
+    ReleaseSRWLockExclusive(&pv_speaker_shared_context_lock);
+}
+
+#else
+
+static pthread_mutex_t pv_speaker_shared_context_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void pv_speaker_shared_context_lock_acquire(void) {
+    pthread_mutex_lock(&pv_speaker_shared_context_lock);
+}
+
+static void pv_speaker_shared_context_lock_release(void) {
+    pthread_mutex_unlock(&pv_speaker_shared_context_lock);
+}
+
+#endif
+
+// the functions below expect the shared context lock to be held
+
+static ma_result pv_speaker_shared_context_retain(void) {
+    if (pv_speaker_shared_context.ref_count == 0) {
+        ma_result result = ma_context_init(NULL, 0, NULL, &(pv_speaker_shared_context.context));
+        if (result != MA_SUCCESS) {
+            return result;
+        }
+    }
+    pv_speaker_shared_context.ref_count++;
+
+    return MA_SUCCESS;
+}
+
+static void pv_speaker_shared_context_release(void) {
+    pv_speaker_shared_context.ref_count--;
+    if (pv_speaker_shared_context.ref_count == 0) {
+        ma_context_uninit(&(pv_speaker_shared_context.context));
+    }
+}
+
+// the cached list outlives the context; device IDs stay valid for the next context of the same backend
+static ma_result pv_speaker_shared_context_update_devices(bool is_refresh) {
+    if (!is_refresh &&
+            pv_speaker_shared_context.has_device_list &&
+            !__atomic_load_n(&(pv_speaker_shared_context.is_device_list_stale), __ATOMIC_ACQUIRE)) {
+        return MA_SUCCESS;
+    }
+
+    ma_result result = pv_speaker_shared_context_retain();
+    if (result != MA_SUCCESS) {
+        return result;
+    }
+
+    // cleared before enumerating, so that a notification arriving meanwhile leaves the new list stale
+    __atomic_store_n(&(pv_speaker_shared_context.is_device_list_stale), false, __ATOMIC_RELEASE);
+
+    ma_device_info *playback_info = NULL;
+    ma_uint32 playback_count = 0;
+    result = ma_context_get_devices(
+            &(pv_speaker_shared_context.context),
+            &playback_info,
+            &playback_count,
+            NULL,
+            NULL);
+    if (result != MA_SUCCESS) {
+        pv_speaker_shared_context_release();
+        return result;
+    }
+
+    ma_device_info *devices = NULL;
+    if (playback_count > 0) {
+        devices = malloc(playback_count * sizeof(ma_device_info));
+        if (!devices) {
+            pv_speaker_shared_context_release();
+            return MA_OUT_OF_MEMORY;
+        }
+        memcpy(devices, playback_info, playback_count * sizeof(ma_device_info));
+    }
+
+    free(pv_speaker_shared_context.devices);
+    pv_speaker_shared_context.devices = devices;
+    pv_speaker_shared_context.num_devices = (int32_t) playback_count;
+    pv_speaker_shared_context.has_device_list = true;
+
+    pv_speaker_shared_context_release();
+
+    return MA_SUCCESS;
+}
+
+static uint64_t pv_speaker_get_time_ns(void) {
+
+#if defined(__PV_SPEAKER_PLATFORM_WINDOWS__)
+
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (uint64_t) ((double) counter.QuadPart * (1e9 / (double) frequency.QuadPart));
+
+#else
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000000ULL) + (uint64_t) now.tv_nsec;
+
+#endif
+
+}
+
+static bool pv_speaker_waiters_init(pv_speaker_waiters_t *waiters) {
+
+#if defined(__PV_SPEAKER_PLATFORM_WINDOWS__)
+
+    InitializeSRWLock(&(waiters->lock));
+    InitializeConditionVariable(&(waiters->condition));
+    return true;
+
+#else
+
+    if (pthread_mutex_init(&(waiters->lock), NULL) != 0) {
+        return false;
+    }
+
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+
+#if !defined(__PV_SPEAKER_PLATFORM_DARWIN__)
+
+    // deadlines come from `pv_speaker_get_time_ns()`. Darwin has no clock attribute and waits on a relative timeout.
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+
+#endif
+
+    const bool is_initialized = pthread_cond_init(&(waiters->condition), &attributes) == 0;
+    pthread_condattr_destroy(&attributes);
+    return is_initialized;
+
+#endif
+
+}
+
+static void pv_speaker_waiters_uninit(pv_speaker_waiters_t *waiters) {
+
+#if !defined(__PV_SPEAKER_PLATFORM_WINDOWS__)
+
+    pthread_cond_destroy(&(waiters->condition));
+    pthread_mutex_destroy(&(waiters->lock));
+
+#else
+
+    (void) waiters;
+
+#endif
+
+}
+
+static void pv_speaker_waiters_lock(pv_speaker_waiters_t *waiters) {
+
+#if defined(__PV_SPEAKER_PLATFORM_WINDOWS__)
+
+    AcquireSRWLockExclusive(&(waiters->lock));
+
+#else
+
+    pthread_mutex_lock(&(waiters->lock));
+
+#endif
+
+}
+
+static void pv_speaker_waiters_unlock(pv_speaker_waiters_t *waiters) {
+
+#if defined(__PV_SPEAKER_PLATFORM_WINDOWS__)
+
+    ReleaseSRWLockExclusive(&(waiters->lock));
+
+#else
+
+    pthread_mutex_unlock(&(waiters->lock));
+
+#endif
+
+}
+
+// expects the lock to be held. Waits until woken up or `deadline_ns` (0 for none) has passed, which is `now_ns` now.
+static void pv_speaker_waiters_wait(pv_speaker_waiters_t *waiters, uint64_t now_ns, uint64_t deadline_ns) {
+
+#if defined(__PV_SPEAKER_PLATFORM_WINDOWS__)
+
+    DWORD timeout_ms = INFINITE;
+    if (deadline_ns != 0) {
+        const uint64_t remaining_ms = ((deadline_ns - now_ns) + 999999ULL) / 1000000ULL;
+        timeout_ms = (remaining_ms < (uint64_t) INFINITE) ? (DWORD) remaining_ms : (INFINITE - 1);
+    }
+    SleepConditionVariableSRW(&(waiters->condition), &(waiters->lock), timeout_ms, 0);
+
+#else
+
+    if (deadline_ns == 0) {
+        pthread_cond_wait(&(waiters->condition), &(waiters->lock));
+        return;
+    }
+
+#if defined(__PV_SPEAKER_PLATFORM_DARWIN__)
+
+    const uint64_t timeout_ns = deadline_ns - now_ns;
+    struct timespec timeout;
+    timeout.tv_sec = (time_t) (timeout_ns / 1000000000ULL);
+    timeout.tv_nsec = (long) (timeout_ns % 1000000000ULL);
+    pthread_cond_timedwait_relative_np(&(waiters->condition), &(waiters->lock), &timeout);
+
+#else
+
+    (void) now_ns;
+    struct timespec deadline;
+    deadline.tv_sec = (time_t) (deadline_ns / 1000000000ULL);
+    deadline.tv_nsec = (long) (deadline_ns % 1000000000ULL);
+    pthread_cond_timedwait(&(waiters->condition), &(waiters->lock), &deadline);
+
+#endif
+
+#endif
+
+}
+
+// wakes up every thread blocked in `pv_speaker_wait_for_callback()`
+static void pv_speaker_wake_waiters(pv_speaker_t *object) {
+    pv_speaker_waiters_lock(&object->waiters);
+
+#if defined(__PV_SPEAKER_PLATFORM_WINDOWS__)
+
+    WakeAllConditionVariable(&(object->waiters.condition));
+
+#else
+
+    pthread_cond_broadcast(&(object->waiters.condition));
+
+#endif
+
+    pv_speaker_waiters_unlock(&object->waiters);
+}
+
+// wakes up waiters from the audio thread; cheap enough for it when nobody waits
+static void pv_speaker_signal_waiters(pv_speaker_t *object) {
+    if (__atomic_load_n(&object->num_waiters, __ATOMIC_ACQUIRE) > 0) {
+        pv_speaker_wake_waiters(object);
+    }
+}
+
+// blocks until the audio callback has run again, the speaker is stopped or `deadline_ns` (0 for none) has passed, so
+// a deadline is honoured even if the device stops calling back. Returns false if the deadline had already passed.
+static bool pv_speaker_wait_for_callback(pv_speaker_t *object, uint64_t deadline_ns) {
+    const uint64_t now_ns = pv_speaker_get_time_ns();
+    if ((deadline_ns != 0) && (now_ns >= deadline_ns)) {
+        return false;
+    }
+
+    __atomic_add_fetch(&object->num_waiters, 1, __ATOMIC_SEQ_CST);
+    pv_speaker_waiters_lock(&object->waiters);
+    // `pv_speaker_stop()` sets the flag before waking up waiters under the lock, so checking it here cannot miss that
+    if (!__atomic_load_n(&object->is_stop_flush, __ATOMIC_ACQUIRE)) {
+        pv_speaker_waiters_wait(&object->waiters, now_ns, deadline_ns);
+    }
+    pv_speaker_waiters_unlock(&object->waiters);
+    __atomic_sub_fetch(&object->num_waiters, 1, __ATOMIC_SEQ_CST);
+
+    return true;
+}
+
+// the audio thread is the only writer of these counters, so relaxed stores of incremented loads are enough
+static inline void pv_speaker_count(int64_t *counter, int64_t value) {
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+}
+
+// provides float frames at the caller's sample rate, from the render callback in pull mode and from the circular
+// buffer otherwise. Once a flush has emptied the circular buffer it pads the stream with silence until the resampler
+// has let go of its lookahead.
+static int32_t pv_speaker_source(void *context, float *input, int32_t max_length) {
+    pv_speaker_t *object = (pv_speaker_t *) context;
+
+    int32_t read_length = 0;
+    if (object->render_callback != NULL) {
+        ma_silence_pcm_frames(object->staging, max_length, object->format, object->num_channels);
+        object->render_callback(object->render_user_data, object->staging, max_length);
+        read_length = max_length;
+    } else {
+        pv_circular_buffer_read(object->buffer, object->staging, max_length, &read_length);
+    }
+    pv_speaker_count(&object->frames_played, read_length);
+
+    if (read_length > 0) {
+        object->resampler_padding = 0;
+        ma_pcm_convert(
+                input,
+                ma_format_f32,
+                object->staging,
+                object->format,
+                (ma_uint64) read_length * object->num_channels,
+                ma_dither_mode_none);
+        return read_length;
+    }
+
+    if (object->resampler == NULL) {
+        return 0;
+    }
+
+    const int32_t padding = pv_resampler_get_lookahead(object->resampler) - object->resampler_padding;
+    if ((padding <= 0) || !__atomic_load_n(&object->is_draining, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+
+    read_length = (padding < max_length) ? padding : max_length;
+    memset(input, 0, (size_t) read_length * object->num_channels * sizeof(float));
+    object->resampler_padding += read_length;
+
+    return read_length;
+}
+
+// reads up to `frame_count` float frames from `source`, through `resampler` unless it is NULL
+static int32_t pv_speaker_read_float(
+        pv_resampler_t *resampler,
+        int32_t num_channels,
+        float *output,
+        int32_t frame_count,
+        pv_resampler_source_t source,
+        void *context) {
+    if (resampler != NULL) {
+        return pv_resampler_read(resampler, output, frame_count, source, context);
+    }
+
+    int32_t read_length = 0;
+    while (read_length < frame_count) {
+        int32_t length = frame_count - read_length;
+        if (length > PV_RESAMPLER_MAX_SOURCE_FRAMES) {
+            length = PV_RESAMPLER_MAX_SOURCE_FRAMES;
+        }
+        length = source(context, &output[read_length * num_channels], length);
+        if (length <= 0) {
+            break;
+        }
+        read_length += length;
+    }
+    return read_length;
+}
+
+static int32_t pv_speaker_stream_source(void *context, float *input, int32_t max_length) {
+    pv_speaker_stream_t *stream = (pv_speaker_stream_t *) context;
+
+    int32_t read_length = 0;
+    pv_circular_buffer_read(stream->buffer, stream->staging, max_length, &read_length);
+    if (read_length > 0) {
+        ma_pcm_convert(
+                input,
+                ma_format_f32,
+                stream->staging,
+                stream->format,
+                (ma_uint64) read_length * stream->speaker->num_channels,
+                ma_dither_mode_none);
+    }
+    return read_length;
+}
+
+// adds every stream to the output. `mix_sequence` is odd while the streams are in use, which lets
+// `pv_speaker_stream_delete()` wait for the current period instead of the audio thread taking a lock.
+static void pv_speaker_mix_streams(pv_speaker_t *object, float *output, int32_t frame_count) {
+    const int32_t num_channels = object->num_channels;
+
+    __atomic_add_fetch(&object->mix_sequence, 1, __ATOMIC_SEQ_CST);
+
+    for (int32_t i = 0; i < PV_SPEAKER_MAX_STREAMS; i++) {
+        pv_speaker_stream_t *stream = __atomic_load_n(&object->streams[i], __ATOMIC_SEQ_CST);
+        if (stream == NULL) {
+            continue;
+        }
+
+        float gain;
+        __atomic_load(&stream->gain, &gain, __ATOMIC_RELAXED);
+
+        int32_t offset = 0;
+        while (offset < frame_count) {
+            int32_t max_length = frame_count - offset;
+            if (max_length > PV_RESAMPLER_MAX_SOURCE_FRAMES) {
+                max_length = PV_RESAMPLER_MAX_SOURCE_FRAMES;
+            }
+            const int32_t length = pv_speaker_read_float(
+                    stream->resampler,
+                    num_channels,
+                    object->mix_buffer,
+                    max_length,
+                    pv_speaker_stream_source,
+                    stream);
+
+            // summing floats cannot overflow, and miniaudio clips the mix when it converts to the device format
+            float *mix = &output[offset * num_channels];
+            for (int32_t j = 0; j < (length * num_channels); j++) {
+                mix[j] += gain * object->mix_buffer[j];
+            }
+
+            if (length < max_length) {
+                break;
+            }
+            offset += length;
+        }
+    }
+
+    __atomic_add_fetch(&object->mix_sequence, 1, __ATOMIC_SEQ_CST);
+}
+
+static void pv_speaker_render(pv_speaker_t *object, void *output, int32_t frame_count) {
+    // in pull mode the application renders straight into the device buffer, so the circular buffer is bypassed
+    if ((object->render_callback != NULL) && !object->is_float_device) {
+        object->render_callback(object->render_user_data, (int8_t *) output, frame_count);
+        pv_speaker_count(&object->frames_played, frame_count);
+        return;
+    }
+
+    // this callback being invoked after calling `pv_speaker_flush` and the circular buffer is empty indicates that all
+    // frames have been passed to the output buffer, and the device can stop without truncating the last frame of audio
+    if (__atomic_load_n(&object->is_flushed_and_empty, __ATOMIC_ACQUIRE)) {
+        if (object->resampler != NULL) {
+            pv_resampler_read(object->resampler, (float *) output, frame_count, pv_speaker_source, object);
+        }
+        __atomic_store_n(&object->is_data_requested_while_empty, true, __ATOMIC_RELEASE);
+        pv_speaker_signal_waiters(object);
+        return;
+    }
+
+    // the circular buffer is lock-free for a single producer and a single consumer, so the audio thread never waits on
+    // `object->mutex`, which only serializes the writers
+    int32_t read_length = 0;
+    if (object->is_float_device) {
+        read_length = pv_speaker_read_float(
+                object->resampler,
+                object->num_channels,
+                (float *) output,
+                frame_count,
+                pv_speaker_source,
+                object);
+    } else {
+        pv_circular_buffer_read(object->buffer, output, frame_count, &read_length);
+        pv_speaker_count(&object->frames_played, read_length);
+    }
+
+    // running dry once is one underrun, however many periods of silence follow. The tail of a flush is expected to be
+    // short, and so is every period before the first write.
+    if (read_length == frame_count) {
+        object->is_starved = false;
+    } else if (!object->is_starved && !__atomic_load_n(&object->is_draining, __ATOMIC_ACQUIRE)) {
+        object->is_starved = true;
+        pv_speaker_count(&object->num_underruns, 1);
+    }
+
+    pv_speaker_signal_waiters(object);
+}
+
+// picks up the latest `pv_speaker_set_gain()` and applies the gain to the device buffer, ramping towards a new target
+// over the requested number of frames. Unity gain with no ramp in progress costs nothing.
+static void pv_speaker_apply_gain(pv_speaker_t *object, void *output, int32_t frame_count) {
+    const uint32_t generation = __atomic_load_n(&object->gain_generation, __ATOMIC_ACQUIRE);
+    if (generation != object->applied_gain_generation) {
+        object->applied_gain_generation = generation;
+        __atomic_load(&object->requested_gain, &object->gain_target, __ATOMIC_RELAXED);
+        object->gain_ramp_frames = __atomic_load_n(&object->requested_gain_ramp_frames, __ATOMIC_RELAXED);
+        if (object->gain_ramp_frames > 0) {
+            object->gain_step = (object->gain_target - object->gain) / (float) object->gain_ramp_frames;
+        } else {
+            object->gain = object->gain_target;
+        }
+    }
+
+    if ((object->gain_ramp_frames == 0) && (object->gain == 1.f)) {
+        return;
+    }
+
+    const int32_t bits_per_sample = object->is_float_device ? 32 : object->bits_per_sample;
+    const bool is_float = object->is_float_device || object->is_float;
+    const int32_t frame_size = (bits_per_sample / 8) * object->num_channels;
+
+    int32_t offset = 0;
+    if (object->gain_ramp_frames > 0) {
+        offset = (object->gain_ramp_frames < frame_count) ? object->gain_ramp_frames : frame_count;
+        pv_gain_apply(output, bits_per_sample, is_float, object->num_channels, offset, object->gain, object->gain_step);
+        object->gain_ramp_frames -= offset;
+        object->gain = (object->gain_ramp_frames > 0)
+                ? (object->gain + (object->gain_step * (float) offset))
+                : object->gain_target;
+    }
+
+    if (offset < frame_count) {
+        pv_gain_apply(
+                (int8_t *) output + (offset * frame_size),
+                bits_per_sample,
+                is_float,
+                object->num_channels,
+                frame_count - offset,
+                object->gain,
+                0.f);
+    }
+}
+
+// the position of the stream in frames written, i.e. frames dropped by a cancel or a stop count as played. Only the
+// consumer side of the circular buffer updates it.
+static inline int64_t pv_speaker_get_written_position(pv_speaker_t *object) {
+    return __atomic_load_n(&object->frames_played, __ATOMIC_RELAXED) +
+           __atomic_load_n(&object->frames_discarded, __ATOMIC_RELAXED);
+}
+
+// moves markers added by `pv_speaker_add_marker()` out of the queue, then invokes or drops the ones that are due. A
+// marker is due if its frame is below `end_frame` and, when dropping, at or above `start_frame`.
+static void pv_speaker_process_markers(
+        pv_speaker_t *object,
+        int64_t start_frame,
+        int64_t end_frame,
+        bool is_dropping) {
+    const int32_t free_length = PV_SPEAKER_MAX_MARKERS - object->num_pending_markers;
+    if (free_length > 0) {
+        int32_t read_length = 0;
+        pv_circular_buffer_read(
+                object->marker_buffer,
+                &object->pending_markers[object->num_pending_markers],
+                free_length,
+                &read_length);
+        object->num_pending_markers += read_length;
+    }
+
+    int32_t num_pending_markers = 0;
+    for (int32_t i = 0; i < object->num_pending_markers; i++) {
+        const pv_speaker_marker_t *marker = &object->pending_markers[i];
+        if ((marker->frame_index < end_frame) && (!is_dropping || (marker->frame_index >= start_frame))) {
+            if (!is_dropping) {
+                marker->callback(marker->user_data, marker->frame_index);
+            }
+        } else {
+            object->pending_markers[num_pending_markers++] = *marker;
+        }
+    }
+    object->num_pending_markers = num_pending_markers;
+}
+
+// drops the frames in front of `end_position` of the circular buffer, or all frames left if it is negative, along with
+// their markers. Must only run on the consumer side.
+static int32_t pv_speaker_discard_buffer(pv_speaker_t *object, int32_t end_position) {
+    const int64_t position = pv_speaker_get_written_position(object);
+
+    int32_t discarded_length = 0;
+    if (end_position < 0) {
+        pv_circular_buffer_skip(object->buffer, INT32_MAX, &discarded_length);
+    } else {
+        pv_circular_buffer_skip_to(object->buffer, end_position, &discarded_length);
+    }
+    pv_speaker_count(&object->frames_discarded, discarded_length);
+    pv_speaker_process_markers(object, position, position + discarded_length, true);
+
+    return discarded_length;
+}
+
+// publishes where the stream was when this period was rendered; `pv_speaker_get_position()` interpolates from there
+static void pv_speaker_update_position(
+        pv_speaker_t *object,
+        int64_t start_frames,
+        int64_t played_frames,
+        int64_t end_frames,
+        uint64_t time_ns) {
+    const uint32_t sequence = __atomic_load_n(&object->position_sequence, __ATOMIC_RELAXED);
+    // an odd sequence marks an update in progress. Release stores keep the fields from being written before it.
+    __atomic_store_n(&object->position_sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&object->position_frames, start_frames, __ATOMIC_RELEASE);
+    __atomic_store_n(&object->position_played_frames, played_frames, __ATOMIC_RELEASE);
+    __atomic_store_n(&object->position_end_frames, end_frames, __ATOMIC_RELEASE);
+    __atomic_store_n(&object->position_time_ns, time_ns, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&object->position_sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+// estimates which frame is audible at `time_ns`: the device plays at a steady rate after the latest update, but never
+// past what it was given. Frames dropped right after the last played one are skipped once that one is heard.
+static int64_t pv_speaker_interpolate_position(pv_speaker_t *object, uint64_t time_ns) {
+    int64_t start_frames = 0;
+    int64_t played_frames = 0;
+    int64_t end_frames = 0;
+    uint64_t update_time_ns = 0;
+    uint32_t sequence = 0;
+    do {
+        sequence = __atomic_load_n(&object->position_sequence, __ATOMIC_ACQUIRE);
+        start_frames = __atomic_load_n(&object->position_frames, __ATOMIC_ACQUIRE);
+        played_frames = __atomic_load_n(&object->position_played_frames, __ATOMIC_ACQUIRE);
+        end_frames = __atomic_load_n(&object->position_end_frames, __ATOMIC_ACQUIRE);
+        update_time_ns = __atomic_load_n(&object->position_time_ns, __ATOMIC_ACQUIRE);
+    } while ((sequence & 1) || (sequence != __atomic_load_n(&object->position_sequence, __ATOMIC_RELAXED)));
+
+    if (sequence == 0) {
+        return 0;
+    }
+
+    const double elapsed_ns = (double) time_ns - (double) update_time_ns - (double) object->latency_ns;
+    int64_t position = start_frames + (int64_t) ((elapsed_ns * object->sample_rate) / 1e9);
+    position = (position < played_frames) ? position : end_frames;
+    return (position > 0) ? position : 0;
+}
+
+// picks up the latest `pv_speaker_cancel()`. Returns how many frames of the circular buffer may still be played in this
+// period while fading out.
+static int32_t pv_speaker_begin_cancel(pv_speaker_t *object, int32_t frame_count) {
+    const uint32_t generation = __atomic_load_n(&object->cancel_generation, __ATOMIC_ACQUIRE);
+    if (generation != object->applied_cancel_generation) {
+        object->applied_cancel_generation = generation;
+        object->cancel_fade_length = __atomic_load_n(&object->requested_cancel_fade_frames, __ATOMIC_RELAXED);
+        object->cancel_fade_frames = object->cancel_fade_length;
+        object->cancel_end_position = __atomic_load_n(&object->requested_cancel_end_position, __ATOMIC_RELAXED);
+        object->is_cancelling = true;
+    }
+
+    if (!object->is_cancelling) {
+        return frame_count;
+    }
+    return (object->cancel_fade_frames < frame_count) ? object->cancel_fade_frames : frame_count;
+}
+
+static void pv_speaker_apply_cancel_fade(pv_speaker_t *object, void *output, int32_t frame_count) {
+    if (!object->is_cancelling || (frame_count == 0)) {
+        return;
+    }
+
+    pv_gain_apply(
+            output,
+            object->is_float_device ? 32 : object->bits_per_sample,
+            object->is_float_device || object->is_float,
+            object->num_channels,
+            frame_count,
+            (float) object->cancel_fade_frames / (float) object->cancel_fade_length,
+            -1.f / (float) object->cancel_fade_length);
+    object->cancel_fade_frames -= frame_count;
+}
+
+// drops what is left of the PCM data written before the cancel once the fade out has played. Runs on the consumer side
+// of the buffer, i.e. on the audio thread, or on the thread calling `pv_speaker_cancel()` once the device has stopped.
+static void pv_speaker_complete_cancel(pv_speaker_t *object) {
+    const int32_t discarded_length = pv_speaker_discard_buffer(object, object->cancel_end_position);
+    if (object->resampler != NULL) {
+        pv_resampler_reset(object->resampler);
+        object->resampler_padding = 0;
+    }
+
+    // the buffer being empty now is not an underrun
+    object->is_starved = true;
+    object->is_cancelling = false;
+
+    __atomic_store_n(&object->cancel_discarded_length, discarded_length, __ATOMIC_RELAXED);
+    __atomic_store_n(&object->completed_cancel_generation, object->applied_cancel_generation, __ATOMIC_RELEASE);
+}
+
+// fades out over `PV_SPEAKER_PAUSE_FADE_MS` after `pv_speaker_pause()` and back in after `pv_speaker_resume()`
+static void pv_speaker_apply_pause_fade(pv_speaker_t *object, void *output, int32_t frame_count, bool is_paused) {
+    if (!is_paused && (object->pause_gain == 1.f)) {
+        return;
+    }
+
+    const float step = (is_paused ? -1.f : 1.f) / (float) object->pause_fade_frames;
+    int32_t fade_frames = (int32_t) ceilf((is_paused ? object->pause_gain : (1.f - object->pause_gain)) / fabsf(step));
+    fade_frames = (fade_frames < frame_count) ? fade_frames : frame_count;
+
+    pv_gain_apply(
+            output,
+            object->is_float_device ? 32 : object->bits_per_sample,
+            object->is_float_device || object->is_float,
+            object->num_channels,
+            fade_frames,
+            object->pause_gain,
+            step);
+
+    object->pause_gain += step * (float) fade_frames;
+    if (object->pause_gain <= 0.f) {
+        object->pause_gain = 0.f;
+    } else if (object->pause_gain >= 1.f) {
+        object->pause_gain = 1.f;
+    }
+}
+
+static inline bool pv_speaker_notification_is_pending(pv_speaker_notification_t *notification) {
+    return (__atomic_load_n(&notification->state, __ATOMIC_ACQUIRE) & 1) != 0;
+}
+
+// expects `object->mutex` to be held, so that two API threads cannot arm the same notification at once
+static bool pv_speaker_notification_arm(
+        pv_speaker_notification_t *notification,
+        int32_t length,
+        pv_speaker_notification_callback_t callback,
+        void *user_data) {
+    const uint32_t state = __atomic_load_n(&notification->state, __ATOMIC_ACQUIRE);
+    if ((state & 1) != 0) {
+        return false;
+    }
+
+    __atomic_store_n(&notification->callback, callback, __ATOMIC_RELAXED);
+    __atomic_store_n(&notification->user_data, user_data, __ATOMIC_RELAXED);
+    __atomic_store_n(&notification->length, length, __ATOMIC_RELAXED);
+    __atomic_store_n(&notification->state, (state + 2) | 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+static void pv_speaker_notification_fire(pv_speaker_notification_t *notification) {
+    uint32_t state = __atomic_load_n(&notification->state, __ATOMIC_ACQUIRE);
+    if ((state & 1) == 0) {
+        return;
+    }
+
+    pv_speaker_notification_callback_t callback = __atomic_load_n(&notification->callback, __ATOMIC_RELAXED);
+    void *user_data = __atomic_load_n(&notification->user_data, __ATOMIC_RELAXED);
+    if (__atomic_compare_exchange_n(
+            &notification->state,
+            &state,
+            state & ~1U,
+            false,
+            __ATOMIC_ACQ_REL,
+            __ATOMIC_ACQUIRE)) {
+        callback(user_data);
+    }
+}
+
+// fires the notifications whose condition holds at the end of a period. `was_empty` tells whether the circular buffer
+// was empty when the period started, in which case everything written before has been passed to the device, except for
+// the lookahead a resampler holds back until it is padded with silence.
+static void pv_speaker_process_notifications(pv_speaker_t *object, bool was_empty) {
+    if (pv_speaker_notification_is_pending(&object->available_notification)) {
+        int32_t available = 0;
+        pv_circular_buffer_get_available(object->buffer, &available);
+        if (available >= __atomic_load_n(&object->available_notification.length, __ATOMIC_RELAXED)) {
+            pv_speaker_notification_fire(&object->available_notification);
+        }
+    }
+
+    if (was_empty && pv_speaker_notification_is_pending(&object->drained_notification)) {
+        if ((object->resampler == NULL) ||
+            (object->resampler_padding >= pv_resampler_get_lookahead(object->resampler))) {
+            __atomic_store_n(&object->is_draining, false, __ATOMIC_RELEASE);
+            pv_speaker_notification_fire(&object->drained_notification);
+        }
+    }
+}
+
+static void pv_speaker_ma_callback(ma_device *device, void *output, const void *input, ma_uint32 frame_count) {
+    (void) input;
+
+    pv_speaker_t *object = (pv_speaker_t *) device->pUserData;
+
+    const uint64_t start_ns = pv_speaker_get_time_ns();
+    const int64_t start_frames = pv_speaker_get_written_position(object);
+
+    bool was_empty = false;
+    if (pv_speaker_notification_is_pending(&object->drained_notification)) {
+        int32_t count = 0;
+        pv_circular_buffer_get_count(object->buffer, &count);
+        was_empty = (count == 0);
+    }
+
+    // while paused the device keeps running on the silence miniaudio fills the buffer with. Only the frames needed to
+    // fade out are taken from the circular buffer, so playback resumes exactly where it stopped.
+    const bool is_paused = __atomic_load_n(&object->is_paused, __ATOMIC_ACQUIRE);
+    int32_t render_count = (int32_t) frame_count;
+    if (is_paused) {
+        const int32_t fade_frames = (int32_t) ceilf(object->pause_gain * (float) object->pause_fade_frames);
+        render_count = (fade_frames < render_count) ? fade_frames : render_count;
+    }
+
+    // a cancel fades out the circular buffer only, so that mixed streams play on
+    const int32_t buffer_render_count = pv_speaker_begin_cancel(object, render_count);
+    if (buffer_render_count > 0) {
+        pv_speaker_render(object, output, buffer_render_count);
+        pv_speaker_apply_cancel_fade(object, output, buffer_render_count);
+    }
+    const int64_t played_frames = pv_speaker_get_written_position(object);
+    if (object->is_cancelling && ((render_count == 0) || (object->cancel_fade_frames == 0))) {
+        pv_speaker_complete_cancel(object);
+        pv_speaker_signal_waiters(object);
+    }
+
+    if (render_count > 0) {
+        if (object->is_mixer) {
+            pv_speaker_mix_streams(object, (float *) output, render_count);
+        }
+        pv_speaker_apply_gain(object, output, render_count);
+        pv_speaker_apply_pause_fade(object, output, render_count, is_paused);
+    }
+
+    // keeps blocked writers checking their deadlines while nothing is read from the circular buffer
+    if (buffer_render_count == 0) {
+        pv_speaker_signal_waiters(object);
+    }
+
+    // the first frame of this period is heard once the device has played what it buffered before. Periods that took
+    // nothing from the stream leave the position to be extrapolated from the last one that did.
+    const int64_t end_frames = pv_speaker_get_written_position(object);
+    if (end_frames != start_frames) {
+        pv_speaker_update_position(object, start_frames, played_frames, end_frames, start_ns);
+    }
+    pv_speaker_process_markers(object, 0, pv_speaker_interpolate_position(object, start_ns) + 1, false);
+    pv_speaker_process_notifications(object, was_empty);
+
+    // bucket `i` holds durations below 2^(i + 3) microseconds
+    uint64_t duration_us = ((pv_speaker_get_time_ns() - start_ns) / 1000) >> 3;
+    int32_t bucket = 0;
+    while ((duration_us > 0) && (bucket < (PV_SPEAKER_STATS_NUM_CALLBACK_DURATION_BUCKETS - 1))) {
+        duration_us >>= 1;
+        bucket++;
+    }
+    pv_speaker_count(&object->callback_durations[bucket], 1);
+}
+
+static void pv_speaker_ma_notification_callback(const ma_device_notification *notification) {
+    // miniaudio has no notification for devices being added or removed, but the default output changing usually means
+    // that one was
+    if (notification->type == ma_device_notification_type_rerouted) {
+        __atomic_store_n(&(pv_speaker_shared_context.is_device_list_stale), true, __ATOMIC_RELEASE);
+    }
+}
+
+// converts a duration given either in frames or in milliseconds (when `frames` is 0) to frames
+static int64_t pv_speaker_frames_or_ms(int32_t frames, int32_t ms, int32_t sample_rate) {
+    if (frames > 0) {
+        return frames;
+    }
+    return (((int64_t) ms * sample_rate) + 999) / 1000;
+}
+
+PV_API pv_speaker_status_t pv_speaker_init(
+        int32_t sample_rate,
+        int16_t bits_per_sample,
+        int32_t buffer_size_secs,
+        int32_t device_index,
+        pv_speaker_t **object) {
+    if (buffer_size_secs <= 0) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if ((sample_rate > 0) && (buffer_size_secs > (INT32_MAX / sample_rate))) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+
+    pv_speaker_config_t config;
+    pv_speaker_config_init(&config);
+    config.sample_rate = sample_rate;
+    config.bits_per_sample = bits_per_sample;
+    config.device_index = device_index;
+    config.buffer_size_frames = buffer_size_secs * sample_rate;
+
+    return pv_speaker_init_ex(&config, object);
+}
+
+PV_API pv_speaker_status_t pv_speaker_init_ex(const pv_speaker_config_t *config, pv_speaker_t **object) {
+    if (!config) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if ((config->version < 1) || (config->version > PV_SPEAKER_CONFIG_VERSION)) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+
+    const int32_t sample_rate = config->sample_rate;
+    const int16_t bits_per_sample = config->bits_per_sample;
+    const int32_t device_index = config->device_index;
+
+    // fields added in version 2 are not there in structs of older callers
+    const int32_t num_channels = (config->version >= 2) ? config->num_channels : 1;
+    const bool is_float = (config->version >= 2) && config->is_float;
+    const int32_t device_sample_rate = ((config->version >= 3) && (config->device_sample_rate > 0))
+            ? config->device_sample_rate
+            : sample_rate;
+    const pv_speaker_resampler_quality_t resampler_quality = (config->version >= 3)
+            ? config->resampler_quality
+            : PV_SPEAKER_RESAMPLER_QUALITY_SINC;
+    const bool is_mixer = (config->version >= 4) && config->is_mixer;
+
+    if (device_index < PV_SPEAKER_DEFAULT_DEVICE_INDEX) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (sample_rate <= 0) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (bits_per_sample != 8 &&
+        bits_per_sample != 16 &&
+        bits_per_sample != 24 &&
+        bits_per_sample != 32) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (is_float && (bits_per_sample != 32)) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if ((num_channels < 1) || (num_channels > MA_MAX_CHANNELS)) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if ((config->version >= 3) && (config->device_sample_rate < 0)) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if ((resampler_quality != PV_SPEAKER_RESAMPLER_QUALITY_LINEAR) &&
+        (resampler_quality != PV_SPEAKER_RESAMPLER_QUALITY_SINC)) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if ((config->buffer_size_frames < 0) || (config->buffer_size_ms < 0)) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if ((config->period_size_frames < 0) || (config->period_size_ms < 0) || (config->periods < 0)) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+
+    const int64_t buffer_capacity = pv_speaker_frames_or_ms(
+            config->buffer_size_frames,
+            config->buffer_size_ms,
+            sample_rate);
+    if ((buffer_capacity <= 0) || (buffer_capacity > (INT32_MAX / 2))) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+
+    *object = NULL;
+
+    pv_speaker_t *o = calloc(1, sizeof(pv_speaker_t));
+    if (!o) {
+        return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
+    }
+
+    pv_speaker_shared_context_lock_acquire();
+    ma_result result = pv_speaker_shared_context_retain();
+    pv_speaker_shared_context_lock_release();
+    if (result == MA_SUCCESS) {
+        o->context = &(pv_speaker_shared_context.context);
+    } else {
+        pv_speaker_delete(o);
+        if ((result == MA_NO_BACKEND) || (result == MA_FAILED_TO_INIT_BACKEND)) {
+            return PV_SPEAKER_STATUS_BACKEND_ERROR;
+        } else if (result == MA_OUT_OF_MEMORY) {
+            return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
+        } else {
+            return PV_SPEAKER_STATUS_RUNTIME_ERROR;
+        }
+    }
+
+    int16_t ma_format;
+    switch (bits_per_sample) {
+        case 8:
+            ma_format = ma_format_u8;
+            break;
+        case 16:
+            ma_format = ma_format_s16;
+            break;
+        case 24:
+            ma_format = ma_format_s24;
+            break;
+        case 32:
+            ma_format = is_float ? ma_format_f32 : ma_format_s32;
+            break;
+        default:
+            ma_format = ma_format_unknown;
+            break;
+    }
+
+    o->format = ma_format;
+    o->device_sample_rate = device_sample_rate;
+    o->is_mixer = is_mixer;
+
+    // the resampler and the mixer work in floats, so the device gets floats whenever either is used
+    o->is_float_device = (device_sample_rate != sample_rate) || is_mixer;
+    if (device_sample_rate != sample_rate) {
+        pv_resampler_status_t resampler_status = pv_resampler_init(
+                sample_rate,
+                device_sample_rate,
+                num_channels,
+                (resampler_quality == PV_SPEAKER_RESAMPLER_QUALITY_LINEAR)
+                        ? PV_RESAMPLER_QUALITY_LINEAR
+                        : PV_RESAMPLER_QUALITY_SINC,
+                &(o->resampler));
+        if (resampler_status != PV_RESAMPLER_STATUS_SUCCESS) {
+            pv_speaker_delete(o);
+            if (resampler_status == PV_RESAMPLER_STATUS_OUT_OF_MEMORY) {
+                return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
+            } else {
+                return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+            }
+        }
+
+    }
+
+    if (o->is_float_device) {
+        o->staging = malloc((size_t) PV_RESAMPLER_MAX_SOURCE_FRAMES * num_channels * (bits_per_sample / 8));
+        if (!o->staging) {
+            pv_speaker_delete(o);
+            return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
+        }
+
+        ma_format = ma_format_f32;
+    }
+
+    if (is_mixer) {
+        o->mix_buffer = malloc((size_t) PV_RESAMPLER_MAX_SOURCE_FRAMES * num_channels * sizeof(float));
+        if (!o->mix_buffer) {
+            pv_speaker_delete(o);
+            return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
+        }
+    }
+
+    ma_device_config device_config;
+    device_config = ma_device_config_init(ma_device_type_playback);
+    device_config.playback.format = ma_format;
+    device_config.playback.channels = (ma_uint32) num_channels;
+    device_config.sampleRate = device_sample_rate;
+    device_config.dataCallback = pv_speaker_ma_callback;
+    device_config.pUserData = o;
+    device_config.periodSizeInFrames = (ma_uint32) config->period_size_frames;
+    device_config.periodSizeInMilliseconds = (config->period_size_frames > 0) ? 0 : (ma_uint32) config->period_size_ms;
+    device_config.periods = (ma_uint32) config->periods;
+    device_config.performanceProfile = config->is_low_latency
+            ? ma_performance_profile_low_latency
+            : ma_performance_profile_conservative;
+
+    device_config.notificationCallback = pv_speaker_ma_notification_callback;
+
+    // miniaudio does not allow initializing and uninitializing devices concurrently, so the lock covers those too
+    pv_speaker_shared_context_lock_acquire();
+
+    ma_device_id device_id;
+    if (device_index != PV_SPEAKER_DEFAULT_DEVICE_INDEX) {
+        result = pv_speaker_shared_context_update_devices(false);
+        if (result != MA_SUCCESS) {
+            pv_speaker_shared_context_lock_release();
+            pv_speaker_delete(o);
+            if (result == MA_OUT_OF_MEMORY) {
+                return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
+            } else {
+                return PV_SPEAKER_STATUS_RUNTIME_ERROR;
+            }
+        }
+        if (pv_speaker_shared_context.num_devices == 0) {
+            pv_speaker_shared_context_lock_release();
+            pv_speaker_delete(o);
+            return PV_SPEAKER_STATUS_RUNTIME_ERROR;
+        }
+        if (device_index >= pv_speaker_shared_context.num_devices) {
+            pv_speaker_shared_context_lock_release();
+            pv_speaker_delete(o);
+            return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+        }
+        device_id = pv_speaker_shared_context.devices[device_index].id;
+        device_config.playback.pDeviceID = &device_id;
+    }
+
+    result = ma_device_init(o->context, &device_config, &(o->device));
+    pv_speaker_shared_context_lock_release();
+    if (result != MA_SUCCESS) {
+        pv_speaker_delete(o);
+        if (result == MA_DEVICE_ALREADY_INITIALIZED) {
+            return PV_SPEAKER_STATUS_DEVICE_ALREADY_INITIALIZED;
+        } else if (result == MA_OUT_OF_MEMORY) {
+            return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
+        } else {
+            return PV_SPEAKER_STATUS_RUNTIME_ERROR;
+        }
+    }
+
+    result = ma_mutex_init(&(o->mutex));
+    if (result != MA_SUCCESS) {
+        pv_speaker_delete(o);
+        if (result == MA_OUT_OF_MEMORY) {
+            return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
+        } else {
+            return PV_SPEAKER_STATUS_RUNTIME_ERROR;
+        }
+    }
+
+    if (!pv_speaker_waiters_init(&(o->waiters))) {
+        pv_speaker_delete(o);
+        return PV_SPEAKER_STATUS_RUNTIME_ERROR;
+    }
+
+    ma_event *events[] = {&(o->file_data_event), &(o->file_space_event)};
+    for (int32_t i = 0; i < (int32_t) (sizeof(events) / sizeof(events[0])); i++) {
+        result = ma_event_init(events[i]);
+        if (result != MA_SUCCESS) {
+            pv_speaker_delete(o);
+            if (result == MA_OUT_OF_MEMORY) {
+                return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
+            } else {
+                return PV_SPEAKER_STATUS_RUNTIME_ERROR;
+            }
+        }
+    }
+
+    // one element per frame, so that the reader never splits the channels of a frame
+    const int32_t element_size = num_channels * (bits_per_sample / 8);
+    pv_circular_buffer_status_t status = pv_circular_buffer_init_mirrored(
+            (int32_t) buffer_capacity,
+            element_size,
+            &(o->buffer));
+    if (status == PV_CIRCULAR_BUFFER_STATUS_OUT_OF_MEMORY) {
+        // e.g. `memfd_create` is blocked in a sandbox; the regular buffer is only slower at the wrap-around
+        status = pv_circular_buffer_init(
+                (int32_t) buffer_capacity,
+                element_size,
+                &(o->buffer));
+    }
+
+    if (status != PV_CIRCULAR_BUFFER_STATUS_SUCCESS) {
+        pv_speaker_delete(o);
+        return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
+    }
+    o->buffer_capacity = (int32_t) buffer_capacity;
+    o->internal_buffer = o->buffer;
+    o->internal_buffer_capacity = o->buffer_capacity;
+
+    status = pv_circular_buffer_init(PV_SPEAKER_MAX_MARKERS, sizeof(pv_speaker_marker_t), &(o->marker_buffer));
+    if (status != PV_CIRCULAR_BUFFER_STATUS_SUCCESS) {
+        pv_speaker_delete(o);
+        return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
+    }
+
+    // what the device buffers on its own, plus the input the resampler holds back
+    const double device_frames =
+            (double) o->device.playback.internalPeriodSizeInFrames * o->device.playback.internalPeriods;
+    const double device_rate = (o->device.playback.internalSampleRate > 0)
+            ? (double) o->device.playback.internalSampleRate
+            : (double) device_sample_rate;
+    o->latency_ns = (uint64_t) ((1e9 * device_frames) / device_rate);
+    if (o->resampler != NULL) {
+        o->latency_ns += (uint64_t) ((1e9 * pv_resampler_get_lookahead(o->resampler)) / sample_rate);
+    }
+
+    o->sample_rate = sample_rate;
+    o->bits_per_sample = bits_per_sample;
+    o->num_channels = num_channels;
+    o->is_float = is_float;
+    o->frame_size = element_size;
+    o->file_overflow_policy = PV_SPEAKER_FILE_OVERFLOW_POLICY_BLOCK;
+    o->is_starved = true;
+    o->requested_gain = 1.f;
+    o->gain = 1.f;
+    o->gain_target = 1.f;
+    o->pause_gain = 1.f;
+    o->pause_fade_frames = (int32_t) pv_speaker_frames_or_ms(0, PV_SPEAKER_PAUSE_FADE_MS, device_sample_rate);
+    if (o->pause_fade_frames < 1) {
+        o->pause_fade_frames = 1;
+    }
+
+    *object = o;
+
+    return PV_SPEAKER_STATUS_SUCCESS;
+}
+
+#define PV_SPEAKER_WAVE_FORMAT_PCM (1)
+#define PV_SPEAKER_WAVE_FORMAT_IEEE_FLOAT (3)
+#define PV_SPEAKER_WAVE_FORMAT_EXTENSIBLE (0xFFFE)
+
+static void write_wav_header(pv_speaker_t *object, FILE *file) {
+    // float and multichannel audio need WAVE_FORMAT_EXTENSIBLE, which carries the actual format in its sub format
+    const bool is_extensible = object->is_float || (object->num_channels > 2);
+
+    int32_t sample_rate = object->sample_rate;
+    const char *chunk_id = "RIFF";
+    const char *format = "WAVE";
+    const char *subchunk1_id = "fmt ";
+    uint32_t subchunk1_size = is_extensible ? 40 : 16;
+    uint16_t audio_format = is_extensible ? PV_SPEAKER_WAVE_FORMAT_EXTENSIBLE : PV_SPEAKER_WAVE_FORMAT_PCM;
+    uint16_t num_channels = object->num_channels;
+    uint16_t bits_per_sample = object->bits_per_sample;
+    uint16_t sample_size = bits_per_sample / 8;
+    uint32_t byte_rate = sample_rate * num_channels * sample_size;
+    uint16_t block_align = num_channels * sample_size;
+    const char *subchunk2_id = "data";
+    uint32_t subchunk2_size = object->file_data_bytes;
+    uint32_t chunk_size = 4 + (8 + subchunk1_size) + (8 + subchunk2_size);
+
+    fwrite(chunk_id, 4, 1, file);
+    fwrite(&chunk_size, sizeof(chunk_size), 1, file);
+    fwrite(format, 4, 1, file);
+    fwrite(subchunk1_id, 4, 1, file);
+    fwrite(&subchunk1_size, sizeof(subchunk1_size), 1, file);
+    fwrite(&audio_format, sizeof(audio_format), 1, file);
+    fwrite(&num_channels, sizeof(num_channels), 1, file);
+    fwrite(&sample_rate, sizeof(sample_rate), 1, file);
+    fwrite(&byte_rate, sizeof(byte_rate), 1, file);
+    fwrite(&block_align, sizeof(block_align), 1, file);
+    fwrite(&bits_per_sample, sizeof(bits_per_sample), 1, file);
+    if (is_extensible) {
+        uint16_t extension_size = 22;
+        uint16_t valid_bits_per_sample = bits_per_sample;
+        uint32_t channel_mask = (num_channels == 1) ? 0x4 : ((num_channels == 2) ? 0x3 : 0);
+        uint16_t sub_format = object->is_float ? PV_SPEAKER_WAVE_FORMAT_IEEE_FLOAT : PV_SPEAKER_WAVE_FORMAT_PCM;
+        // rest of the KSDATAFORMAT_SUBTYPE_* GUID after the format code
+        const uint8_t sub_format_guid[14] = {
+                0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+        fwrite(&extension_size, sizeof(extension_size), 1, file);
+        fwrite(&valid_bits_per_sample, sizeof(valid_bits_per_sample), 1, file);
+        fwrite(&channel_mask, sizeof(channel_mask), 1, file);
+        fwrite(&sub_format, sizeof(sub_format), 1, file);
+        fwrite(sub_format_guid, sizeof(sub_format_guid), 1, file);
+    }
+    fwrite(subchunk2_id, 4, 1, file);
+    fwrite(&subchunk2_size, sizeof(subchunk2_size), 1, file);
+}
+
+// number of whole frames the file writer stores at once
+static inline int32_t pv_speaker_file_batch_frames(const pv_speaker_t *object) {
+    const int32_t batch_frames = PV_SPEAKER_FILE_BATCH_BYTES / object->frame_size;
+    return (batch_frames > 0) ? batch_frames : 1;
+}
+
+static void pv_speaker_file_writer_run(pv_speaker_t *object) {
+    const int32_t batch_frames = pv_speaker_file_batch_frames(object);
+    bool is_stopping = false;
+    while (!is_stopping) {
+        ma_event_wait(&(object->file_data_event));
+
+        // the stop request is read before draining, so everything recorded before it still reaches the file
+        is_stopping = __atomic_load_n(&object->is_file_stopping, __ATOMIC_ACQUIRE);
+
+        int32_t read_length = 0;
+        do {
+            pv_circular_buffer_read(object->file_buffer, object->file_batch, batch_frames, &read_length);
+            if (read_length > 0) {
+                const size_t written_frames = fwrite(object->file_batch, object->frame_size, read_length, object->file);
+                object->file_data_bytes += (uint32_t) (written_frames * object->frame_size);
+            }
+            ma_event_signal(&(object->file_space_event));
+        } while (read_length == batch_frames);
+    }
+}
+
+#if defined(__PV_SPEAKER_PLATFORM_WINDOWS__)
+
+static DWORD WINAPI pv_speaker_file_writer_thread(LPVOID arg) {
+    pv_speaker_file_writer_run((pv_speaker_t *) arg);
+    return 0;
+}
+
+#else
+
+static void *pv_speaker_file_writer_thread(void *arg) {
+    pv_speaker_file_writer_run((pv_speaker_t *) arg);
+    return NULL;
+}
+
+#endif
+
+static bool pv_speaker_file_writer_start(pv_speaker_t *object) {
+
+#if defined(__PV_SPEAKER_PLATFORM_WINDOWS__)
+
+    object->file_thread = CreateThread(NULL, 0, pv_speaker_file_writer_thread, object, 0, NULL);
+    return object->file_thread != NULL;
+
+#else
+
+    return pthread_create(&(object->file_thread), NULL, pv_speaker_file_writer_thread, object) == 0;
+
+#endif
+
+}
+
+static void pv_speaker_file_writer_join(pv_speaker_t *object) {
+
+#if defined(__PV_SPEAKER_PLATFORM_WINDOWS__)
+
+    WaitForSingleObject(object->file_thread, INFINITE);
+    CloseHandle(object->file_thread);
+
+#else
+
+    pthread_join(object->file_thread, NULL);
+
+#endif
+
+}
+
+// updates the write statistics after `length` samples were queued; called with `object->mutex` held
+static void pv_speaker_count_written(pv_speaker_t *object, int32_t length) {
+    __atomic_store_n(
+            &object->frames_written,
+            __atomic_load_n(&object->frames_written, __ATOMIC_RELAXED) + length,
+            __ATOMIC_RELAXED);
+
+    int32_t count = 0;
+    pv_circular_buffer_get_count(object->buffer, &count);
+    if (count > __atomic_load_n(&object->peak_fill, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&object->peak_fill, count, __ATOMIC_RELAXED);
+    }
+}
+
+// hands PCM data over to the file writer thread; called with `object->mutex` held
+// the file buffer holds whole frames, so the data dropped on overflow never splits a frame and misaligns the WAV file
+static void pv_speaker_record(pv_speaker_t *object, const int8_t *pcm, int32_t num_frames) {
+    const int32_t batch_frames = pv_speaker_file_batch_frames(object);
+    while (num_frames > 0) {
+        int32_t available = 0;
+        pv_circular_buffer_get_available(object->file_buffer, &available);
+
+        int32_t to_write = num_frames < available ? num_frames : available;
+        if (to_write > 0) {
+            pv_circular_buffer_write(object->file_buffer, pcm, to_write);
+            pcm += to_write * object->frame_size;
+            num_frames -= to_write;
+        }
+
+        // wake up the writer only once there is a full batch, so that the disk sees large writes
+        int32_t count = 0;
+        pv_circular_buffer_get_count(object->file_buffer, &count);
+        if ((count >= batch_frames) || (num_frames > 0)) {
+            ma_event_signal(&(object->file_data_event));
+        }
+
+        if (num_frames > 0) {
+            if (object->file_overflow_policy == PV_SPEAKER_FILE_OVERFLOW_POLICY_DROP) {
+                __atomic_add_fetch(
+                        &object->file_dropped_bytes,
+                        (int64_t) num_frames * object->frame_size,
+                        __ATOMIC_RELAXED);
+                return;
+            }
+            ma_event_wait(&(object->file_space_event));
+        }
+    }
+}
+
+// drains the pending PCM data, stops the writer thread and finalizes the WAV header
+static void pv_speaker_close_file(pv_speaker_t *object) {
+    if (object->file == NULL) {
+        return;
+    }
+
+    __atomic_store_n(&object->is_file_stopping, true, __ATOMIC_RELEASE);
+    ma_event_signal(&(object->file_data_event));
+    pv_speaker_file_writer_join(object);
+
+    rewind(object->file);
+    write_wav_header(object, object->file);
+    fclose(object->file);
+    object->file = NULL;
+}
+
+PV_API void pv_speaker_delete(pv_speaker_t *object) {
+    if (object) {
+        pv_speaker_shared_context_lock_acquire();
+        if (object->context) {
+            ma_device_uninit(&(object->device));
+            pv_speaker_shared_context_release();
+        }
+        pv_speaker_shared_context_lock_release();
+
+        // streams that are still alive are detached, so that deleting them later only releases the stream itself.
+        // Slots are only ever filled once initialization has succeeded, so the mutex exists if any of them is.
+        bool has_streams = false;
+        for (int32_t i = 0; i < PV_SPEAKER_MAX_STREAMS; i++) {
+            has_streams = has_streams || (object->streams[i] != NULL);
+        }
+        if (has_streams) {
+            ma_mutex_lock(&object->mutex);
+            for (int32_t i = 0; i < PV_SPEAKER_MAX_STREAMS; i++) {
+                if (object->streams[i] != NULL) {
+                    object->streams[i]->speaker = NULL;
+                    object->streams[i] = NULL;
+                }
+            }
+            ma_mutex_unlock(&object->mutex);
+        }
+
+        pv_speaker_notification_fire(&object->available_notification);
+        pv_speaker_notification_fire(&object->drained_notification);
+        pv_speaker_close_file(object);
+        ma_mutex_uninit(&(object->mutex));
+        pv_speaker_waiters_uninit(&(object->waiters));
+        ma_event_uninit(&(object->file_data_event));
+        ma_event_uninit(&(object->file_space_event));
+        if (object->buffer != object->internal_buffer) {
+            pv_circular_buffer_delete(object->buffer);
+        }
+        pv_circular_buffer_delete(object->internal_buffer);
+        pv_circular_buffer_delete(object->marker_buffer);
+        pv_circular_buffer_delete(object->file_buffer);
+        free(object->file_batch);
+        pv_resampler_delete(object->resampler);
+        free(object->staging);
+        free(object->mix_buffer);
+        free(object);
+    }
+}
+
+PV_API pv_speaker_status_t pv_speaker_start(pv_speaker_t *object) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+
+    // `ma_device_start()` would fail on a started device as well, but only after the state below is reset under the
+    // running audio thread
+    const ma_device_state state = ma_device_get_state(&(object->device));
+    if (state == ma_device_state_uninitialized) {
+        return PV_SPEAKER_STATUS_DEVICE_NOT_INITIALIZED;
+    }
+    if (state != ma_device_state_stopped) {
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
+
+    // the device is stopped, so the audio thread is not touching these
+    object->is_starved = true;
+    object->pause_gain = 1.f;
+    __atomic_store_n(&object->is_paused, false, __ATOMIC_RELEASE);
+
+    ma_result result = ma_device_start(&(object->device));
+    if (result != MA_SUCCESS) {
+        if (result == MA_DEVICE_NOT_INITIALIZED) {
+            return PV_SPEAKER_STATUS_DEVICE_NOT_INITIALIZED;
+        } else {
+            // device already started
+            return PV_SPEAKER_STATUS_INVALID_STATE;
+        }
+    }
+
+    object->is_started = true;
+
+    return PV_SPEAKER_STATUS_SUCCESS;
+}
+
+PV_API pv_speaker_status_t pv_speaker_set_render_callback(
+        pv_speaker_t *object,
+        pv_speaker_render_callback_t render_callback,
+        void *user_data) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (object->is_started) {
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
+
+    ma_mutex_lock(&object->mutex);
+    if ((render_callback != NULL) && (object->file != NULL)) {
+        ma_mutex_unlock(&object->mutex);
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
+    object->render_callback = render_callback;
+    object->render_user_data = user_data;
+    ma_mutex_unlock(&object->mutex);
+
+    return PV_SPEAKER_STATUS_SUCCESS;
+}
+
+PV_API pv_speaker_status_t pv_speaker_set_shared_buffer(pv_speaker_t *object, int8_t *memory, int32_t length) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if ((memory != NULL) && ((((uintptr_t) memory) % sizeof(int32_t)) != 0)) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if ((memory != NULL) && ((length <= 0) || (length > (INT32_MAX / 2)))) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (object->is_started) {
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
+
+    pv_circular_buffer_t *buffer = object->internal_buffer;
+    int32_t buffer_capacity = object->internal_buffer_capacity;
+    if (memory != NULL) {
+        int32_t *indices = (int32_t *) memory;
+        pv_circular_buffer_status_t status = pv_circular_buffer_init_external(
+                length,
+                object->frame_size,
+                memory + PV_SPEAKER_SHARED_BUFFER_HEADER_SIZE,
+                &indices[PV_SPEAKER_SHARED_BUFFER_WRITE_INDEX],
+                &indices[PV_SPEAKER_SHARED_BUFFER_READ_INDEX],
+                &buffer);
+        if (status != PV_CIRCULAR_BUFFER_STATUS_SUCCESS) {
+            return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
+        }
+        buffer_capacity = length;
+    }
+
+    ma_mutex_lock(&object->mutex);
+    if (object->buffer != object->internal_buffer) {
+        pv_circular_buffer_delete(object->buffer);
+    }
+    object->buffer = buffer;
+    object->buffer_capacity = buffer_capacity;
+    ma_mutex_unlock(&object->mutex);
+
+    return PV_SPEAKER_STATUS_SUCCESS;
+}
+
+// the PCM data of a shared buffer only comes from its producer, so the write calls of this library are refused
+static inline bool pv_speaker_is_buffer_shared(const pv_speaker_t *object) {
+    return object->buffer != object->internal_buffer;
+}
+
+PV_API pv_speaker_status_t pv_speaker_write(pv_speaker_t *object, int8_t *pcm, int32_t pcm_length, int32_t *written_length) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!pcm) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (pcm_length <= 0) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!written_length) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!(object->is_started) || (object->render_callback != NULL) || pv_speaker_is_buffer_shared(object)) {
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
+
+    ma_mutex_lock(&object->mutex);
+
+    int32_t available = 0;
+    pv_circular_buffer_status_t status = pv_circular_buffer_get_available(object->buffer, &available);
+    if (status != PV_CIRCULAR_BUFFER_STATUS_SUCCESS) {
+        ma_mutex_unlock(&object->mutex);
+        return PV_SPEAKER_STATUS_RUNTIME_ERROR;
+    }
+
+    int32_t to_write = pcm_length < available ? pcm_length : available;
+    if (to_write > 0) {
+        status = pv_circular_buffer_write(object->buffer, pcm, to_write);
+        if (status != PV_CIRCULAR_BUFFER_STATUS_SUCCESS) {
+            ma_mutex_unlock(&object->mutex);
+            return PV_SPEAKER_STATUS_RUNTIME_ERROR;
+        }
+        pv_speaker_count_written(object, to_write);
+
+        if (object->file != NULL) {
+            pv_speaker_record(object, pcm, to_write);
+        }
+    }
+
+    *written_length = to_write;
+
+    ma_mutex_unlock(&object->mutex);
+
+    return PV_SPEAKER_STATUS_SUCCESS;
+}
+
+PV_API pv_speaker_status_t pv_speaker_write_reserve(
+        pv_speaker_t *object,
+        int32_t max_length,
+        int8_t **pcm1,
+        int32_t *pcm1_length,
+        int8_t **pcm2,
+        int32_t *pcm2_length) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (max_length <= 0) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!pcm1 || !pcm1_length || !pcm2 || !pcm2_length) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!(object->is_started) || (object->render_callback != NULL) || pv_speaker_is_buffer_shared(object)) {
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
+
+    void *region1 = NULL;
+    void *region2 = NULL;
+    pv_circular_buffer_status_t status = pv_circular_buffer_write_reserve(
+            object->buffer,
+            max_length,
+            &region1,
+            pcm1_length,
+            &region2,
+            pcm2_length);
+    if (status != PV_CIRCULAR_BUFFER_STATUS_SUCCESS) {
+        return PV_SPEAKER_STATUS_RUNTIME_ERROR;
+    }
+
+    *pcm1 = (int8_t *) region1;
+    *pcm2 = (int8_t *) region2;
+
+    return PV_SPEAKER_STATUS_SUCCESS;
+}
+
+PV_API pv_speaker_status_t pv_speaker_write_commit(pv_speaker_t *object, int32_t length) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (length < 0) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!(object->is_started) || (object->render_callback != NULL) || pv_speaker_is_buffer_shared(object)) {
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
+    if (length == 0) {
+        return PV_SPEAKER_STATUS_SUCCESS;
+    }
+
+    ma_mutex_lock(&object->mutex);
+
+    if (object->file != NULL) {
+        // the write index has not moved yet, so reserving again yields the regions that are about to be committed
+        void *region1 = NULL;
+        int32_t region1_length = 0;
+        void *region2 = NULL;
+        int32_t region2_length = 0;
+        pv_circular_buffer_status_t status = pv_circular_buffer_write_reserve(
+                object->buffer,
+                length,
+                &region1,
+                &region1_length,
+                &region2,
+                &region2_length);
+        if ((status != PV_CIRCULAR_BUFFER_STATUS_SUCCESS) || (region1_length + region2_length < length)) {
+            ma_mutex_unlock(&object->mutex);
+            return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+        }
+
+        // only `length` samples are committed, even if the free space reserved again is larger
+        region1_length = region1_length < length ? region1_length : length;
+        region2_length = length - region1_length;
+
+        pv_speaker_record(object, region1, region1_length);
+        if (region2_length > 0) {
+            pv_speaker_record(object, region2, region2_length);
+        }
+    }
+
+    pv_circular_buffer_status_t status = pv_circular_buffer_write_commit(object->buffer, length);
+    if (status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS) {
+        pv_speaker_count_written(object, length);
+    }
+
+    ma_mutex_unlock(&object->mutex);
+
+    if (status != PV_CIRCULAR_BUFFER_STATUS_SUCCESS) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+
+    return PV_SPEAKER_STATUS_SUCCESS;
+}
+
+// writes all of `pcm`, waiting for the device to free up space, until done, stopped or past `deadline_ns` (0 for none)
+static pv_speaker_status_t pv_speaker_write_until(
+        pv_speaker_t *object,
+        const int8_t *pcm,
+        int32_t pcm_length,
+        uint64_t deadline_ns,
+        int32_t *written_length) {
+    int32_t written = 0;
+    *written_length = 0;
+
+    if (pcm != NULL) {
+        while (!__atomic_load_n(&object->is_stop_flush, __ATOMIC_ACQUIRE) && written < pcm_length) {
+            ma_mutex_lock(&object->mutex);
+
+            // `pv_speaker_cancel()` may have held the mutex while this thread waited for it
+            if (__atomic_load_n(&object->is_stop_flush, __ATOMIC_ACQUIRE)) {
+                ma_mutex_unlock(&object->mutex);
+                break;
+            }
+
+            int32_t available = 0;
+            pv_circular_buffer_status_t status = pv_circular_buffer_get_available(object->buffer, &available);
+            if (status != PV_CIRCULAR_BUFFER_STATUS_SUCCESS) {
+                ma_mutex_unlock(&object->mutex);
+                return PV_SPEAKER_STATUS_RUNTIME_ERROR;
+            }
+
+            int32_t remaining = pcm_length - written;
+            int32_t to_write = remaining < available ? remaining : available;
+            if (to_write > 0) {
+                status = pv_circular_buffer_write(
+                        object->buffer,
+                        &pcm[written * object->frame_size],
+                        to_write);
+                if (status != PV_CIRCULAR_BUFFER_STATUS_SUCCESS) {
+                    ma_mutex_unlock(&object->mutex);
+                    return PV_SPEAKER_STATUS_RUNTIME_ERROR;
+                }
+                pv_speaker_count_written(object, to_write);
+
+                if (object->file != NULL) {
+                    pv_speaker_record(object, &pcm[written * object->frame_size], to_write);
+                }
+
+                written += to_write;
+                *written_length += to_write;
+            }
+
+            ma_mutex_unlock(&object->mutex);
+
+            if ((written < pcm_length) && !pv_speaker_wait_for_callback(object, deadline_ns)) {
+                return PV_SPEAKER_STATUS_TIMEOUT;
+            }
+        }
+    }
+
+    return PV_SPEAKER_STATUS_SUCCESS;
+}
+
+// waits until the device has played everything in the circular buffer
+static pv_speaker_status_t pv_speaker_drain_until(pv_speaker_t *object, uint64_t deadline_ns) {
+    pv_speaker_status_t status = PV_SPEAKER_STATUS_SUCCESS;
+
+    __atomic_store_n(&object->is_draining, true, __ATOMIC_RELEASE);
+
+    // waits for all frames to be copied to output buffer
+    while (!__atomic_load_n(&object->is_stop_flush, __ATOMIC_ACQUIRE) &&
+           !__atomic_load_n(&object->is_data_requested_while_empty, __ATOMIC_ACQUIRE)) {
+        int32_t count = 0;
+        pv_circular_buffer_status_t circular_buffer_status = pv_circular_buffer_get_count(object->buffer, &count);
+        if (circular_buffer_status != PV_CIRCULAR_BUFFER_STATUS_SUCCESS) {
+            status = PV_SPEAKER_STATUS_RUNTIME_ERROR;
+            break;
+        }
+        if (count == 0) {
+            __atomic_store_n(&object->is_flushed_and_empty, true, __ATOMIC_RELEASE);
+        }
+
+        if (!pv_speaker_wait_for_callback(object, deadline_ns)) {
+            status = PV_SPEAKER_STATUS_TIMEOUT;
+            break;
+        }
+    }
+
+    __atomic_store_n(&object->is_flushed_and_empty, false, __ATOMIC_RELEASE);
+    __atomic_store_n(&object->is_data_requested_while_empty, false, __ATOMIC_RELEASE);
+    __atomic_store_n(&object->is_draining, false, __ATOMIC_RELEASE);
+
+    return status;
+}
+
+static pv_speaker_status_t pv_speaker_flush_until(
+        pv_speaker_t *object,
+        int8_t *pcm,
+        int32_t pcm_length,
+        uint64_t deadline_ns,
+        int32_t *written_length) {
+    __atomic_store_n(&object->is_stop_flush, false, __ATOMIC_RELEASE);
+
+    pv_speaker_status_t status = pv_speaker_write_until(object, pcm, pcm_length, deadline_ns, written_length);
+    if (status != PV_SPEAKER_STATUS_SUCCESS) {
+        return status;
+    }
+
+    return pv_speaker_drain_until(object, deadline_ns);
+}
+
+PV_API pv_speaker_status_t pv_speaker_flush(pv_speaker_t *object, int8_t *pcm, int32_t pcm_length, int32_t *written_length) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (pcm_length < 0) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!written_length) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!(object->is_started) || (object->render_callback != NULL)) {
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
+    if ((pcm_length > 0) && pv_speaker_is_buffer_shared(object)) {
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
+
+    return pv_speaker_flush_until(object, pcm, pcm_length, 0, written_length);
+}
+
+PV_API pv_speaker_status_t pv_speaker_flush_timeout(
+        pv_speaker_t *object,
+        int8_t *pcm,
+        int32_t pcm_length,
+        int32_t timeout_ms,
+        int32_t *written_length) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (pcm_length < 0) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (timeout_ms < 0) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!written_length) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!(object->is_started) || (object->render_callback != NULL)) {
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
+    if ((pcm_length > 0) && pv_speaker_is_buffer_shared(object)) {
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
+
+    const uint64_t deadline_ns = pv_speaker_get_time_ns() + ((uint64_t) timeout_ms * 1000000ULL);
+    return pv_speaker_flush_until(object, pcm, pcm_length, deadline_ns, written_length);
+}
+
+PV_API pv_speaker_status_t pv_speaker_notify_available(
+        pv_speaker_t *object,
+        int32_t length,
+        pv_speaker_notification_callback_t callback,
+        void *user_data) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (length <= 0) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!callback) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+
+    ma_mutex_lock(&object->mutex);
+
+    if (!(object->is_started) || (object->render_callback != NULL)) {
+        ma_mutex_unlock(&object->mutex);
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
+
+    length = (length < object->buffer_capacity) ? length : object->buffer_capacity;
+    if (!pv_speaker_notification_arm(&object->available_notification, length, callback, user_data)) {
+        ma_mutex_unlock(&object->mutex);
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
+
+    // only the audio thread frees up space, so room that is there already would otherwise be noticed a period late
+    int32_t available = 0;
+    pv_circular_buffer_get_available(object->buffer, &available);
+
+    ma_mutex_unlock(&object->mutex);
+
+    if (available >= length) {
+        pv_speaker_notification_fire(&object->available_notification);
+    }
+
+    return PV_SPEAKER_STATUS_SUCCESS;
+}
+
+PV_API pv_speaker_status_t pv_speaker_notify_drained(
+        pv_speaker_t *object,
+        pv_speaker_notification_callback_t callback,
+        void *user_data) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!callback) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+
+    ma_mutex_lock(&object->mutex);
+
+    if (!(object->is_started) || (object->render_callback != NULL)) {
+        ma_mutex_unlock(&object->mutex);
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
+
+    // pads the resampler with silence once the circular buffer runs dry, and keeps the tail from counting as underrun
+    __atomic_store_n(&object->is_draining, true, __ATOMIC_RELEASE);
+    if (!pv_speaker_notification_arm(&object->drained_notification, 0, callback, user_data)) {
+        ma_mutex_unlock(&object->mutex);
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
+
+    ma_mutex_unlock(&object->mutex);
+
+    return PV_SPEAKER_STATUS_SUCCESS;
+}
+
+PV_API void pv_speaker_signal_fd(void *user_data) {
+    const int fd = (int) (intptr_t) user_data;
+    const uint64_t count = 1;
+
+#if defined(__PV_SPEAKER_PLATFORM_WINDOWS__)
+
+    (void) _write(fd, &count, sizeof(count));
+
+#else
+
+    // a full pipe already wakes up the reader, so a failed write loses nothing
+    ssize_t result = write(fd, &count, sizeof(count));
+    (void) result;
+
+#endif
+}
+
+PV_API pv_speaker_status_t pv_speaker_write_blocking(
+        pv_speaker_t *object,
+        int8_t *pcm,
+        int32_t pcm_length,
+        int32_t timeout_ms,
+        int32_t *written_length) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!pcm) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (pcm_length <= 0) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!written_length) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!(object->is_started) || (object->render_callback != NULL) || pv_speaker_is_buffer_shared(object)) {
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
+
+    // stop and cancel end the wait the same way they end a flush
+    __atomic_store_n(&object->is_stop_flush, false, __ATOMIC_RELEASE);
 
-#define PV_SPEAKER_VERSION "1.0.0"
+    const uint64_t deadline_ns = (timeout_ms < 0)
+            ? 0
+            : (pv_speaker_get_time_ns() + ((uint64_t) timeout_ms * 1000000ULL));
+    return pv_speaker_write_until(object, pcm, pcm_length, deadline_ns, written_length);
+}
 
-static volatile bool is_stop_flush = false;
-static volatile bool is_flushed_and_empty = false;
-static volatile bool is_data_requested_while_empty = false;
+PV_API pv_speaker_status_t pv_speaker_pack_int24(const int32_t *pcm, int32_t pcm_length, int8_t *packed_pcm) {
+    if (!pcm) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (pcm_length < 0) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!packed_pcm) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
 
-static const int32_t FLUSH_SLEEP_MS = 2;
+    uint8_t *output = (uint8_t *) packed_pcm;
+    for (int32_t i = 0; i < pcm_length; i++) {
+        const uint32_t sample = (uint32_t) pcm[i];
+        output[(3 * i)] = (uint8_t) sample;
+        output[(3 * i) + 1] = (uint8_t) (sample >> 8);
+        output[(3 * i) + 2] = (uint8_t) (sample >> 16);
+    }
 
-struct pv_speaker {
-    ma_context context;
-    ma_device device;
-    pv_circular_buffer_t *buffer;
-    int32_t sample_rate;
-    int32_t bits_per_sample;
-    bool is_started;
-    ma_mutex mutex;
-    FILE *file;
-    int32_t num_samples;
-};
+    return PV_SPEAKER_STATUS_SUCCESS;
+}
 
-static void pv_speaker_ma_callback(ma_device *device, void *output, const void *input, ma_uint32 frame_count) {
-    (void) input;
+typedef struct {
+    uint16_t audio_format;
+    uint16_t num_channels;
+    uint32_t sample_rate;
+    uint16_t bits_per_sample;
+    int64_t data_offset;
+    int64_t data_size;
+} pv_speaker_wav_info_t;
+
+// walks the RIFF chunks up to `data`, skipping the ones it does not know about (e.g. `LIST`)
+static pv_speaker_status_t pv_speaker_read_wav_info(FILE *file, int64_t file_size, pv_speaker_wav_info_t *info) {
+    memset(info, 0, sizeof(pv_speaker_wav_info_t));
+
+    uint8_t riff[12];
+    if ((fread(riff, sizeof(riff), 1, file) != 1) ||
+        (memcmp(riff, "RIFF", 4) != 0) ||
+        (memcmp(&riff[8], "WAVE", 4) != 0)) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
 
-    pv_speaker_t *object = (pv_speaker_t *) device->pUserData;
+    bool is_fmt_found = false;
+    int64_t offset = sizeof(riff);
+    while (true) {
+        uint8_t chunk_id[4];
+        uint32_t chunk_size = 0;
+        if ((fread(chunk_id, sizeof(chunk_id), 1, file) != 1) ||
+            (fread(&chunk_size, sizeof(chunk_size), 1, file) != 1)) {
+            return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+        }
+        offset += sizeof(chunk_id) + sizeof(chunk_size);
+
+        if (memcmp(chunk_id, "fmt ", 4) == 0) {
+            uint8_t fmt[40];
+            const size_t fmt_size = chunk_size < sizeof(fmt) ? chunk_size : sizeof(fmt);
+            if ((chunk_size < 16) || (fread(fmt, fmt_size, 1, file) != 1)) {
+                return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+            }
+            memcpy(&info->audio_format, &fmt[0], sizeof(info->audio_format));
+            memcpy(&info->num_channels, &fmt[2], sizeof(info->num_channels));
+            memcpy(&info->sample_rate, &fmt[4], sizeof(info->sample_rate));
+            memcpy(&info->bits_per_sample, &fmt[14], sizeof(info->bits_per_sample));
+            if ((info->audio_format == PV_SPEAKER_WAVE_FORMAT_EXTENSIBLE) && (fmt_size >= 26)) {
+                memcpy(&info->audio_format, &fmt[24], sizeof(info->audio_format));
+            }
+            is_fmt_found = true;
+        } else if (memcmp(chunk_id, "data", 4) == 0) {
+            if (!is_fmt_found) {
+                return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+            }
+            // recordings cut short (e.g. a crashed writer) may claim more data than the file holds
+            info->data_offset = offset;
+            info->data_size = (offset + chunk_size) <= file_size ? chunk_size : (file_size - offset);
+            return PV_SPEAKER_STATUS_SUCCESS;
+        }
+
+        // chunks are padded to an even number of bytes
+        offset += chunk_size + (chunk_size & 1);
+        if ((offset >= file_size) || (fseek(file, (long) offset, SEEK_SET) != 0)) {
+            return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+        }
+    }
+}
+
+PV_API pv_speaker_status_t pv_speaker_play_file(pv_speaker_t *object, const char *input_wav_path) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!input_wav_path) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!(object->is_started) || (object->render_callback != NULL) || pv_speaker_is_buffer_shared(object)) {
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
+
+    FILE *file = fopen(input_wav_path, "rb");
+    if (file == NULL) {
+        return PV_SPEAKER_STATUS_IO_ERROR;
+    }
+
+    fseek(file, 0, SEEK_END);
+    const int64_t file_size = ftell(file);
+    rewind(file);
+
+    pv_speaker_wav_info_t info;
+    pv_speaker_status_t status = pv_speaker_read_wav_info(file, file_size, &info);
+    if (status != PV_SPEAKER_STATUS_SUCCESS) {
+        fclose(file);
+        return status;
+    }
+    const uint16_t audio_format = object->is_float ? PV_SPEAKER_WAVE_FORMAT_IEEE_FLOAT : PV_SPEAKER_WAVE_FORMAT_PCM;
+    if ((info.audio_format != audio_format) ||
+        (info.num_channels != object->num_channels) ||
+        (info.sample_rate != (uint32_t) object->sample_rate) ||
+        (info.bits_per_sample != object->bits_per_sample)) {
+        fclose(file);
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+
+    const int32_t frame_size = object->frame_size;
+    const int64_t num_frames = info.data_size / frame_size;
+    int32_t written_length = 0;
+
+    __atomic_store_n(&object->is_stop_flush, false, __ATOMIC_RELEASE);
+
+#if defined(__PV_SPEAKER_PLATFORM_WINDOWS__)
+
+    // streams the file through a small buffer so that memory use does not depend on its length
+    int8_t *chunk = malloc(PV_SPEAKER_PLAY_FILE_CHUNK_FRAMES * frame_size);
+    if (chunk == NULL) {
+        fclose(file);
+        return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
+    }
+
+    fseek(file, (long) info.data_offset, SEEK_SET);
+    for (int64_t played = 0; played < num_frames;) {
+        const int64_t remaining = num_frames - played;
+        const int32_t length = (int32_t) (remaining < PV_SPEAKER_PLAY_FILE_CHUNK_FRAMES
+                ? remaining
+                : PV_SPEAKER_PLAY_FILE_CHUNK_FRAMES);
+        if (fread(chunk, frame_size, length, file) != (size_t) length) {
+            status = PV_SPEAKER_STATUS_IO_ERROR;
+            break;
+        }
+
+        status = pv_speaker_write_until(object, chunk, length, 0, &written_length);
+        if ((status != PV_SPEAKER_STATUS_SUCCESS) || (written_length < length)) {
+            break;
+        }
+        played += length;
+    }
+
+    free(chunk);
+    fclose(file);
+
+#else
+
+    const size_t map_length = (size_t) (info.data_offset + info.data_size);
+    int8_t *map = mmap(NULL, map_length, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    fclose(file);
+    if (map == MAP_FAILED) {
+        return PV_SPEAKER_STATUS_IO_ERROR;
+    }
+
+    madvise(map, map_length, MADV_SEQUENTIAL);
+
+    const int64_t page_size = sysconf(_SC_PAGESIZE);
+    const int8_t *data = map + info.data_offset;
+    int64_t released = 0;
+    for (int64_t played = 0; played < num_frames;) {
+        const int64_t remaining = num_frames - played;
+        const int32_t length = (int32_t) (remaining < PV_SPEAKER_PLAY_FILE_CHUNK_FRAMES
+                ? remaining
+                : PV_SPEAKER_PLAY_FILE_CHUNK_FRAMES);
+
+        status = pv_speaker_write_until(object, &data[played * frame_size], length, 0, &written_length);
+        if ((status != PV_SPEAKER_STATUS_SUCCESS) || (written_length < length)) {
+            break;
+        }
+        played += length;
+
+        // pages already copied into the circular buffer are not needed again, so resident memory stays flat
+        const int64_t consumed = ((info.data_offset + (played * frame_size)) / page_size) * page_size;
+        if (consumed > released) {
+            madvise(map + released, (size_t) (consumed - released), MADV_DONTNEED);
+            released = consumed;
+        }
+    }
+
+    munmap(map, map_length);
+
+#endif
+
+    if (status != PV_SPEAKER_STATUS_SUCCESS) {
+        return status;
+    }
+
+    return pv_speaker_drain_until(object, 0);
+}
+
+PV_API pv_speaker_status_t pv_speaker_stop(pv_speaker_t *object) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+
+    __atomic_store_n(&object->is_stop_flush, true, __ATOMIC_RELEASE);
+
+    ma_result result = ma_device_stop(&(object->device));
+
+    // the callback no longer runs, so wake up any blocked writer or flush directly
+    pv_speaker_wake_waiters(object);
+
+    if (result != MA_SUCCESS) {
+        if (result == MA_DEVICE_NOT_INITIALIZED) {
+            return PV_SPEAKER_STATUS_DEVICE_NOT_INITIALIZED;
+        } else {
+            // device already stopped
+            return PV_SPEAKER_STATUS_INVALID_STATE;
+        }
+    }
 
     ma_mutex_lock(&object->mutex);
+    // the callback no longer runs, so this thread is the consumer of the circular buffer now
+    pv_speaker_discard_buffer(object, -1);
+    // a cancel that timed out is done as well, rather than dropping what is written after the next start
+    object->applied_cancel_generation = __atomic_load_n(&object->cancel_generation, __ATOMIC_ACQUIRE);
+    object->is_cancelling = false;
+    __atomic_store_n(&object->completed_cancel_generation, object->applied_cancel_generation, __ATOMIC_RELEASE);
+    // leaves the write index of a shared buffer to its producer and only catches up with it
+    pv_circular_buffer_reset(object->buffer);
+    if (object->resampler != NULL) {
+        pv_resampler_reset(object->resampler);
+        object->resampler_padding = 0;
+    }
+    object->is_started = false;
+    pv_speaker_close_file(object);
+    ma_mutex_unlock(&object->mutex);
 
-    // this callback being invoked after calling `pv_speaker_flush` and the circular buffer is empty indicates that all
-    // frames have been passed to the output buffer, and the device can stop without truncating the last frame of audio
-    if (is_flushed_and_empty) {
-        is_data_requested_while_empty = true;
-        ma_mutex_unlock(&object->mutex);
-        return;
+    // nothing can be armed anymore once `is_started` is cleared
+    __atomic_store_n(&object->is_draining, false, __ATOMIC_RELEASE);
+    pv_speaker_notification_fire(&object->available_notification);
+    pv_speaker_notification_fire(&object->drained_notification);
+
+    return PV_SPEAKER_STATUS_SUCCESS;
+}
+
+PV_API pv_speaker_status_t pv_speaker_cancel(pv_speaker_t *object, int32_t fade_ms, int32_t *discarded_length) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (fade_ms < 0) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!discarded_length) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!(object->is_started) || (object->render_callback != NULL)) {
+        return PV_SPEAKER_STATUS_INVALID_STATE;
     }
 
-    int32_t read_length = 0;
-    pv_circular_buffer_read(object->buffer, output, (int32_t) frame_count, &read_length);
+    // holding the mutex keeps writers out while the end of the PCM data to drop is taken, so nothing written after the
+    // cancel is lost, even if the wait below times out and the callback drops the data later on
+    ma_mutex_lock(&object->mutex);
+
+    // ends a blocked flush, the same way `pv_speaker_stop()` does
+    __atomic_store_n(&object->is_stop_flush, true, __ATOMIC_RELEASE);
+    pv_speaker_wake_waiters(object);
+
+    __atomic_store_n(
+            &object->requested_cancel_fade_frames,
+            (int32_t) pv_speaker_frames_or_ms(0, fade_ms, object->device_sample_rate),
+            __ATOMIC_RELAXED);
+    int32_t end_position = 0;
+    pv_circular_buffer_get_write_position(object->buffer, &end_position);
+    __atomic_store_n(&object->requested_cancel_end_position, end_position, __ATOMIC_RELAXED);
+    const uint32_t generation = __atomic_add_fetch(&object->cancel_generation, 1, __ATOMIC_RELEASE);
+
+    // the audio callback drops the buffer within one period after the fade. A concurrent `pv_speaker_stop()` wakes this
+    // thread up once the callback does not run anymore, and the buffer is dropped here instead. If the device stops
+    // calling back without being stopped, the wait gives up rather than holding the mutex forever.
+    const int64_t period_ms =
+            ((int64_t) object->device.playback.internalPeriodSizeInFrames * 1000) / object->device_sample_rate;
+    int64_t timeout_ms = PV_SPEAKER_CANCEL_TIMEOUT_PERIODS * period_ms;
+    timeout_ms = (timeout_ms < PV_SPEAKER_CANCEL_MIN_TIMEOUT_MS) ? PV_SPEAKER_CANCEL_MIN_TIMEOUT_MS : timeout_ms;
+    const uint64_t deadline_ns = pv_speaker_get_time_ns() + ((uint64_t) (fade_ms + timeout_ms) * 1000000ULL);
+
+    bool is_completed = false;
+    bool is_stopped = false;
+    __atomic_add_fetch(&object->num_waiters, 1, __ATOMIC_SEQ_CST);
+    pv_speaker_waiters_lock(&object->waiters);
+    while (true) {
+        // both are checked under the lock the callback and `pv_speaker_stop()` wake waiters with, so neither is missed
+        is_completed = __atomic_load_n(&object->completed_cancel_generation, __ATOMIC_ACQUIRE) == generation;
+        is_stopped = ma_device_get_state(&(object->device)) == ma_device_state_stopped;
+        const uint64_t now_ns = pv_speaker_get_time_ns();
+        if (is_completed || is_stopped || (now_ns >= deadline_ns)) {
+            break;
+        }
+        pv_speaker_waiters_wait(&object->waiters, now_ns, deadline_ns);
+    }
+    pv_speaker_waiters_unlock(&object->waiters);
+    __atomic_sub_fetch(&object->num_waiters, 1, __ATOMIC_SEQ_CST);
+
+    pv_speaker_status_t status = PV_SPEAKER_STATUS_SUCCESS;
+    if (!is_completed && is_stopped) {
+        object->applied_cancel_generation = generation;
+        object->cancel_end_position = end_position;
+        pv_speaker_complete_cancel(object);
+    } else if (!is_completed) {
+        // the callback still applies the cancel once it runs again, and only drops what was written before this call.
+        // Pending notifications are fired below all the same, since their waiters asked to be cancelled.
+        status = PV_SPEAKER_STATUS_TIMEOUT;
+    }
+
+    *discarded_length = (status == PV_SPEAKER_STATUS_SUCCESS)
+            ? __atomic_load_n(&object->cancel_discarded_length, __ATOMIC_RELAXED)
+            : 0;
+
+    const bool is_drained_pending = pv_speaker_notification_is_pending(&object->drained_notification);
 
     ma_mutex_unlock(&object->mutex);
+
+    // the buffer is empty now, or will be once the device calls back again, so waiters do not wait for that
+    if (is_drained_pending) {
+        __atomic_store_n(&object->is_draining, false, __ATOMIC_RELEASE);
+        pv_speaker_notification_fire(&object->drained_notification);
+    }
+    pv_speaker_notification_fire(&object->available_notification);
+
+    return status;
 }
 
-PV_API pv_speaker_status_t pv_speaker_init(
+PV_API pv_speaker_status_t pv_speaker_get_position(
+        pv_speaker_t *object,
+        int64_t *frames_played,
+        uint64_t *timestamp_ns) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!frames_played) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!timestamp_ns) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+
+    const uint64_t now_ns = pv_speaker_get_time_ns();
+    const int64_t position = pv_speaker_interpolate_position(object, now_ns);
+
+    *frames_played = position;
+    *timestamp_ns = now_ns;
+
+    return PV_SPEAKER_STATUS_SUCCESS;
+}
+
+PV_API pv_speaker_status_t pv_speaker_add_marker(
+        pv_speaker_t *object,
+        int64_t frame_index,
+        pv_speaker_marker_callback_t callback,
+        void *user_data) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (frame_index < 0) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!callback) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+
+    const pv_speaker_marker_t marker = {
+            .frame_index = frame_index,
+            .callback = callback,
+            .user_data = user_data,
+    };
+
+    // the queue has a single producer, so adding markers is serialized like writing PCM data
+    ma_mutex_lock(&object->mutex);
+    int32_t available = 0;
+    pv_circular_buffer_get_available(object->marker_buffer, &available);
+    if (available > 0) {
+        pv_circular_buffer_write(object->marker_buffer, &marker, 1);
+    }
+    ma_mutex_unlock(&object->mutex);
+
+    return (available > 0) ? PV_SPEAKER_STATUS_SUCCESS : PV_SPEAKER_STATUS_INVALID_STATE;
+}
+
+PV_API pv_speaker_status_t pv_speaker_pause(pv_speaker_t *object) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!object->is_started) {
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
+
+    __atomic_store_n(&object->is_paused, true, __ATOMIC_RELEASE);
+
+    return PV_SPEAKER_STATUS_SUCCESS;
+}
+
+PV_API pv_speaker_status_t pv_speaker_resume(pv_speaker_t *object) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!object->is_started) {
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
+
+    __atomic_store_n(&object->is_paused, false, __ATOMIC_RELEASE);
+
+    return PV_SPEAKER_STATUS_SUCCESS;
+}
+
+PV_API bool pv_speaker_get_is_paused(pv_speaker_t *object) {
+    if (!object) {
+        return false;
+    }
+    return __atomic_load_n(&object->is_paused, __ATOMIC_ACQUIRE);
+}
+
+PV_API pv_speaker_status_t pv_speaker_stream_init(
+        pv_speaker_t *object,
         int32_t sample_rate,
         int16_t bits_per_sample,
-        int32_t buffer_size_secs,
-        int32_t device_index,
-        pv_speaker_t **object) {
-    if (device_index < PV_SPEAKER_DEFAULT_DEVICE_INDEX) {
+        bool is_float,
+        int32_t buffer_size_frames,
+        pv_speaker_stream_t **stream) {
+    if (!object) {
         return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
     }
     if (sample_rate <= 0) {
@@ -83,199 +2563,134 @@ PV_API pv_speaker_status_t pv_speaker_init(
         bits_per_sample != 32) {
         return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
     }
-    if (buffer_size_secs <= 0) {
+    if (is_float && (bits_per_sample != 32)) {
         return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
     }
-    if (!object) {
+    if ((buffer_size_frames <= 0) || (buffer_size_frames > (INT32_MAX / 2))) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!stream) {
         return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
     }
+    if (!object->is_mixer) {
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
 
-    *object = NULL;
+    *stream = NULL;
 
-    pv_speaker_t *o = calloc(1, sizeof(pv_speaker_t));
+    pv_speaker_stream_t *o = calloc(1, sizeof(pv_speaker_stream_t));
     if (!o) {
         return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
     }
 
-    ma_result result = ma_context_init(NULL, 0, NULL, &(o->context));
-    if (result != MA_SUCCESS) {
-        pv_speaker_delete(o);
-        if ((result == MA_NO_BACKEND) || (result == MA_FAILED_TO_INIT_BACKEND)) {
-            return PV_SPEAKER_STATUS_BACKEND_ERROR;
-        } else if (result == MA_OUT_OF_MEMORY) {
-            return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
-        } else {
-            return PV_SPEAKER_STATUS_RUNTIME_ERROR;
-        }
-    }
-
-    int16_t ma_format;
+    o->speaker = object;
+    o->gain = 1.f;
     switch (bits_per_sample) {
         case 8:
-            ma_format = ma_format_u8;
+            o->format = ma_format_u8;
             break;
         case 16:
-            ma_format = ma_format_s16;
+            o->format = ma_format_s16;
             break;
         case 24:
-            ma_format = ma_format_s24;
-            break;
-        case 32:
-            ma_format = ma_format_s32;
+            o->format = ma_format_s24;
             break;
         default:
-            ma_format = ma_format_unknown;
+            o->format = is_float ? ma_format_f32 : ma_format_s32;
             break;
     }
-
-    ma_device_config device_config;
-    device_config = ma_device_config_init(ma_device_type_playback);
-    device_config.playback.format = ma_format;
-    device_config.playback.channels = MA_CHANNEL_MONO;
-    device_config.sampleRate = sample_rate;
-    device_config.dataCallback = pv_speaker_ma_callback;
-    device_config.pUserData = o;
-
-    if (device_index != PV_SPEAKER_DEFAULT_DEVICE_INDEX) {
-        ma_device_info *playback_info = NULL;
-        ma_uint32 count = 0;
-        result = ma_context_get_devices(
-                &(o->context),
-                &playback_info,
-                &count,
-                NULL,
-                NULL);
-        if (result != MA_SUCCESS) {
-            pv_speaker_delete(o);
-            if (result == MA_OUT_OF_MEMORY) {
-                return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
-            } else {
-                return PV_SPEAKER_STATUS_RUNTIME_ERROR;
-            }
-        }
-        if (count == 0) {
-            pv_speaker_delete(o);
-            return PV_SPEAKER_STATUS_RUNTIME_ERROR;
-        }
-        if (device_index >= count) {
-            pv_speaker_delete(o);
-            return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
-        }
-        device_config.playback.pDeviceID = &playback_info[device_index].id;
+
+    const int32_t frame_size = object->num_channels * (bits_per_sample / 8);
+    pv_circular_buffer_status_t status = pv_circular_buffer_init_mirrored(buffer_size_frames, frame_size, &(o->buffer));
+    if (status == PV_CIRCULAR_BUFFER_STATUS_OUT_OF_MEMORY) {
+        status = pv_circular_buffer_init(buffer_size_frames, frame_size, &(o->buffer));
+    }
+    if (status != PV_CIRCULAR_BUFFER_STATUS_SUCCESS) {
+        pv_speaker_stream_delete(o);
+        return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
     }
 
-    result = ma_device_init(&(o->context), &device_config, &(o->device));
-    if (result != MA_SUCCESS) {
-        pv_speaker_delete(o);
-        if (result == MA_DEVICE_ALREADY_INITIALIZED) {
-            return PV_SPEAKER_STATUS_DEVICE_ALREADY_INITIALIZED;
-        } else if (result == MA_OUT_OF_MEMORY) {
-            return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
-        } else {
-            return PV_SPEAKER_STATUS_RUNTIME_ERROR;
-        }
+    o->staging = malloc((size_t) PV_RESAMPLER_MAX_SOURCE_FRAMES * frame_size);
+    if (!o->staging) {
+        pv_speaker_stream_delete(o);
+        return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
     }
 
-    result = ma_mutex_init(&(o->mutex));
-    if (result != MA_SUCCESS) {
-        pv_speaker_delete(o);
-        if (result == MA_OUT_OF_MEMORY) {
-            return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
-        } else {
-            return PV_SPEAKER_STATUS_RUNTIME_ERROR;
+    if (sample_rate != object->device_sample_rate) {
+        pv_resampler_status_t resampler_status = pv_resampler_init(
+                sample_rate,
+                object->device_sample_rate,
+                object->num_channels,
+                PV_RESAMPLER_QUALITY_SINC,
+                &(o->resampler));
+        if (resampler_status != PV_RESAMPLER_STATUS_SUCCESS) {
+            pv_speaker_stream_delete(o);
+            if (resampler_status == PV_RESAMPLER_STATUS_OUT_OF_MEMORY) {
+                return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
+            } else {
+                return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+            }
         }
     }
 
-    const int32_t buffer_capacity = buffer_size_secs * sample_rate;
-    const int32_t element_size = bits_per_sample / 8;
-    pv_circular_buffer_status_t status = pv_circular_buffer_init(
-            buffer_capacity,
-            element_size,
-            &(o->buffer));
-
-    if (status != PV_CIRCULAR_BUFFER_STATUS_SUCCESS) {
-        pv_speaker_delete(o);
-        return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
+    // the mutex only serializes adding and removing streams; the audio thread picks up the new slot atomically
+    ma_mutex_lock(&object->mutex);
+    int32_t slot = 0;
+    while ((slot < PV_SPEAKER_MAX_STREAMS) && (object->streams[slot] != NULL)) {
+        slot++;
+    }
+    if (slot < PV_SPEAKER_MAX_STREAMS) {
+        __atomic_store_n(&object->streams[slot], o, __ATOMIC_SEQ_CST);
     }
+    ma_mutex_unlock(&object->mutex);
 
-    o->sample_rate = sample_rate;
-    o->bits_per_sample = bits_per_sample;
-    o->num_samples = 0;
+    if (slot == PV_SPEAKER_MAX_STREAMS) {
+        o->speaker = NULL;
+        pv_speaker_stream_delete(o);
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
 
-    *object = o;
+    *stream = o;
 
     return PV_SPEAKER_STATUS_SUCCESS;
 }
 
-static void write_wav_header(pv_speaker_t *object, FILE *file) {
-    int32_t sample_rate = object->sample_rate;
-    const char *chunk_id = "RIFF";
-    const char *format = "WAVE";
-    const char *subchunk1_id = "fmt ";
-    uint32_t subchunk1_size = 16;
-    uint16_t audio_format = 1;
-    uint16_t num_channels = 1;
-    uint16_t bits_per_sample = object->bits_per_sample;
-    uint16_t sample_size = bits_per_sample / 8;
-    uint32_t byte_rate = sample_rate * num_channels * sample_size;
-    uint16_t block_align = num_channels * sample_size;
-    const char *subchunk2_id = "data";
-    uint32_t subchunk2_size = object->num_samples * num_channels * sample_size;
-    uint32_t chunk_size = 36 + subchunk2_size;
-
-    fwrite(chunk_id, 4, 1, file);
-    fwrite(&chunk_size, sizeof(chunk_size), 1, file);
-    fwrite(format, 4, 1, file);
-    fwrite(subchunk1_id, 4, 1, file);
-    fwrite(&subchunk1_size, sizeof(subchunk1_size), 1, file);
-    fwrite(&audio_format, sizeof(audio_format), 1, file);
-    fwrite(&num_channels, sizeof(num_channels), 1, file);
-    fwrite(&sample_rate, sizeof(sample_rate), 1, file);
-    fwrite(&byte_rate, sizeof(byte_rate), 1, file);
-    fwrite(&block_align, sizeof(block_align), 1, file);
-    fwrite(&bits_per_sample, sizeof(bits_per_sample), 1, file);
-    fwrite(subchunk2_id, 4, 1, file);
-    fwrite(&subchunk2_size, sizeof(subchunk2_size), 1, file);
-}
-
-PV_API void pv_speaker_delete(pv_speaker_t *object) {
-    if (object) {
-        ma_device_uninit(&(object->device));
-        ma_context_uninit(&(object->context));
-        ma_mutex_uninit(&(object->mutex));
-        pv_circular_buffer_delete(object->buffer);
-        if (object->file != NULL) {
-            rewind(object->file);
-            write_wav_header(object, object->file);
-            fclose(object->file);
-            object->file = NULL;
-        }
-        free(object);
+PV_API void pv_speaker_stream_delete(pv_speaker_stream_t *stream) {
+    if (!stream) {
+        return;
     }
-}
 
-PV_API pv_speaker_status_t pv_speaker_start(pv_speaker_t *object) {
-    if (!object) {
-        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
-    }
+    pv_speaker_t *object = stream->speaker;
+    if (object != NULL) {
+        ma_mutex_lock(&object->mutex);
+        for (int32_t i = 0; i < PV_SPEAKER_MAX_STREAMS; i++) {
+            if (object->streams[i] == stream) {
+                __atomic_store_n(&object->streams[i], NULL, __ATOMIC_SEQ_CST);
+            }
+        }
+        ma_mutex_unlock(&object->mutex);
 
-    ma_result result = ma_device_start(&(object->device));
-    if (result != MA_SUCCESS) {
-        if (result == MA_DEVICE_NOT_INITIALIZED) {
-            return PV_SPEAKER_STATUS_DEVICE_NOT_INITIALIZED;
-        } else {
-            // device already started
-            return PV_SPEAKER_STATUS_INVALID_STATE;
+        // a mix that started before the slot was cleared may still read the stream, so wait for it to end
+        const uint64_t sequence = __atomic_load_n(&object->mix_sequence, __ATOMIC_SEQ_CST);
+        if ((sequence % 2) == 1) {
+            while (__atomic_load_n(&object->mix_sequence, __ATOMIC_ACQUIRE) == sequence) {
+                ma_sleep(1);
+            }
         }
     }
 
-    object->is_started = true;
-
-    return PV_SPEAKER_STATUS_SUCCESS;
+    pv_circular_buffer_delete(stream->buffer);
+    pv_resampler_delete(stream->resampler);
+    free(stream->staging);
+    free(stream);
 }
 
-PV_API pv_speaker_status_t pv_speaker_write(pv_speaker_t *object, int8_t *pcm, int32_t pcm_length, int32_t *written_length) {
-    if (!object) {
+PV_API pv_speaker_status_t pv_speaker_stream_write(
+        pv_speaker_stream_t *stream,
+        const int8_t *pcm,
+        int32_t pcm_length,
+        int32_t *written_length) {
+    if (!stream) {
         return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
     }
     if (!pcm) {
@@ -287,149 +2702,87 @@ PV_API pv_speaker_status_t pv_speaker_write(pv_speaker_t *object, int8_t *pcm, i
     if (!written_length) {
         return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
     }
-    if (!(object->is_started)) {
-        return PV_SPEAKER_STATUS_INVALID_STATE;
-    }
-
-    ma_mutex_lock(&object->mutex);
 
     int32_t available = 0;
-    pv_circular_buffer_status_t status = pv_circular_buffer_get_available(object->buffer, &available);
+    pv_circular_buffer_status_t status = pv_circular_buffer_get_available(stream->buffer, &available);
     if (status != PV_CIRCULAR_BUFFER_STATUS_SUCCESS) {
-        ma_mutex_unlock(&object->mutex);
         return PV_SPEAKER_STATUS_RUNTIME_ERROR;
     }
 
-    int32_t to_write = pcm_length < available ? pcm_length : available;
+    const int32_t to_write = pcm_length < available ? pcm_length : available;
     if (to_write > 0) {
-        status = pv_circular_buffer_write(object->buffer, pcm, to_write);
+        status = pv_circular_buffer_write(stream->buffer, pcm, to_write);
         if (status != PV_CIRCULAR_BUFFER_STATUS_SUCCESS) {
-            ma_mutex_unlock(&object->mutex);
             return PV_SPEAKER_STATUS_RUNTIME_ERROR;
         }
-
-        if (object->file != NULL) {
-            size_t count = to_write * (object->bits_per_sample / 8);
-            fwrite(pcm, sizeof(int8_t), count, object->file);
-            object->num_samples += count;
-        }
     }
 
     *written_length = to_write;
 
-    ma_mutex_unlock(&object->mutex);
-
     return PV_SPEAKER_STATUS_SUCCESS;
 }
 
-PV_API pv_speaker_status_t pv_speaker_flush(pv_speaker_t *object, int8_t *pcm, int32_t pcm_length, int32_t *written_length) {
-    if (!object) {
-        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
-    }
-    if (pcm_length < 0) {
+PV_API pv_speaker_status_t pv_speaker_stream_set_gain(pv_speaker_stream_t *stream, float gain) {
+    if (!stream) {
         return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
     }
-    if (!written_length) {
+    if (!(gain >= 0.f) || isinf(gain)) {
         return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
     }
-    if (!(object->is_started)) {
-        return PV_SPEAKER_STATUS_INVALID_STATE;
-    }
-
-    int32_t written = 0;
-    *written_length = 0;
-
-    is_stop_flush = false;
-
-    if (pcm != NULL) {
-        while (!is_stop_flush && written < pcm_length) {
-            ma_mutex_lock(&object->mutex);
-
-            int32_t available = 0;
-            pv_circular_buffer_status_t status = pv_circular_buffer_get_available(object->buffer, &available);
-            if (status != PV_CIRCULAR_BUFFER_STATUS_SUCCESS) {
-                ma_mutex_unlock(&object->mutex);
-                return PV_SPEAKER_STATUS_RUNTIME_ERROR;
-            }
-
-            int32_t remaining = pcm_length - written;
-            int32_t to_write = remaining < available ? remaining : available;
-            if (to_write > 0) {
-                status = pv_circular_buffer_write(
-                        object->buffer,
-                        &pcm[written * object->bits_per_sample / 8],
-                        to_write);
-                if (status != PV_CIRCULAR_BUFFER_STATUS_SUCCESS) {
-                    ma_mutex_unlock(&object->mutex);
-                    return PV_SPEAKER_STATUS_RUNTIME_ERROR;
-                }
 
-                written += to_write;
-                *written_length += to_write;
+    __atomic_store(&stream->gain, &gain, __ATOMIC_RELAXED);
 
-                if (object->file != NULL) {
-                    size_t count = to_write * (object->bits_per_sample / 8);
-                    fwrite(pcm, sizeof(int8_t), count, object->file);
-                    object->num_samples += count;
-                }
-            }
+    return PV_SPEAKER_STATUS_SUCCESS;
+}
 
-            ma_mutex_unlock(&object->mutex);
-            ma_sleep(FLUSH_SLEEP_MS);
-        }
+PV_API pv_speaker_status_t pv_speaker_set_gain(pv_speaker_t *object, float gain, int32_t ramp_ms) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
     }
-
-    // waits for all frames to be copied to output buffer
-    while (!is_stop_flush && !is_data_requested_while_empty) {
-        ma_mutex_lock(&object->mutex);
-
-        int32_t count = 0;
-        pv_circular_buffer_status_t status = pv_circular_buffer_get_count(object->buffer, &count);
-        if (status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS && count == 0) {
-            is_flushed_and_empty = true;
-        } else if (status != PV_CIRCULAR_BUFFER_STATUS_SUCCESS) {
-            ma_mutex_unlock(&object->mutex);
-            return PV_SPEAKER_STATUS_RUNTIME_ERROR;
-        }
-
-        ma_mutex_unlock(&object->mutex);
-        ma_sleep(FLUSH_SLEEP_MS);
+    if (!(gain >= 0.f) || isinf(gain)) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (ramp_ms < 0) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
     }
 
-    is_flushed_and_empty = false;
-    is_data_requested_while_empty = false;
+    const int32_t ramp_frames = (int32_t) (((int64_t) ramp_ms * object->device_sample_rate) / 1000);
+
+    // the audio thread reads the request after seeing the new generation; two calls racing each other may have it
+    // combine the gain of one with the ramp of the other, which is as good as either
+    __atomic_store(&object->requested_gain, &gain, __ATOMIC_RELAXED);
+    __atomic_store_n(&object->requested_gain_ramp_frames, ramp_frames, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&object->gain_generation, 1, __ATOMIC_RELEASE);
 
     return PV_SPEAKER_STATUS_SUCCESS;
 }
 
-PV_API pv_speaker_status_t pv_speaker_stop(pv_speaker_t *object) {
+PV_API pv_speaker_status_t pv_speaker_get_stats(pv_speaker_t *object, pv_speaker_stats_t *stats) {
     if (!object) {
         return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
     }
+    if (!stats) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
 
-    is_stop_flush = true;
-
-    ma_result result = ma_device_stop(&(object->device));
-    if (result != MA_SUCCESS) {
-        if (result == MA_DEVICE_NOT_INITIALIZED) {
-            return PV_SPEAKER_STATUS_DEVICE_NOT_INITIALIZED;
-        } else {
-            // device already stopped
-            return PV_SPEAKER_STATUS_INVALID_STATE;
-        }
+    stats->num_underruns = __atomic_load_n(&object->num_underruns, __ATOMIC_RELAXED);
+    stats->frames_played = __atomic_load_n(&object->frames_played, __ATOMIC_RELAXED);
+    stats->frames_written = __atomic_load_n(&object->frames_written, __ATOMIC_RELAXED);
+    stats->peak_fill = __atomic_load_n(&object->peak_fill, __ATOMIC_RELAXED);
+    for (int32_t i = 0; i < PV_SPEAKER_STATS_NUM_CALLBACK_DURATION_BUCKETS; i++) {
+        stats->callback_durations[i] = __atomic_load_n(&object->callback_durations[i], __ATOMIC_RELAXED);
     }
 
-    ma_mutex_lock(&object->mutex);
-    pv_circular_buffer_reset(object->buffer);
-    object->is_started = false;
-    ma_mutex_unlock(&object->mutex);
+    int32_t fill = 0;
+    pv_circular_buffer_get_count(object->buffer, &fill);
+    stats->fill = fill;
 
-    if (object->file != NULL) {
-        rewind(object->file);
-        write_wav_header(object, object->file);
-        fclose(object->file);
-        object->file = NULL;
-    }
+    const double device_frames =
+            (double) object->device.playback.internalPeriodSizeInFrames * object->device.playback.internalPeriods;
+    const double device_rate = object->device.playback.internalSampleRate > 0
+            ? (double) object->device.playback.internalSampleRate
+            : (double) object->sample_rate;
+    stats->estimated_latency_ms = (float) ((1000.0 * fill / object->sample_rate) + (1000.0 * device_frames / device_rate));
 
     return PV_SPEAKER_STATUS_SUCCESS;
 }
@@ -458,9 +2811,11 @@ PV_API pv_speaker_status_t pv_speaker_get_available_devices(
         return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
     }
 
-    ma_context context;
-    ma_result result = ma_context_init(NULL, 0, NULL, &context);
+    pv_speaker_shared_context_lock_acquire();
+
+    ma_result result = pv_speaker_shared_context_update_devices(false);
     if (result != MA_SUCCESS) {
+        pv_speaker_shared_context_lock_release();
         if ((result == MA_NO_BACKEND) || (result == MA_FAILED_TO_INIT_BACKEND)) {
             return PV_SPEAKER_STATUS_BACKEND_ERROR;
         } else if (result == MA_OUT_OF_MEMORY) {
@@ -470,49 +2825,51 @@ PV_API pv_speaker_status_t pv_speaker_get_available_devices(
         }
     }
 
-    ma_device_info *playback_info;
-    ma_uint32 playback_count;
-    result = ma_context_get_devices(
-            &context,
-            &playback_info,
-            &playback_count,
-            NULL,
-            NULL);
-    if (result != MA_SUCCESS) {
-        ma_context_uninit(&context);
-        if (result == MA_OUT_OF_MEMORY) {
-            return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
-        } else {
-            return PV_SPEAKER_STATUS_INVALID_STATE;
-        }
-    }
-
+    const int32_t playback_count = pv_speaker_shared_context.num_devices;
     char **d = calloc(playback_count, sizeof(char *));
     if (!d) {
-        ma_context_uninit(&context);
+        pv_speaker_shared_context_lock_release();
         return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
     }
 
-    for (int32_t i = 0; i < (int32_t) playback_count; i++) {
-        d[i] = strdup(playback_info[i].name);
+    for (int32_t i = 0; i < playback_count; i++) {
+        d[i] = strdup(pv_speaker_shared_context.devices[i].name);
         if (!d[i]) {
             for (int32_t j = i - 1; j >= 0; j--) {
                 free(d[j]);
             }
             free(d);
-            ma_context_uninit(&context);
+            pv_speaker_shared_context_lock_release();
             return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
         }
     }
 
-    ma_context_uninit(&context);
+    pv_speaker_shared_context_lock_release();
 
-    *device_list_length = (int32_t) playback_count;
+    *device_list_length = playback_count;
     *device_list = d;
 
     return PV_SPEAKER_STATUS_SUCCESS;
 }
 
+PV_API pv_speaker_status_t pv_speaker_refresh_available_devices(void) {
+    pv_speaker_shared_context_lock_acquire();
+    ma_result result = pv_speaker_shared_context_update_devices(true);
+    pv_speaker_shared_context_lock_release();
+
+    if (result != MA_SUCCESS) {
+        if ((result == MA_NO_BACKEND) || (result == MA_FAILED_TO_INIT_BACKEND)) {
+            return PV_SPEAKER_STATUS_BACKEND_ERROR;
+        } else if (result == MA_OUT_OF_MEMORY) {
+            return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
+        } else {
+            return PV_SPEAKER_STATUS_INVALID_STATE;
+        }
+    }
+
+    return PV_SPEAKER_STATUS_SUCCESS;
+}
+
 PV_API void pv_speaker_free_available_devices(
         int32_t device_list_length,
         char **device_list) {
@@ -534,7 +2891,8 @@ PV_API const char *pv_speaker_status_to_string(pv_speaker_status_t status) {
             "DEVICE_INITIALIZED",
             "DEVICE_NOT_INITIALIZED",
             "IO_ERROR",
-            "RUNTIME_ERROR"};
+            "RUNTIME_ERROR",
+            "TIMEOUT"};
 
     int32_t size = sizeof(STRINGS) / sizeof(STRINGS[0]);
     if (status < PV_SPEAKER_STATUS_SUCCESS || status >= (PV_SPEAKER_STATUS_SUCCESS + size)) {
@@ -555,15 +2913,91 @@ PV_API pv_speaker_status_t pv_speaker_write_to_file(pv_speaker_t *object, const
     if (!output_wav_path) {
         return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
     }
+    if (object->render_callback != NULL) {
+        return PV_SPEAKER_STATUS_INVALID_STATE;
+    }
+
+    ma_mutex_lock(&object->mutex);
+
+    pv_speaker_close_file(object);
+
+    if (object->file_buffer == NULL) {
+        // one second of audio, and at least four batches, in whole frames
+        const int32_t batch_frames = pv_speaker_file_batch_frames(object);
+        const int32_t capacity = object->sample_rate > (4 * batch_frames) ? object->sample_rate : (4 * batch_frames);
+        pv_circular_buffer_status_t status = pv_circular_buffer_init(
+                capacity,
+                object->frame_size,
+                &(object->file_buffer));
+        object->file_batch = malloc((size_t) batch_frames * (size_t) object->frame_size);
+        if ((status != PV_CIRCULAR_BUFFER_STATUS_SUCCESS) || (object->file_batch == NULL)) {
+            pv_circular_buffer_delete(object->file_buffer);
+            object->file_buffer = NULL;
+            free(object->file_batch);
+            object->file_batch = NULL;
+            ma_mutex_unlock(&object->mutex);
+            return PV_SPEAKER_STATUS_OUT_OF_MEMORY;
+        }
+    }
 
     FILE *file = fopen(output_wav_path, "wb");
     if (file == NULL) {
+        ma_mutex_unlock(&object->mutex);
         return PV_SPEAKER_STATUS_RUNTIME_ERROR;
     }
 
+#if defined(__PV_SPEAKER_PLATFORM_LINUX__) || defined(__PV_SPEAKER_PLATFORM_RASPBERRYPI__)
+
+    posix_fadvise(fileno(file), 0, 0, POSIX_FADV_SEQUENTIAL);
+
+#endif
+
+    object->file_data_bytes = 0;
     write_wav_header(object, file);
 
+    pv_circular_buffer_reset(object->file_buffer);
+    __atomic_store_n(&object->file_dropped_bytes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&object->is_file_stopping, false, __ATOMIC_RELAXED);
+
     object->file = file;
+    if (!pv_speaker_file_writer_start(object)) {
+        fclose(file);
+        object->file = NULL;
+        ma_mutex_unlock(&object->mutex);
+        return PV_SPEAKER_STATUS_RUNTIME_ERROR;
+    }
+
+    ma_mutex_unlock(&object->mutex);
+
+    return PV_SPEAKER_STATUS_SUCCESS;
+}
+
+PV_API pv_speaker_status_t pv_speaker_set_file_overflow_policy(
+        pv_speaker_t *object,
+        pv_speaker_file_overflow_policy_t policy) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if ((policy != PV_SPEAKER_FILE_OVERFLOW_POLICY_BLOCK) && (policy != PV_SPEAKER_FILE_OVERFLOW_POLICY_DROP)) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+
+    ma_mutex_lock(&object->mutex);
+    object->file_overflow_policy = policy;
+    ma_mutex_unlock(&object->mutex);
+
+    return PV_SPEAKER_STATUS_SUCCESS;
+}
+
+PV_API pv_speaker_status_t pv_speaker_get_file_dropped_bytes(pv_speaker_t *object, int64_t *dropped_bytes) {
+    if (!object) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+    if (!dropped_bytes) {
+        return PV_SPEAKER_STATUS_INVALID_ARGUMENT;
+    }
+
+    *dropped_bytes = __atomic_load_n(&object->file_dropped_bytes, __ATOMIC_RELAXED);
 
     return PV_SPEAKER_STATUS_SUCCESS;
 }
\ No newline at end of file
@@ -9,13 +9,21 @@
     specific language governing permissions and limitations under the License.
 */
 
+#include <pthread.h>
+#include <sched.h>
+
 #include "pv_circular_buffer.h"
 #include "test_helper.h"
 
+typedef pv_circular_buffer_status_t (*pv_circular_buffer_init_func_t)(int32_t, int32_t, pv_circular_buffer_t **);
+
+static pv_circular_buffer_init_func_t init_func = pv_circular_buffer_init;
+static bool is_mirrored = false;
+
 static void test_pv_circular_buffer_once(void) {
     int32_t element_count = 128;
     pv_circular_buffer_t *cb;
-    pv_circular_buffer_status_t status = pv_circular_buffer_init(element_count, sizeof(int16_t), &cb);
+    pv_circular_buffer_status_t status = init_func(element_count, sizeof(int16_t), &cb);
     check_condition(
             status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS,
             __FUNCTION__,
@@ -80,7 +88,7 @@ static void test_pv_circular_buffer_once(void) {
 
 static void test_pv_circular_buffer_read_incomplete(void) {
     pv_circular_buffer_t *cb;
-    pv_circular_buffer_status_t status = pv_circular_buffer_init(128, sizeof(int16_t), &cb);
+    pv_circular_buffer_status_t status = init_func(128, sizeof(int16_t), &cb);
     check_condition(
             status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS,
             __FUNCTION__,
@@ -99,13 +107,33 @@ static void test_pv_circular_buffer_read_incomplete(void) {
             __LINE__,
             "Expected buffer size to be 0.");
 
+    free(out_buffer);
+
+    // a destination larger than the whole buffer is fine, e.g. a device period longer than a small buffer
+    out_size = 256;
+    out_buffer = malloc(out_size * sizeof(int16_t));
+    check_condition(out_buffer != NULL, __FUNCTION__, __LINE__, "Failed to allocate memory.");
+
+    int16_t in_buffer[128] = {0};
+    status = pv_circular_buffer_write(cb, in_buffer, 128);
+    check_condition(status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS, __FUNCTION__, __LINE__, "Failed to write buffer.");
+
+    status = pv_circular_buffer_read(cb, out_buffer, out_size, &read_length);
+    check_condition(
+            (status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS && read_length == 128),
+            __FUNCTION__,
+            __LINE__,
+            "Expected to read %d elements, got %d.",
+            128,
+            read_length);
+
     free(out_buffer);
     pv_circular_buffer_delete(cb);
 }
 
 static void test_pv_circular_buffer_write_overflow(void) {
     pv_circular_buffer_t *cb;
-    pv_circular_buffer_status_t status = pv_circular_buffer_init(
+    pv_circular_buffer_status_t status = init_func(
             10,
             sizeof(int16_t),
             &cb);
@@ -137,7 +165,7 @@ static void test_pv_circular_buffer_write_overflow(void) {
 
 static void test_pv_circular_buffer_read_write(void) {
     pv_circular_buffer_t *cb;
-    pv_circular_buffer_status_t status = pv_circular_buffer_init(2048, sizeof(int16_t), &cb);
+    pv_circular_buffer_status_t status = init_func(2048, sizeof(int16_t), &cb);
     check_condition(
             status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS,
             __FUNCTION__,
@@ -176,7 +204,7 @@ static void test_pv_circular_buffer_read_write(void) {
 
 static void test_pv_circular_buffer_read_write_one_by_one(void) {
     pv_circular_buffer_t *cb;
-    pv_circular_buffer_status_t status = pv_circular_buffer_init(12, sizeof(int16_t), &cb);
+    pv_circular_buffer_status_t status = init_func(12, sizeof(int16_t), &cb);
     check_condition(
             status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS,
             __FUNCTION__,
@@ -216,14 +244,466 @@ static void test_pv_circular_buffer_read_write_one_by_one(void) {
     pv_circular_buffer_delete(cb);
 }
 
-int main() {
-    srand(time(NULL));
+static void test_pv_circular_buffer_reserve_commit(void) {
+    pv_circular_buffer_t *cb;
+    pv_circular_buffer_status_t status = init_func(10, sizeof(int16_t), &cb);
+    check_condition(
+            status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Failed to initialize buffer.");
+
+    int16_t in_buffer[] = {1, 2, 3, 4, 5, 6, 7};
+    int16_t out_buffer[10];
+    int32_t read_length = 0;
+    pv_circular_buffer_write(cb, in_buffer, 7);
+    pv_circular_buffer_read(cb, out_buffer, 7, &read_length);
+
+    void *region1 = NULL;
+    int32_t region1_length = 0;
+    void *region2 = NULL;
+    int32_t region2_length = 0;
+    status = pv_circular_buffer_write_reserve(cb, 8, &region1, &region1_length, &region2, &region2_length);
+    check_condition(
+            (status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS) && ((region1_length + region2_length) == 8),
+            __FUNCTION__,
+            __LINE__,
+            "Expected a reservation of 8 elements, got %d + %d.",
+            region1_length,
+            region2_length);
+    if (is_mirrored) {
+        check_condition(region2_length == 0, __FUNCTION__, __LINE__, "Expected a single region when mirrored.");
+    } else {
+        check_condition(
+                (region1_length == 3) && (region2 != NULL),
+                __FUNCTION__,
+                __LINE__,
+                "Expected a wrapped reservation of 3 + 5 elements, got %d + %d.",
+                region1_length,
+                region2_length);
+    }
+
+    for (int32_t i = 0; i < region1_length; i++) {
+        ((int16_t *) region1)[i] = (int16_t) (100 + i);
+    }
+    for (int32_t i = 0; i < region2_length; i++) {
+        ((int16_t *) region2)[i] = (int16_t) (100 + region1_length + i);
+    }
+
+    int32_t count = 0;
+    pv_circular_buffer_get_count(cb, &count);
+    check_condition(count == 0, __FUNCTION__, __LINE__, "Reserved elements must not be readable before commit.");
+
+    status = pv_circular_buffer_write_commit(cb, 9);
+    check_condition(
+            status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Committing within the capacity should succeed.");
+    status = pv_circular_buffer_write_commit(cb, 2);
+    check_condition(
+            status == PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Committing past the capacity should fail.");
+
+    status = pv_circular_buffer_read(cb, out_buffer, 8, &read_length);
+    check_condition(
+            (status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS) && (read_length == 8),
+            __FUNCTION__,
+            __LINE__,
+            "Failed to read committed elements.");
+    for (int32_t i = 0; i < read_length; i++) {
+        check_condition(
+                out_buffer[i] == (100 + i),
+                __FUNCTION__,
+                __LINE__,
+                "Unexpected value %d at index %d.",
+                out_buffer[i],
+                i);
+    }
+
+    pv_circular_buffer_delete(cb);
+}
+
+typedef struct {
+    pv_circular_buffer_t *cb;
+    int32_t num_elements;
+} test_pv_circular_buffer_thread_args_t;
+
+static void *test_pv_circular_buffer_producer(void *arg) {
+    test_pv_circular_buffer_thread_args_t *args = (test_pv_circular_buffer_thread_args_t *) arg;
+
+    int32_t chunk[37];
+    int32_t next = 0;
+    while (next < args->num_elements) {
+        int32_t available = 0;
+        pv_circular_buffer_get_available(args->cb, &available);
+
+        int32_t to_write = (int32_t) (sizeof(chunk) / sizeof(chunk[0]));
+        to_write = (to_write < available) ? to_write : available;
+        to_write = (to_write < (args->num_elements - next)) ? to_write : (args->num_elements - next);
+        if (to_write == 0) {
+            sched_yield();
+            continue;
+        }
+
+        for (int32_t i = 0; i < to_write; i++) {
+            chunk[i] = next + i;
+        }
+        pv_circular_buffer_status_t status = pv_circular_buffer_write(args->cb, chunk, to_write);
+        check_condition(status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS, __FUNCTION__, __LINE__, "Failed to write buffer.");
+        next += to_write;
+    }
+
+    return NULL;
+}
+
+static void test_pv_circular_buffer_concurrent_read_write(void) {
+    pv_circular_buffer_t *cb;
+    pv_circular_buffer_status_t status = init_func(101, sizeof(int32_t), &cb);
+    check_condition(
+            status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Failed to initialize buffer.");
+
+    test_pv_circular_buffer_thread_args_t args = {cb, 100000};
+    pthread_t producer;
+    check_condition(
+            pthread_create(&producer, NULL, test_pv_circular_buffer_producer, &args) == 0,
+            __FUNCTION__,
+            __LINE__,
+            "Failed to create producer thread.");
+
+    int32_t out_buffer[53];
+    int32_t expected = 0;
+    while (expected < args.num_elements) {
+        int32_t read_length = 0;
+        status = pv_circular_buffer_read(
+                cb,
+                out_buffer,
+                (int32_t) (sizeof(out_buffer) / sizeof(out_buffer[0])),
+                &read_length);
+        check_condition(status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS, __FUNCTION__, __LINE__, "Failed to read buffer.");
+        if (read_length == 0) {
+            sched_yield();
+        }
+
+        for (int32_t i = 0; i < read_length; i++) {
+            check_condition(
+                    out_buffer[i] == expected,
+                    __FUNCTION__,
+                    __LINE__,
+                    "Read out of order value %d - expected %d",
+                    out_buffer[i],
+                    expected);
+            expected++;
+        }
+    }
+
+    pthread_join(producer, NULL);
+
+    int32_t count = 0;
+    status = pv_circular_buffer_get_count(cb, &count);
+    check_condition(
+            (status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS && count == 0),
+            __FUNCTION__,
+            __LINE__,
+            "Expected buffer to be empty.");
+
+    pv_circular_buffer_delete(cb);
+}
+
+static void test_pv_circular_buffer_skip(void) {
+    pv_circular_buffer_t *cb;
+    pv_circular_buffer_status_t status = init_func(1024, sizeof(int16_t), &cb);
+    check_condition(
+            status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Failed to initialize buffer.");
+
+    int16_t in_buffer[1000];
+    for (int32_t i = 0; i < 1000; i++) {
+        in_buffer[i] = (int16_t) i;
+    }
+
+    int32_t skipped_length = 0;
+    status = pv_circular_buffer_skip(cb, -1, &skipped_length);
+    check_condition(
+            status == PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Skip with a negative length returned %s - expected %s.",
+            pv_circular_buffer_status_to_string(status),
+            pv_circular_buffer_status_to_string(PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT));
+
+    // moves the indices close to the end so that the skip below wraps around
+    int16_t out_buffer[1000];
+    int32_t read_length = 0;
+    pv_circular_buffer_write(cb, in_buffer, 800);
+    pv_circular_buffer_read(cb, out_buffer, 800, &read_length);
+
+    pv_circular_buffer_write(cb, in_buffer, 1000);
+    status = pv_circular_buffer_skip(cb, 600, &skipped_length);
+    check_condition(
+            (status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS) && (skipped_length == 600),
+            __FUNCTION__,
+            __LINE__,
+            "Skipped %d elements - expected %d.",
+            skipped_length,
+            600);
+
+    pv_circular_buffer_read(cb, out_buffer, 1, &read_length);
+    check_condition(
+            (read_length == 1) && (out_buffer[0] == 600),
+            __FUNCTION__,
+            __LINE__,
+            "Read %d after skipping - expected %d.",
+            out_buffer[0],
+            600);
 
+    status = pv_circular_buffer_skip(cb, INT32_MAX, &skipped_length);
+    int32_t count = -1;
+    pv_circular_buffer_get_count(cb, &count);
+    check_condition(
+            (status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS) && (skipped_length == 399) && (count == 0),
+            __FUNCTION__,
+            __LINE__,
+            "Skipped %d elements and left %d - expected %d and %d.",
+            skipped_length,
+            count,
+            399,
+            0);
+
+    pv_circular_buffer_delete(cb);
+}
+
+static void test_pv_circular_buffer_skip_to(void) {
+    pv_circular_buffer_t *cb;
+    pv_circular_buffer_status_t status = init_func(1024, sizeof(int16_t), &cb);
+    check_condition(
+            status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Failed to initialize buffer.");
+
+    int16_t in_buffer[1000];
+    for (int32_t i = 0; i < 1000; i++) {
+        in_buffer[i] = (int16_t) i;
+    }
+
+    int32_t skipped_length = 0;
+    status = pv_circular_buffer_skip_to(cb, -1, &skipped_length);
+    check_condition(
+            status == PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Skip to a negative position returned %s - expected %s.",
+            pv_circular_buffer_status_to_string(status),
+            pv_circular_buffer_status_to_string(PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT));
+
+    // elements written after the position stay, also when the skip wraps around
+    int16_t out_buffer[1000];
+    int32_t read_length = 0;
+    pv_circular_buffer_write(cb, in_buffer, 800);
+    pv_circular_buffer_read(cb, out_buffer, 800, &read_length);
+
+    int32_t position = -1;
+    pv_circular_buffer_write(cb, in_buffer, 600);
+    pv_circular_buffer_get_write_position(cb, &position);
+    pv_circular_buffer_write(cb, in_buffer + 600, 400);
+    status = pv_circular_buffer_skip_to(cb, position, &skipped_length);
+    pv_circular_buffer_read(cb, out_buffer, 1, &read_length);
+    check_condition(
+            (status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS) &&
+                    (skipped_length == 600) &&
+                    (read_length == 1) &&
+                    (out_buffer[0] == 600),
+            __FUNCTION__,
+            __LINE__,
+            "Skipped %d elements and read %d - expected %d and %d.",
+            skipped_length,
+            out_buffer[0],
+            600,
+            600);
+
+    // nothing is dropped once the consumer has read past the position
+    pv_circular_buffer_get_write_position(cb, &position);
+    pv_circular_buffer_write(cb, in_buffer, 100);
+    pv_circular_buffer_read(cb, out_buffer, 450, &read_length);
+    status = pv_circular_buffer_skip_to(cb, position, &skipped_length);
+    int32_t count = -1;
+    pv_circular_buffer_get_count(cb, &count);
+    check_condition(
+            (status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS) && (skipped_length == 0) && (count == 49),
+            __FUNCTION__,
+            __LINE__,
+            "Skipped %d elements and left %d - expected %d and %d.",
+            skipped_length,
+            count,
+            0,
+            49);
+
+    pv_circular_buffer_delete(cb);
+}
+
+static void test_pv_circular_buffer_external(void) {
+    int16_t ring[100];
+    int32_t indices[2] = {0, 7};
+
+    pv_circular_buffer_t *cb;
+    pv_circular_buffer_status_t status = pv_circular_buffer_init_external(
+            100,
+            sizeof(int16_t),
+            ring,
+            &indices[0],
+            &indices[1],
+            &cb);
+    check_condition(
+            (status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS) && (indices[0] == 0) && (indices[1] == 0),
+            __FUNCTION__,
+            __LINE__,
+            "Failed to initialize external buffer at the write index of the producer.");
+
+    status = pv_circular_buffer_init_external(100, sizeof(int16_t), ring, NULL, &indices[1], &cb);
+    check_condition(
+            status == PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Init external without a write index returned %s - expected %s.",
+            pv_circular_buffer_status_to_string(status),
+            pv_circular_buffer_status_to_string(PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT));
+
+    // a foreign producer fills the ring in place and publishes by advancing the shared write index, wrapping around
+    int16_t out_buffer[100];
+    int32_t read_length = 0;
+    for (int32_t i = 0; i < 60; i++) {
+        ring[i] = (int16_t) i;
+    }
+    __atomic_store_n(&indices[0], 60, __ATOMIC_RELEASE);
+    pv_circular_buffer_read(cb, out_buffer, 60, &read_length);
+
+    for (int32_t i = 0; i < 80; i++) {
+        ring[(60 + i) % 100] = (int16_t) (1000 + i);
+    }
+    __atomic_store_n(&indices[0], 140, __ATOMIC_RELEASE);
+    status = pv_circular_buffer_read(cb, out_buffer, 100, &read_length);
+    check_condition(
+            (status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS) && (read_length == 80) && (indices[1] == 140),
+            __FUNCTION__,
+            __LINE__,
+            "Read %d elements written by the foreign producer - expected %d.",
+            read_length,
+            80);
+    for (int32_t i = 0; i < 80; i++) {
+        check_condition(
+                out_buffer[i] == (1000 + i),
+                __FUNCTION__,
+                __LINE__,
+                "Element %d is %d - expected %d.",
+                i,
+                out_buffer[i],
+                1000 + i);
+    }
+
+    // an index that would make the consumer read out of bounds reads as an empty buffer
+    const int32_t invalid_indices[] = {-1, 200, 90};
+    for (int32_t i = 0; i < 3; i++) {
+        __atomic_store_n(&indices[0], invalid_indices[i], __ATOMIC_RELEASE);
+        int32_t count = -1;
+        pv_circular_buffer_get_count(cb, &count);
+        pv_circular_buffer_read(cb, out_buffer, 100, &read_length);
+        check_condition(
+                (count == 0) && (read_length == 0),
+                __FUNCTION__,
+                __LINE__,
+                "Write index %d gave %d elements - expected none.",
+                invalid_indices[i],
+                count);
+
+        void *region1 = NULL;
+        int32_t region1_length = -1;
+        void *region2 = NULL;
+        int32_t region2_length = -1;
+        status = pv_circular_buffer_write_reserve(cb, 10, &region1, &region1_length, &region2, &region2_length);
+        check_condition(
+                (status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS) && (region1_length == 0) && (region2_length == 0),
+                __FUNCTION__,
+                __LINE__,
+                "Write index %d reserved %d elements - expected none.",
+                invalid_indices[i],
+                region1_length + region2_length);
+        status = pv_circular_buffer_write_commit(cb, 0);
+        check_condition(
+                status == PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT,
+                __FUNCTION__,
+                __LINE__,
+                "Commit at write index %d returned %s - expected %s.",
+                invalid_indices[i],
+                pv_circular_buffer_status_to_string(status),
+                pv_circular_buffer_status_to_string(PV_CIRCULAR_BUFFER_STATUS_INVALID_ARGUMENT));
+    }
+
+    // the consumer never reads back the read index it publishes
+    __atomic_store_n(&indices[0], 150, __ATOMIC_RELEASE);
+    __atomic_store_n(&indices[1], 190, __ATOMIC_RELEASE);
+    status = pv_circular_buffer_read(cb, out_buffer, 100, &read_length);
+    check_condition(
+            (status == PV_CIRCULAR_BUFFER_STATUS_SUCCESS) && (read_length == 10) && (indices[1] == 150),
+            __FUNCTION__,
+            __LINE__,
+            "Read %d elements after the published read index changed - expected %d.",
+            read_length,
+            10);
+
+    // reset only moves the read index up to the write index of the producer
+    __atomic_store_n(&indices[0], 170, __ATOMIC_RELEASE);
+    pv_circular_buffer_reset(cb);
+    int32_t count = -1;
+    pv_circular_buffer_get_count(cb, &count);
+    check_condition(
+            (count == 0) && (indices[0] == 170) && (indices[1] == 170),
+            __FUNCTION__,
+            __LINE__,
+            "Reset left %d elements with indices %d and %d - expected none at %d.",
+            count,
+            indices[0],
+            indices[1],
+            170);
+
+    pv_circular_buffer_delete(cb);
+}
+
+static void test_pv_circular_buffer_all(void) {
     test_pv_circular_buffer_once();
     test_pv_circular_buffer_read_incomplete();
     test_pv_circular_buffer_write_overflow();
     test_pv_circular_buffer_read_write();
     test_pv_circular_buffer_read_write_one_by_one();
+    test_pv_circular_buffer_reserve_commit();
+    test_pv_circular_buffer_skip();
+    test_pv_circular_buffer_skip_to();
+    test_pv_circular_buffer_concurrent_read_write();
+}
+
+int main() {
+    srand(time(NULL));
+
+    test_pv_circular_buffer_all();
+
+    init_func = pv_circular_buffer_init_mirrored;
+
+#if defined(__PV_SPEAKER_PLATFORM_LINUX__) || defined(__PV_SPEAKER_PLATFORM_RASPBERRYPI__)
+
+    is_mirrored = true;
+
+#endif
+
+    test_pv_circular_buffer_all();
+
+    test_pv_circular_buffer_external();
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,205 @@
+/*
+    Copyright 2024 Picovoice Inc.
+
+    You may not use this file except in compliance with the license. A copy of the license is located in the "LICENSE"
+    file accompanying this source.
+
+    Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on
+    an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the
+    specific language governing permissions and limitations under the License.
+*/
+
+#include <math.h>
+#include <string.h>
+
+#include "pv_gain.h"
+#include "test_helper.h"
+
+static const int32_t LENGTHS[] = {0, 1, 7, 8, 15, 16, 17, 33, 1000};
+
+static double expected_gain(int32_t i, int32_t num_channels, float gain, float gain_step) {
+    return (double) gain + ((double) i * gain_step / num_channels);
+}
+
+static double clamp(double x, double min, double max) {
+    return (x < min) ? min : ((x > max) ? max : x);
+}
+
+static void test_pv_gain_f32(void) {
+    float pcm[1000];
+
+    for (int32_t channels = 1; channels <= 2; channels++) {
+        for (size_t k = 0; k < (sizeof(LENGTHS) / sizeof(LENGTHS[0])); k++) {
+            const int32_t num_frames = LENGTHS[k] / channels;
+            const int32_t length = num_frames * channels;
+            for (int32_t i = 0; i < length; i++) {
+                pcm[i] = (float) ((rand() % 2001) - 1000) / 1000.f;
+            }
+            float input[1000];
+            memcpy(input, pcm, sizeof(pcm));
+
+            const float gain = 0.1f;
+            const float gain_step = 0.9f / 500;
+            pv_gain_apply(pcm, 32, true, channels, num_frames, gain, gain_step);
+
+            for (int32_t i = 0; i < length; i++) {
+                const double expected = input[i] * expected_gain(i, channels, gain, gain_step);
+                check_condition(
+                        fabs(pcm[i] - expected) < 1e-5,
+                        __FUNCTION__,
+                        __LINE__,
+                        "Sample %d of %d (%d channels) is %f - expected %f.",
+                        i,
+                        length,
+                        channels,
+                        pcm[i],
+                        expected);
+            }
+        }
+    }
+}
+
+static void test_pv_gain_s16(void) {
+    int16_t pcm[1000];
+
+    for (int32_t channels = 1; channels <= 2; channels++) {
+        for (size_t k = 0; k < (sizeof(LENGTHS) / sizeof(LENGTHS[0])); k++) {
+            const int32_t num_frames = LENGTHS[k] / channels;
+            const int32_t length = num_frames * channels;
+            for (int32_t i = 0; i < length; i++) {
+                pcm[i] = (int16_t) ((rand() % 65536) - 32768);
+            }
+            int16_t input[1000];
+            memcpy(input, pcm, sizeof(pcm));
+
+            // ramps from silence to twice the level, so the end of the buffer saturates
+            const float gain = 0.f;
+            const float gain_step = 2.f / 500;
+            pv_gain_apply(pcm, 16, false, channels, num_frames, gain, gain_step);
+
+            for (int32_t i = 0; i < length; i++) {
+                const double expected = clamp(
+                        input[i] * expected_gain(i, channels, gain, gain_step),
+                        -32768.0,
+                        32767.0);
+                check_condition(
+                        fabs(pcm[i] - expected) <= 1.0,
+                        __FUNCTION__,
+                        __LINE__,
+                        "Sample %d of %d (%d channels) is %d - expected %.1f.",
+                        i,
+                        length,
+                        channels,
+                        pcm[i],
+                        expected);
+            }
+        }
+    }
+}
+
+static void test_pv_gain_s16_large_gain(void) {
+    int16_t pcm[1000];
+
+    // products beyond the 32-bit range must saturate the same way in the vector kernels as in the scalar tail
+    for (size_t k = 0; k < (sizeof(LENGTHS) / sizeof(LENGTHS[0])); k++) {
+        const int32_t length = LENGTHS[k];
+        for (int32_t i = 0; i < length; i++) {
+            pcm[i] = (int16_t) ((i % 3) - 1) * (int16_t) (1 + (rand() % 32767));
+        }
+        int16_t input[1000];
+        memcpy(input, pcm, sizeof(pcm));
+
+        pv_gain_apply(pcm, 16, false, 1, length, 100000.f, 0.f);
+
+        for (int32_t i = 0; i < length; i++) {
+            const int16_t expected = (input[i] > 0) ? 32767 : ((input[i] < 0) ? -32768 : 0);
+            check_condition(
+                    pcm[i] == expected,
+                    __FUNCTION__,
+                    __LINE__,
+                    "Sample %d of %d is %d - expected %d.",
+                    i,
+                    length,
+                    pcm[i],
+                    expected);
+        }
+    }
+}
+
+static void test_pv_gain_other_formats(void) {
+    uint8_t pcm_u8[] = {0, 64, 128, 192, 255};
+    pv_gain_apply(pcm_u8, 8, false, 1, 5, 0.5f, 0.f);
+    const uint8_t expected_u8[] = {64, 96, 128, 160, 192};
+    for (int32_t i = 0; i < 5; i++) {
+        check_condition(
+                abs(pcm_u8[i] - expected_u8[i]) <= 1,
+                __FUNCTION__,
+                __LINE__,
+                "8-bit sample %d is %d - expected %d.",
+                i,
+                pcm_u8[i],
+                expected_u8[i]);
+    }
+
+    // -4194304, 4194303 and 1 as little-endian 24-bit samples
+    uint8_t pcm_s24[] = {0x00, 0x00, 0xC0, 0xFF, 0xFF, 0x3F, 0x01, 0x00, 0x00};
+    pv_gain_apply(pcm_s24, 24, false, 1, 3, 4.f, 0.f);
+    const uint8_t expected_s24[] = {0x00, 0x00, 0x80, 0xFF, 0xFF, 0x7F, 0x04, 0x00, 0x00};
+    check_condition(
+            memcmp(pcm_s24, expected_s24, sizeof(pcm_s24)) == 0,
+            __FUNCTION__,
+            __LINE__,
+            "24-bit samples did not saturate as expected.");
+
+    int32_t pcm_s32[] = {INT32_MIN, -1000, 1000, INT32_MAX};
+    pv_gain_apply(pcm_s32, 32, false, 2, 2, 2.f, 0.f);
+    const int32_t expected_s32[] = {INT32_MIN, -2000, 2000, INT32_MAX};
+    for (int32_t i = 0; i < 4; i++) {
+        check_condition(
+                pcm_s32[i] == expected_s32[i],
+                __FUNCTION__,
+                __LINE__,
+                "32-bit sample %d is %d - expected %d.",
+                i,
+                pcm_s32[i],
+                expected_s32[i]);
+    }
+}
+
+static void test_pv_gain_benchmark(void) {
+    // ten seconds of 48 kHz stereo in 10 ms device periods
+    const int32_t period = 480;
+    const int32_t num_periods = 1000;
+    float pcm_f32[480 * 2];
+    int16_t pcm_s16[480 * 2];
+    for (int32_t i = 0; i < (period * 2); i++) {
+        pcm_f32[i] = 0.25f;
+        pcm_s16[i] = 8192;
+    }
+
+    clock_t start = clock();
+    for (int32_t j = 0; j < num_periods; j++) {
+        pv_gain_apply(pcm_f32, 32, true, 2, period, 1.f, -1e-9f);
+    }
+    double elapsed = (double) (clock() - start) / CLOCKS_PER_SEC;
+    fprintf(stdout, "f32 ramp: %.3f us per 10 ms stereo period\n", (elapsed * 1e6) / num_periods);
+
+    start = clock();
+    for (int32_t j = 0; j < num_periods; j++) {
+        pv_gain_apply(pcm_s16, 16, false, 2, period, 1.f, -1e-9f);
+    }
+    elapsed = (double) (clock() - start) / CLOCKS_PER_SEC;
+    fprintf(stdout, "s16 ramp: %.3f us per 10 ms stereo period\n", (elapsed * 1e6) / num_periods);
+}
+
+int main() {
+    srand(time(NULL));
+
+    test_pv_gain_f32();
+    test_pv_gain_s16();
+    test_pv_gain_s16_large_gain();
+    test_pv_gain_other_formats();
+    test_pv_gain_benchmark();
+
+    return 0;
+}
@@ -0,0 +1,316 @@
+/*
+    Copyright 2024 Picovoice Inc.
+
+    You may not use this file except in compliance with the license. A copy of the license is located in the "LICENSE"
+    file accompanying this source.
+
+    Unless required by applicable law or agreed to in writing, software distributed under the License is distributed on
+    an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the License for the
+    specific language governing permissions and limitations under the License.
+*/
+
+#include <math.h>
+#include <string.h>
+
+#include "pv_resampler.h"
+#include "test_helper.h"
+
+#define PI (3.14159265358979323846)
+
+typedef struct {
+    int32_t sample_rate;
+    int32_t num_channels;
+    double frequency;
+    int64_t index;
+    int64_t max_length;
+} sine_source_t;
+
+static int32_t sine_source_read(void *context, float *input, int32_t max_length) {
+    sine_source_t *source = context;
+
+    int32_t length = max_length;
+    if ((source->max_length - source->index) < length) {
+        length = (int32_t) (source->max_length - source->index);
+    }
+
+    for (int32_t i = 0; i < length; i++) {
+        const double t = (double) source->index / source->sample_rate;
+        const float value = (float) (0.5 * sin(2.0 * PI * source->frequency * t));
+        for (int32_t c = 0; c < source->num_channels; c++) {
+            input[(i * source->num_channels) + c] = (c % 2) == 0 ? value : -value;
+        }
+        source->index++;
+    }
+
+    return length;
+}
+
+static int32_t resample_sine(
+        int32_t input_sample_rate,
+        int32_t output_sample_rate,
+        int32_t num_channels,
+        pv_resampler_quality_t quality,
+        double frequency,
+        int32_t block_length,
+        int32_t output_length,
+        float *output) {
+    pv_resampler_t *resampler = NULL;
+    pv_resampler_status_t status = pv_resampler_init(
+            input_sample_rate,
+            output_sample_rate,
+            num_channels,
+            quality,
+            &resampler);
+    check_condition(
+            status == PV_RESAMPLER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "pv_resampler_init failed with %s.",
+            pv_resampler_status_to_string(status));
+
+    sine_source_t source = {input_sample_rate, num_channels, frequency, 0, INT64_MAX};
+    int32_t produced = 0;
+    while (produced < output_length) {
+        int32_t length = block_length;
+        if ((output_length - produced) < length) {
+            length = output_length - produced;
+        }
+        produced += pv_resampler_read(
+                resampler,
+                &output[produced * num_channels],
+                length,
+                sine_source_read,
+                &source);
+    }
+
+    pv_resampler_delete(resampler);
+
+    return produced;
+}
+
+static double snr_db(const float *output, int32_t output_length, int32_t output_sample_rate, double frequency) {
+    // The stream starts from silence, so the frames within a filter length of the start are skipped.
+    double signal = 0.0;
+    double noise = 0.0;
+    for (int32_t i = output_sample_rate / 100; i < output_length; i++) {
+        const double expected = 0.5 * sin(2.0 * PI * frequency * (double) i / output_sample_rate);
+        signal += expected * expected;
+        noise += (output[i] - expected) * (output[i] - expected);
+    }
+
+    return 10.0 * log10(signal / (noise + 1e-20));
+}
+
+static void test_pv_resampler_init(void) {
+    pv_resampler_t *resampler = NULL;
+
+    pv_resampler_status_t status = pv_resampler_init(0, 48000, 1, PV_RESAMPLER_QUALITY_SINC, &resampler);
+    check_condition(
+            status == PV_RESAMPLER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Expected invalid argument for input_sample_rate, got %s.",
+            pv_resampler_status_to_string(status));
+
+    status = pv_resampler_init(16000, 48000, 0, PV_RESAMPLER_QUALITY_SINC, &resampler);
+    check_condition(
+            status == PV_RESAMPLER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Expected invalid argument for num_channels, got %s.",
+            pv_resampler_status_to_string(status));
+
+    status = pv_resampler_init(16000, 48000, 1, (pv_resampler_quality_t) 7, &resampler);
+    check_condition(
+            status == PV_RESAMPLER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Expected invalid argument for quality, got %s.",
+            pv_resampler_status_to_string(status));
+
+    status = pv_resampler_init(8000, 768000, 1, PV_RESAMPLER_QUALITY_SINC, &resampler);
+    check_condition(
+            status == PV_RESAMPLER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Expected invalid argument for an excessive ratio, got %s.",
+            pv_resampler_status_to_string(status));
+
+    status = pv_resampler_init(16000, 48000, 1, PV_RESAMPLER_QUALITY_SINC, NULL);
+    check_condition(
+            status == PV_RESAMPLER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Expected invalid argument for object, got %s.",
+            pv_resampler_status_to_string(status));
+
+    status = pv_resampler_init(22050, 48000, 2, PV_RESAMPLER_QUALITY_LINEAR, &resampler);
+    check_condition(
+            status == PV_RESAMPLER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "pv_resampler_init failed with %s.",
+            pv_resampler_status_to_string(status));
+
+    pv_resampler_delete(resampler);
+}
+
+static void test_pv_resampler_quality(void) {
+    const int32_t output_length = 48000;
+    float *output = malloc(output_length * 2 * sizeof(float));
+    check_condition(output != NULL, __FUNCTION__, __LINE__, "Failed to allocate memory.");
+
+    // Passband tones should come out as the same tone at the new rate.
+    resample_sine(16000, 48000, 1, PV_RESAMPLER_QUALITY_SINC, 1000.0, 480, output_length, output);
+    double snr = snr_db(output, output_length, 48000, 1000.0);
+    check_condition(snr > 80.0, __FUNCTION__, __LINE__, "SNR of 16 kHz to 48 kHz sinc is %.1f dB.", snr);
+
+    resample_sine(22050, 48000, 1, PV_RESAMPLER_QUALITY_SINC, 3000.0, 441, output_length, output);
+    snr = snr_db(output, output_length, 48000, 3000.0);
+    check_condition(snr > 80.0, __FUNCTION__, __LINE__, "SNR of 22.05 kHz to 48 kHz sinc is %.1f dB.", snr);
+
+    resample_sine(48000, 16000, 1, PV_RESAMPLER_QUALITY_SINC, 2000.0, 160, output_length / 3, output);
+    snr = snr_db(output, output_length / 3, 16000, 2000.0);
+    check_condition(snr > 80.0, __FUNCTION__, __LINE__, "SNR of 48 kHz to 16 kHz sinc is %.1f dB.", snr);
+
+    resample_sine(16000, 48000, 1, PV_RESAMPLER_QUALITY_LINEAR, 1000.0, 480, output_length, output);
+    snr = snr_db(output, output_length, 48000, 1000.0);
+    check_condition(snr > 30.0, __FUNCTION__, __LINE__, "SNR of 16 kHz to 48 kHz linear is %.1f dB.", snr);
+
+    resample_sine(16000, 16000, 1, PV_RESAMPLER_QUALITY_SINC, 1000.0, 100, output_length / 3, output);
+    snr = snr_db(output, output_length / 3, 16000, 1000.0);
+    check_condition(snr > 80.0, __FUNCTION__, __LINE__, "SNR of 16 kHz to 16 kHz sinc is %.1f dB.", snr);
+
+    // A tone above the output Nyquist frequency has to be filtered out rather than aliased.
+    resample_sine(48000, 16000, 1, PV_RESAMPLER_QUALITY_SINC, 10000.0, 160, output_length / 3, output);
+    double energy = 0.0;
+    for (int32_t i = 160; i < (output_length / 3); i++) {
+        energy += output[i] * output[i];
+    }
+    const double attenuation = 10.0 * log10((energy / ((output_length / 3) - 160)) / 0.125);
+    check_condition(
+            attenuation < -80.0,
+            __FUNCTION__,
+            __LINE__,
+            "Aliased tone is only attenuated by %.1f dB.",
+            attenuation);
+
+    // Channels are filtered independently.
+    resample_sine(16000, 48000, 2, PV_RESAMPLER_QUALITY_SINC, 1000.0, 480, output_length, output);
+    for (int32_t i = 0; i < output_length; i++) {
+        check_condition(
+                output[2 * i] == -output[(2 * i) + 1],
+                __FUNCTION__,
+                __LINE__,
+                "Channels differ at frame %d.",
+                i);
+    }
+
+    free(output);
+}
+
+static void test_pv_resampler_source_dry(void) {
+    pv_resampler_t *resampler = NULL;
+    pv_resampler_status_t status = pv_resampler_init(16000, 48000, 1, PV_RESAMPLER_QUALITY_SINC, &resampler);
+    check_condition(
+            status == PV_RESAMPLER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "pv_resampler_init failed with %s.",
+            pv_resampler_status_to_string(status));
+
+    float output[3200];
+
+    // 1000 input frames at three times the rate are 3000 output frames, minus the lookahead that is held back.
+    sine_source_t source = {16000, 1, 1000.0, 0, 1000};
+    int32_t produced = pv_resampler_read(resampler, output, 3200, sine_source_read, &source);
+    check_condition(
+            (produced > 2900) && (produced < 3000),
+            __FUNCTION__,
+            __LINE__,
+            "Expected fewer than 3000 frames from a dry source, got %d.",
+            produced);
+
+    source.max_length = 2000;
+    produced += pv_resampler_read(resampler, output, 3200, sine_source_read, &source);
+    check_condition(
+            (produced > 5900) && (produced < 6000),
+            __FUNCTION__,
+            __LINE__,
+            "Expected the stream to continue after the source refilled, got %d frames.",
+            produced);
+
+    pv_resampler_reset(resampler);
+    source.index = 0;
+    source.max_length = 1000;
+    produced = pv_resampler_read(resampler, output, 3200, sine_source_read, &source);
+    check_condition(
+            (produced > 2900) && (produced < 3000),
+            __FUNCTION__,
+            __LINE__,
+            "Expected a fresh stream after reset, got %d frames.",
+            produced);
+
+    pv_resampler_delete(resampler);
+}
+
+static void test_pv_resampler_benchmark(void) {
+    static const struct {
+        int32_t input_sample_rate;
+        int32_t output_sample_rate;
+        pv_resampler_quality_t quality;
+        const char *name;
+    } CASES[] = {
+            {16000, 48000, PV_RESAMPLER_QUALITY_LINEAR, "linear 16000 -> 48000"},
+            {16000, 48000, PV_RESAMPLER_QUALITY_SINC, "sinc 16000 -> 48000"},
+            {22050, 48000, PV_RESAMPLER_QUALITY_SINC, "sinc 22050 -> 48000"},
+            {48000, 16000, PV_RESAMPLER_QUALITY_SINC, "sinc 48000 -> 16000"},
+    };
+
+    // Ten seconds of output in 10 ms device periods.
+    const int32_t seconds = 10;
+    float output[480];
+
+    for (size_t i = 0; i < (sizeof(CASES) / sizeof(CASES[0])); i++) {
+        pv_resampler_t *resampler = NULL;
+        pv_resampler_status_t status = pv_resampler_init(
+                CASES[i].input_sample_rate,
+                CASES[i].output_sample_rate,
+                1,
+                CASES[i].quality,
+                &resampler);
+        check_condition(
+                status == PV_RESAMPLER_STATUS_SUCCESS,
+                __FUNCTION__,
+                __LINE__,
+                "pv_resampler_init failed with %s.",
+                pv_resampler_status_to_string(status));
+
+        const int32_t period = CASES[i].output_sample_rate / 100;
+        sine_source_t source = {CASES[i].input_sample_rate, 1, 440.0, 0, INT64_MAX};
+
+        const clock_t start = clock();
+        for (int32_t j = 0; j < (seconds * 100); j++) {
+            pv_resampler_read(resampler, output, period, sine_source_read, &source);
+        }
+        const double elapsed = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+        fprintf(
+                stdout,
+                "%s: %.2f us per 10 ms period, %.0fx real time\n",
+                CASES[i].name,
+                (elapsed * 1e6) / (seconds * 100),
+                seconds / (elapsed + 1e-9));
+
+        pv_resampler_delete(resampler);
+    }
+}
+
+int main() {
+    test_pv_resampler_init();
+    test_pv_resampler_quality();
+    test_pv_resampler_source_dry();
+    test_pv_resampler_benchmark();
+
+    return 0;
+}
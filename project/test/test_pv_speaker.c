@@ -10,6 +10,7 @@
 */
 
 #include "string.h"
+#include <pthread.h>
 #include <unistd.h>
 
 #include "pv_speaker.h"
@@ -76,182 +77,2620 @@ static void test_pv_speaker_init(void) {
             pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
 }
 
+static void test_pv_speaker_init_ex(void) {
+    pv_speaker_t *speaker = NULL;
+    pv_speaker_status_t status;
+    pv_speaker_config_t config;
+
+    printf("Call init ex with null config\n");
+    status = pv_speaker_init_ex(NULL, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    printf("Call init ex with unknown config version\n");
+    pv_speaker_config_init(&config);
+    config.version = PV_SPEAKER_CONFIG_VERSION + 1;
+    config.sample_rate = 16000;
+    config.bits_per_sample = 16;
+    status = pv_speaker_init_ex(&config, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    printf("Call init ex with negative periods\n");
+    pv_speaker_config_init(&config);
+    config.sample_rate = 16000;
+    config.bits_per_sample = 16;
+    config.periods = -1;
+    status = pv_speaker_init_ex(&config, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    printf("Call init ex with no buffer size\n");
+    pv_speaker_config_init(&config);
+    config.sample_rate = 16000;
+    config.bits_per_sample = 16;
+    config.buffer_size_ms = 0;
+    status = pv_speaker_init_ex(&config, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    printf("Call init ex with low-latency config\n");
+    pv_speaker_config_init(&config);
+    config.sample_rate = 16000;
+    config.bits_per_sample = 16;
+    config.buffer_size_ms = 50;
+    config.period_size_ms = 5;
+    config.periods = 2;
+    status = pv_speaker_init_ex(&config, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    status = pv_speaker_start(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker start returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call write with more samples than the 50 ms buffer holds\n");
+    int16_t pcm[1000] = {0};
+    int32_t written_length = 0;
+    status = pv_speaker_write(speaker, (int8_t *) pcm, 1000, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS && written_length == 800,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write wrote %d samples - expected %d.",
+            written_length,
+            800);
+
+    status = pv_speaker_stop(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker stop returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    pv_speaker_delete(speaker);
+}
+
+static void test_pv_speaker_float_stereo(void) {
+    pv_speaker_t *speaker = NULL;
+    pv_speaker_status_t status;
+    pv_speaker_config_t config;
+
+    printf("Call init ex with float samples of 16 bits\n");
+    pv_speaker_config_init(&config);
+    config.sample_rate = 16000;
+    config.bits_per_sample = 16;
+    config.is_float = true;
+    status = pv_speaker_init_ex(&config, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    printf("Call init ex with no channels\n");
+    pv_speaker_config_init(&config);
+    config.sample_rate = 16000;
+    config.bits_per_sample = 16;
+    config.num_channels = 0;
+    status = pv_speaker_init_ex(&config, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    printf("Call init ex with float stereo\n");
+    pv_speaker_config_init(&config);
+    config.sample_rate = 16000;
+    config.bits_per_sample = 32;
+    config.num_channels = 2;
+    config.is_float = true;
+    status = pv_speaker_init_ex(&config, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    status = pv_speaker_start(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker start returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    const char *output_file = "tmp_float_stereo.wav";
+    status = pv_speaker_write_to_file(speaker, output_file);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write to file returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call flush with interleaved float frames\n");
+    const int32_t num_frames = 4000;
+    float *pcm = calloc(num_frames * 2, sizeof(float));
+    check_condition(pcm != NULL, __FUNCTION__, __LINE__, "Failed to allocate PCM data.");
+    for (int32_t i = 0; i < num_frames; i++) {
+        pcm[2 * i] = 0.25f;
+        pcm[(2 * i) + 1] = -0.25f;
+    }
+    int32_t written_length = 0;
+    status = pv_speaker_flush(speaker, (int8_t *) pcm, num_frames, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS && written_length == num_frames,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker flush wrote %d frames - expected %d.",
+            written_length,
+            num_frames);
+
+    status = pv_speaker_stop(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker stop returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Check the WAV header of the float stereo recording\n");
+    uint8_t header[68];
+    FILE *file = fopen(output_file, "rb");
+    check_condition(file != NULL, __FUNCTION__, __LINE__, "Failed to open %s.", output_file);
+    check_condition(
+            fread(header, sizeof(header), 1, file) == 1,
+            __FUNCTION__,
+            __LINE__,
+            "Failed to read WAV header of %s.",
+            output_file);
+    fclose(file);
+
+    uint16_t audio_format = 0;
+    uint16_t num_channels = 0;
+    uint16_t sub_format = 0;
+    uint32_t data_size = 0;
+    memcpy(&audio_format, &header[20], sizeof(audio_format));
+    memcpy(&num_channels, &header[22], sizeof(num_channels));
+    memcpy(&sub_format, &header[44], sizeof(sub_format));
+    memcpy(&data_size, &header[64], sizeof(data_size));
+    check_condition(
+            audio_format == 0xFFFE && num_channels == 2 && sub_format == 3,
+            __FUNCTION__,
+            __LINE__,
+            "WAV header has format %u, %u channels and sub format %u - expected %u, %u and %u.",
+            audio_format,
+            num_channels,
+            sub_format,
+            0xFFFE,
+            2,
+            3);
+    check_condition(
+            data_size == (uint32_t) (num_frames * 2 * sizeof(float)),
+            __FUNCTION__,
+            __LINE__,
+            "WAV file holds %u bytes - expected %u.",
+            data_size,
+            (uint32_t) (num_frames * 2 * sizeof(float)));
+
+    printf("Call play file with the float stereo recording\n");
+    status = pv_speaker_start(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker start returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    status = pv_speaker_play_file(speaker, output_file);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker play file returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    status = pv_speaker_stop(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker stop returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    pv_speaker_delete(speaker);
+    remove(output_file);
+    free(pcm);
+}
+
+static void test_pv_speaker_resampler(void) {
+    pv_speaker_t *speaker = NULL;
+    pv_speaker_status_t status;
+    pv_speaker_config_t config;
+
+    printf("Call init ex with a negative device sample rate\n");
+    pv_speaker_config_init(&config);
+    config.sample_rate = 16000;
+    config.bits_per_sample = 16;
+    config.device_sample_rate = -1;
+    status = pv_speaker_init_ex(&config, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    printf("Call init ex with an invalid resampler quality\n");
+    pv_speaker_config_init(&config);
+    config.sample_rate = 16000;
+    config.bits_per_sample = 16;
+    config.device_sample_rate = 48000;
+    config.resampler_quality = (pv_speaker_resampler_quality_t) 5;
+    status = pv_speaker_init_ex(&config, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    const pv_speaker_resampler_quality_t qualities[] = {
+            PV_SPEAKER_RESAMPLER_QUALITY_LINEAR,
+            PV_SPEAKER_RESAMPLER_QUALITY_SINC,
+    };
+    const int32_t num_frames = 8000;
+    int16_t *pcm = calloc(num_frames, sizeof(int16_t));
+    check_condition(pcm != NULL, __FUNCTION__, __LINE__, "Failed to allocate PCM data.");
+
+    for (int32_t i = 0; i < (int32_t) (sizeof(qualities) / sizeof(qualities[0])); i++) {
+        printf("Call flush with 16 kHz audio on a 48 kHz device (quality %d)\n", qualities[i]);
+        pv_speaker_config_init(&config);
+        config.sample_rate = 16000;
+        config.bits_per_sample = 16;
+        config.device_sample_rate = 48000;
+        config.resampler_quality = qualities[i];
+        status = pv_speaker_init_ex(&config, &speaker);
+        check_condition(
+                status == PV_SPEAKER_STATUS_SUCCESS,
+                __FUNCTION__,
+                __LINE__,
+                "Speaker initialization returned %s - expected %s.",
+                pv_speaker_status_to_string(status),
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+        status = pv_speaker_start(speaker);
+        check_condition(
+                status == PV_SPEAKER_STATUS_SUCCESS,
+                __FUNCTION__,
+                __LINE__,
+                "Speaker start returned %s - expected %s.",
+                pv_speaker_status_to_string(status),
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+        int32_t written_length = 0;
+        status = pv_speaker_flush(speaker, (int8_t *) pcm, num_frames, &written_length);
+        check_condition(
+                status == PV_SPEAKER_STATUS_SUCCESS && written_length == num_frames,
+                __FUNCTION__,
+                __LINE__,
+                "Speaker flush wrote %d frames - expected %d.",
+                written_length,
+                num_frames);
+
+        // frames are counted at the caller's sample rate, not the device's
+        pv_speaker_stats_t stats;
+        status = pv_speaker_get_stats(speaker, &stats);
+        check_condition(
+                status == PV_SPEAKER_STATUS_SUCCESS && stats.frames_played == num_frames,
+                __FUNCTION__,
+                __LINE__,
+                "Speaker played %lld frames - expected %d.",
+                (long long) stats.frames_played,
+                num_frames);
+
+        status = pv_speaker_stop(speaker);
+        check_condition(
+                status == PV_SPEAKER_STATUS_SUCCESS,
+                __FUNCTION__,
+                __LINE__,
+                "Speaker stop returned %s - expected %s.",
+                pv_speaker_status_to_string(status),
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+        pv_speaker_delete(speaker);
+    }
+
+    free(pcm);
+}
+
+static void test_pv_speaker_mixer(void) {
+    pv_speaker_t *speaker = NULL;
+    pv_speaker_stream_t *stream = NULL;
+    pv_speaker_status_t status;
+    pv_speaker_config_t config;
+
+    printf("Call stream init on a speaker that is not a mixer\n");
+    pv_speaker_config_init(&config);
+    config.sample_rate = 16000;
+    config.bits_per_sample = 16;
+    status = pv_speaker_init_ex(&config, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    status = pv_speaker_stream_init(speaker, 16000, 16, false, 1600, &stream);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_STATE,
+            __FUNCTION__,
+            __LINE__,
+            "Stream initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_STATE));
+
+    pv_speaker_delete(speaker);
+
+    printf("Call stream init with invalid arguments\n");
+    pv_speaker_config_init(&config);
+    config.sample_rate = 16000;
+    config.bits_per_sample = 16;
+    config.is_mixer = true;
+    status = pv_speaker_init_ex(&config, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    status = pv_speaker_stream_init(speaker, 16000, 16, true, 1600, &stream);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Stream initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    status = pv_speaker_stream_init(speaker, 16000, 16, false, 0, &stream);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Stream initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    status = pv_speaker_start(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker start returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Play a resampled float stream on top of the speaker's own PCM data\n");
+    const int32_t num_frames = 4800;
+    float *stream_pcm = calloc(num_frames, sizeof(float));
+    int16_t *pcm = calloc(num_frames, sizeof(int16_t));
+    check_condition((stream_pcm != NULL) && (pcm != NULL), __FUNCTION__, __LINE__, "Failed to allocate PCM data.");
+
+    status = pv_speaker_stream_init(speaker, 48000, 32, true, num_frames, &stream);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Stream initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    status = pv_speaker_stream_set_gain(stream, -1.f);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Stream set gain returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    status = pv_speaker_stream_set_gain(stream, 0.5f);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Stream set gain returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    int32_t written_length = 0;
+    status = pv_speaker_stream_write(stream, (int8_t *) stream_pcm, num_frames, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS && written_length == num_frames,
+            __FUNCTION__,
+            __LINE__,
+            "Stream write wrote %d frames - expected %d.",
+            written_length,
+            num_frames);
+
+    status = pv_speaker_flush(speaker, (int8_t *) pcm, num_frames / 3, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS && written_length == (num_frames / 3),
+            __FUNCTION__,
+            __LINE__,
+            "Speaker flush wrote %d frames - expected %d.",
+            written_length,
+            num_frames / 3);
+
+    // the stream holds as much audio as the flush, so it has drained shortly after the flush returns
+    struct timespec period = {0, 50 * 1000 * 1000};
+    nanosleep(&period, NULL);
+    status = pv_speaker_stream_write(stream, (int8_t *) stream_pcm, num_frames, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS && written_length == num_frames,
+            __FUNCTION__,
+            __LINE__,
+            "Stream write after playback wrote %d frames - expected %d.",
+            written_length,
+            num_frames);
+
+    pv_speaker_stream_delete(stream);
+
+    printf("Add and remove streams while the device is running\n");
+    pv_speaker_stream_t *streams[PV_SPEAKER_MAX_STREAMS] = {NULL};
+    for (int32_t round = 0; round < 4; round++) {
+        for (int32_t i = 0; i < PV_SPEAKER_MAX_STREAMS; i++) {
+            status = pv_speaker_stream_init(speaker, 16000, 16, false, 1600, &streams[i]);
+            check_condition(
+                    status == PV_SPEAKER_STATUS_SUCCESS,
+                    __FUNCTION__,
+                    __LINE__,
+                    "Stream initialization returned %s - expected %s.",
+                    pv_speaker_status_to_string(status),
+                    pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+            pv_speaker_stream_write(streams[i], (int8_t *) pcm, 1600, &written_length);
+        }
+
+        status = pv_speaker_stream_init(speaker, 16000, 16, false, 1600, &stream);
+        check_condition(
+                status == PV_SPEAKER_STATUS_INVALID_STATE,
+                __FUNCTION__,
+                __LINE__,
+                "Stream initialization past the limit returned %s - expected %s.",
+                pv_speaker_status_to_string(status),
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_STATE));
+
+        for (int32_t i = 0; i < PV_SPEAKER_MAX_STREAMS; i++) {
+            pv_speaker_stream_delete(streams[i]);
+        }
+    }
+
+    status = pv_speaker_stop(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker stop returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Delete a stream after its speaker\n");
+    status = pv_speaker_stream_init(speaker, 16000, 16, false, 1600, &stream);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Stream initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    pv_speaker_delete(speaker);
+
+    status = pv_speaker_stream_write(stream, (int8_t *) pcm, 1600, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Stream write on a detached stream returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+    pv_speaker_stream_delete(stream);
+
+    free(pcm);
+    free(stream_pcm);
+}
+
 static void test_pv_speaker_start_stop(void) {
     pv_speaker_t *speaker = NULL;
     pv_speaker_status_t status;
-    int32_t pcm_length = 1000;
-    int16_t pcm[pcm_length];
-    memset(pcm, 0, sizeof(pcm));
-    int8_t *pcm_ptr = (int8_t *) pcm;
+    int32_t pcm_length = 1000;
+    int16_t pcm[pcm_length];
+    memset(pcm, 0, sizeof(pcm));
+    int8_t *pcm_ptr = (int8_t *) pcm;
+    int32_t written_length = 0;
+
+    status = pv_speaker_init(16000, 16, 20, 0, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Check is_started on NULL\n");
+    bool is_started = pv_speaker_get_is_started(NULL);
+    check_condition(
+            is_started == false,
+            __FUNCTION__,
+            __LINE__,
+            "get_is_started returned true on a NULL object.");
+
+    printf("Check is_started on before start\n");
+    is_started = pv_speaker_get_is_started(speaker);
+    check_condition(
+            is_started == false,
+            __FUNCTION__,
+            __LINE__,
+            "get_is_started returned true - expected false.");
+
+    printf("Call start on null object\n");
+    status = pv_speaker_start(NULL);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker start returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    printf("Call write before start object\n");
+    status = pv_speaker_write(speaker, pcm_ptr, pcm_length, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_STATE,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker read returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_STATE));
+
+    printf("Call start on valid speaker object\n");
+    status = pv_speaker_start(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker start returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call write on null speaker\n");
+    status = pv_speaker_write(NULL, pcm_ptr, pcm_length, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    printf("Call write with null pcm\n");
+    status = pv_speaker_write(speaker, NULL, pcm_length, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    printf("Call write with null written length\n");
+    status = pv_speaker_write(speaker, pcm_ptr, pcm_length, NULL);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    printf("Call write with valid args\n");
+    status = pv_speaker_write(speaker, pcm_ptr, pcm_length, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Check is_started on started speaker\n");
+    is_started = pv_speaker_get_is_started(speaker);
+    check_condition(
+            is_started == true,
+            __FUNCTION__,
+            __LINE__,
+            "get_is_started returned false - expected true.");
+
+    printf("Call flush on null speaker\n");
+    status = pv_speaker_flush(NULL, pcm_ptr, pcm_length, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker flush returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    printf("Call flush with valid args\n");
+    status = pv_speaker_flush(speaker, pcm_ptr, pcm_length, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker flush returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call flush with null pcm\n");
+    status = pv_speaker_flush(speaker, NULL, pcm_length, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker flush returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call stop on valid speaker object\n");
+    status = pv_speaker_stop(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker stop returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Check is_started on stopped speaker\n");
+    is_started = pv_speaker_get_is_started(speaker);
+    check_condition(
+            is_started == false,
+            __FUNCTION__,
+            __LINE__,
+            "get_is_started returned true - expected false.");
+
+    pv_speaker_delete(speaker);
+}
+
+static void test_pv_speaker_write_flow(void) {
+    pv_speaker_t *speaker = NULL;
+    pv_speaker_status_t status;
+    int32_t sample_rate = 16000;
+    int32_t buffer_size_secs = 1;
+    int32_t circular_buffer_size = sample_rate * buffer_size_secs;
+    int32_t pcm_length = circular_buffer_size + 1;
+    int16_t pcm[pcm_length];
+    memset(pcm, 0, sizeof(pcm));
+    int8_t *pcm_ptr = (int8_t *) pcm;
+    int32_t written_length = 0;
+
+    status = pv_speaker_init(sample_rate, 16, buffer_size_secs, 0, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call start\n");
+    status = pv_speaker_start(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker start returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    const char *output_file = "tmp.wav";
+    printf("Call write to file\n");
+    status = pv_speaker_write_to_file(speaker, output_file);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write to file returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+    check_condition(
+            access(output_file, F_OK) == 0,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write to file returned %s - expected %s.",
+            access(output_file, F_OK),
+            true);
+
+    printf("Call write with pcm length greater than circular buffer's capacity/available space\n");
+    status = pv_speaker_write(speaker, pcm_ptr, pcm_length, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+    check_condition(
+            written_length == circular_buffer_size,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write returned %s - expected %s.",
+            written_length,
+            circular_buffer_size);
+
+    printf("Call flush with pcm length greater than circular buffer's capacity/available space\n");
+    status = pv_speaker_flush(speaker, pcm_ptr, pcm_length, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker flush returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+    check_condition(
+            written_length == pcm_length,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker flush returned %s - expected %s.",
+            written_length,
+            pcm_length);
+
+    printf("Call set file overflow policy with invalid policy\n");
+    status = pv_speaker_set_file_overflow_policy(speaker, (pv_speaker_file_overflow_policy_t) 42);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker set file overflow policy returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    int64_t dropped_bytes = -1;
+    status = pv_speaker_get_file_dropped_bytes(speaker, &dropped_bytes);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS && dropped_bytes == 0,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker dropped %ld bytes - expected %d.",
+            (long) dropped_bytes,
+            0);
+
+    status = pv_speaker_stop(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker stop returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Check that the WAV file holds every written sample\n");
+    uint32_t data_size = 0;
+    FILE *file = fopen(output_file, "rb");
+    check_condition(file != NULL, __FUNCTION__, __LINE__, "Failed to open %s.", output_file);
+    fseek(file, 40, SEEK_SET);
+    check_condition(
+            fread(&data_size, sizeof(data_size), 1, file) == 1,
+            __FUNCTION__,
+            __LINE__,
+            "Failed to read WAV header of %s.",
+            output_file);
+    fclose(file);
+    check_condition(
+            data_size == (uint32_t) ((circular_buffer_size + pcm_length) * sizeof(int16_t)),
+            __FUNCTION__,
+            __LINE__,
+            "WAV file holds %u bytes - expected %u.",
+            data_size,
+            (uint32_t) ((circular_buffer_size + pcm_length) * sizeof(int16_t)));
+
+    pv_speaker_delete(speaker);
+    remove(output_file);
+}
+
+static void test_pv_speaker_file_drop_int24(void) {
+    pv_speaker_t *speaker = NULL;
+    const int32_t sample_rate = 16000;
+    const int32_t frame_size = 3;
+    pv_speaker_status_t status = pv_speaker_init(sample_rate, 24, 10, 0, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    status = pv_speaker_set_file_overflow_policy(speaker, PV_SPEAKER_FILE_OVERFLOW_POLICY_DROP);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker set file overflow policy returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    status = pv_speaker_start(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker start returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    const char *output_file = "tmp_int24.wav";
+    status = pv_speaker_write_to_file(speaker, output_file);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write to file returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call write with more 24-bit frames than the file writer can take at once\n");
+    const int32_t num_frames = sample_rate * 9;
+    int8_t *pcm = calloc((size_t) num_frames, frame_size);
+    check_condition(pcm != NULL, __FUNCTION__, __LINE__, "Failed to allocate PCM data.");
+    int32_t written_length = 0;
+    status = pv_speaker_write(speaker, pcm, num_frames, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS && written_length == num_frames,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write wrote %d frames - expected %d.",
+            written_length,
+            num_frames);
+
+    int64_t dropped_bytes = -1;
+    status = pv_speaker_get_file_dropped_bytes(speaker, &dropped_bytes);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS && dropped_bytes > 0 && (dropped_bytes % frame_size) == 0,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker dropped %ld bytes - expected a positive multiple of %d.",
+            (long) dropped_bytes,
+            frame_size);
+
+    status = pv_speaker_stop(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker stop returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Check that the WAV file only holds whole frames\n");
+    uint32_t data_size = 0;
+    FILE *file = fopen(output_file, "rb");
+    check_condition(file != NULL, __FUNCTION__, __LINE__, "Failed to open %s.", output_file);
+    fseek(file, 40, SEEK_SET);
+    check_condition(
+            fread(&data_size, sizeof(data_size), 1, file) == 1,
+            __FUNCTION__,
+            __LINE__,
+            "Failed to read WAV header of %s.",
+            output_file);
+    fclose(file);
+    check_condition(
+            (data_size % frame_size) == 0 && (data_size + dropped_bytes) == (uint32_t) (num_frames * frame_size),
+            __FUNCTION__,
+            __LINE__,
+            "WAV file holds %u bytes and %ld were dropped - expected whole frames adding up to %d bytes.",
+            data_size,
+            (long) dropped_bytes,
+            num_frames * frame_size);
+
+    free(pcm);
+    pv_speaker_delete(speaker);
+    remove(output_file);
+}
+
+static void test_pv_speaker_write_reserve_commit(void) {
+    pv_speaker_t *speaker = NULL;
+    pv_speaker_status_t status;
+    int8_t *pcm1 = NULL;
+    int32_t pcm1_length = 0;
+    int8_t *pcm2 = NULL;
+    int32_t pcm2_length = 0;
+
+    status = pv_speaker_init(16000, 16, 1, 0, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call write reserve before start\n");
+    status = pv_speaker_write_reserve(speaker, 1000, &pcm1, &pcm1_length, &pcm2, &pcm2_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_STATE,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write reserve returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_STATE));
+
+    status = pv_speaker_start(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker start returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call write reserve with null regions\n");
+    status = pv_speaker_write_reserve(speaker, 1000, NULL, &pcm1_length, &pcm2, &pcm2_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write reserve returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    printf("Call write reserve and commit with valid args\n");
+    status = pv_speaker_write_reserve(speaker, 1000, &pcm1, &pcm1_length, &pcm2, &pcm2_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write reserve returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+    check_condition(
+            pcm1 != NULL && (pcm1_length + pcm2_length) == 1000,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write reserve returned %d samples - expected %d.",
+            pcm1_length + pcm2_length,
+            1000);
+
+    memset(pcm1, 0, pcm1_length * sizeof(int16_t));
+    if (pcm2_length > 0) {
+        memset(pcm2, 0, pcm2_length * sizeof(int16_t));
+    }
+    status = pv_speaker_write_commit(speaker, pcm1_length + pcm2_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write commit returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call write commit with more samples than available\n");
+    status = pv_speaker_write_commit(speaker, 16001);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write commit returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    status = pv_speaker_stop(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker stop returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    pv_speaker_delete(speaker);
+}
+
+static void test_pv_speaker_write_blocking(void) {
+    pv_speaker_t *speaker = NULL;
+    pv_speaker_status_t status;
+    int32_t written_length = 0;
+
+    // one and a half seconds of audio for a buffer that holds one second
+    const int32_t pcm_length = 24000;
+    int16_t *pcm = calloc(pcm_length, sizeof(int16_t));
+    check_condition(pcm != NULL, __FUNCTION__, __LINE__, "Failed to allocate PCM data.");
+
+    status = pv_speaker_init(16000, 16, 1, 0, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call write blocking before start\n");
+    status = pv_speaker_write_blocking(speaker, (int8_t *) pcm, pcm_length, -1, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_STATE,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write blocking returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_STATE));
+
+    status = pv_speaker_start(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker start returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call write blocking with invalid arguments\n");
+    status = pv_speaker_write_blocking(speaker, NULL, pcm_length, -1, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write blocking returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    printf("Call write blocking with more audio than the buffer holds\n");
+    status = pv_speaker_write_blocking(speaker, (int8_t *) pcm, pcm_length, -1, &written_length);
+    check_condition(
+            (status == PV_SPEAKER_STATUS_SUCCESS) && (written_length == pcm_length),
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write blocking returned %s after writing %d frames - expected %s after %d.",
+            pv_speaker_status_to_string(status),
+            written_length,
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS),
+            pcm_length);
+
+    pv_speaker_stats_t stats;
+    pv_speaker_get_stats(speaker, &stats);
+    check_condition(
+            stats.frames_played >= (pcm_length - 16000),
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write blocking returned after %lld frames were played - expected at least %d.",
+            (long long) stats.frames_played,
+            pcm_length - 16000);
+
+    printf("Call write blocking with a timeout while the buffer is full\n");
+    status = pv_speaker_write_blocking(speaker, (int8_t *) pcm, pcm_length, 100, &written_length);
+    check_condition(
+            (status == PV_SPEAKER_STATUS_TIMEOUT) && (written_length < pcm_length),
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write blocking returned %s after writing %d frames - expected %s.",
+            pv_speaker_status_to_string(status),
+            written_length,
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_TIMEOUT));
+
+    status = pv_speaker_stop(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker stop returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    pv_speaker_delete(speaker);
+    free(pcm);
+}
+
+static void test_pv_speaker_pack_int24(void) {
+    printf("Call pack int24 with invalid arguments\n");
+    const int32_t pcm[] = {0, 1, -1, 8388607, -8388608, 0x123456};
+    const int32_t pcm_length = sizeof(pcm) / sizeof(pcm[0]);
+    int8_t packed_pcm[sizeof(pcm) / sizeof(pcm[0]) * 3];
+    pv_speaker_status_t status = pv_speaker_pack_int24(NULL, pcm_length, packed_pcm);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker pack int24 returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+    status = pv_speaker_pack_int24(pcm, pcm_length, NULL);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker pack int24 returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    printf("Call pack int24 with valid args\n");
+    status = pv_speaker_pack_int24(pcm, pcm_length, packed_pcm);
+    const uint8_t expected[] = {
+            0x00, 0x00, 0x00,
+            0x01, 0x00, 0x00,
+            0xFF, 0xFF, 0xFF,
+            0xFF, 0xFF, 0x7F,
+            0x00, 0x00, 0x80,
+            0x56, 0x34, 0x12};
+    check_condition(
+            (status == PV_SPEAKER_STATUS_SUCCESS) && (memcmp(packed_pcm, expected, sizeof(expected)) == 0),
+            __FUNCTION__,
+            __LINE__,
+            "Speaker pack int24 returned %s or packed the samples incorrectly.",
+            pv_speaker_status_to_string(status));
+}
+
+static void test_pv_speaker_notification(void *user_data) {
+    __atomic_add_fetch((int32_t *) user_data, 1, __ATOMIC_SEQ_CST);
+}
+
+// waits up to `timeout_ms` for `*count` to reach `expected`
+static bool test_pv_speaker_wait_for_count(int32_t *count, int32_t expected, int32_t timeout_ms) {
+    for (int32_t i = 0; i < timeout_ms; i += 10) {
+        if (__atomic_load_n(count, __ATOMIC_SEQ_CST) >= expected) {
+            break;
+        }
+        usleep(10 * 1000);
+    }
+    return __atomic_load_n(count, __ATOMIC_SEQ_CST) == expected;
+}
+
+static void test_pv_speaker_notify(void) {
+    pv_speaker_t *speaker = NULL;
+    pv_speaker_status_t status;
+    int32_t written_length = 0;
+    int32_t available_count = 0;
+    int32_t drained_count = 0;
+
+    // a second of audio for a buffer that holds one second
+    const int32_t pcm_length = 16000;
+    int16_t *pcm = calloc(pcm_length, sizeof(int16_t));
+    check_condition(pcm != NULL, __FUNCTION__, __LINE__, "Failed to allocate PCM data.");
+
+    status = pv_speaker_init(16000, 16, 1, 0, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call notify available and notify drained with invalid arguments\n");
+    status = pv_speaker_notify_available(NULL, 100, test_pv_speaker_notification, &available_count);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker notify available returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+    status = pv_speaker_notify_available(speaker, 0, test_pv_speaker_notification, &available_count);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker notify available returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+    status = pv_speaker_notify_drained(speaker, NULL, &drained_count);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker notify drained returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    printf("Call notify available and notify drained before start\n");
+    status = pv_speaker_notify_available(speaker, 100, test_pv_speaker_notification, &available_count);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_STATE,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker notify available returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_STATE));
+    status = pv_speaker_notify_drained(speaker, test_pv_speaker_notification, &drained_count);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_STATE,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker notify drained returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_STATE));
+
+    status = pv_speaker_start(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker start returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call notify available while there is room\n");
+    status = pv_speaker_notify_available(speaker, 100, test_pv_speaker_notification, &available_count);
+    check_condition(
+            (status == PV_SPEAKER_STATUS_SUCCESS) && (__atomic_load_n(&available_count, __ATOMIC_SEQ_CST) == 1),
+            __FUNCTION__,
+            __LINE__,
+            "Speaker notify available returned %s and called back %d times - expected %s and once.",
+            pv_speaker_status_to_string(status),
+            __atomic_load_n(&available_count, __ATOMIC_SEQ_CST),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call notify available while the buffer is full\n");
+    status = pv_speaker_write(speaker, (int8_t *) pcm, pcm_length, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+    status = pv_speaker_notify_available(speaker, 4000, test_pv_speaker_notification, &available_count);
+    check_condition(
+            (status == PV_SPEAKER_STATUS_SUCCESS) && (__atomic_load_n(&available_count, __ATOMIC_SEQ_CST) == 1),
+            __FUNCTION__,
+            __LINE__,
+            "Speaker notify available returned %s and called back %d times - expected %s and no new call.",
+            pv_speaker_status_to_string(status),
+            __atomic_load_n(&available_count, __ATOMIC_SEQ_CST),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+    status = pv_speaker_notify_available(speaker, 4000, test_pv_speaker_notification, &available_count);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_STATE,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker notify available returned %s while another one was pending - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_STATE));
+    check_condition(
+            test_pv_speaker_wait_for_count(&available_count, 2, 2000),
+            __FUNCTION__,
+            __LINE__,
+            "Notify available called back %d times - expected 2.",
+            __atomic_load_n(&available_count, __ATOMIC_SEQ_CST));
+
+    printf("Call notify drained\n");
+    status = pv_speaker_notify_drained(speaker, test_pv_speaker_notification, &drained_count);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker notify drained returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+    check_condition(
+            test_pv_speaker_wait_for_count(&drained_count, 1, 3000),
+            __FUNCTION__,
+            __LINE__,
+            "Notify drained called back %d times - expected once.",
+            __atomic_load_n(&drained_count, __ATOMIC_SEQ_CST));
+
+    pv_speaker_stats_t stats;
+    pv_speaker_get_stats(speaker, &stats);
+    check_condition(
+            (stats.fill == 0) && (stats.frames_played == stats.frames_written),
+            __FUNCTION__,
+            __LINE__,
+            "Notify drained called back with %d frames buffered and %lld of %lld frames played.",
+            stats.fill,
+            (long long) stats.frames_played,
+            (long long) stats.frames_written);
+
+    printf("Cancel with a pending notification that signals a pipe\n");
+    status = pv_speaker_write(speaker, (int8_t *) pcm, pcm_length, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+    int fds[2];
+    check_condition(pipe(fds) == 0, __FUNCTION__, __LINE__, "Failed to create a pipe.");
+    status = pv_speaker_notify_available(speaker, pcm_length, pv_speaker_signal_fd, (void *) (intptr_t) fds[1]);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker notify available returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+    int32_t discarded_length = 0;
+    pv_speaker_cancel(speaker, 0, &discarded_length);
+    uint64_t signal_count = 0;
+    check_condition(
+            (read(fds[0], &signal_count, sizeof(signal_count)) == sizeof(signal_count)) && (signal_count == 1),
+            __FUNCTION__,
+            __LINE__,
+            "Cancel did not signal the pipe.");
+    close(fds[0]);
+    close(fds[1]);
+
+    printf("Stop with pending notifications\n");
+    status = pv_speaker_write(speaker, (int8_t *) pcm, pcm_length, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+    pv_speaker_notify_available(speaker, pcm_length, test_pv_speaker_notification, &available_count);
+    pv_speaker_notify_drained(speaker, test_pv_speaker_notification, &drained_count);
+    status = pv_speaker_stop(speaker);
+    check_condition(
+            (status == PV_SPEAKER_STATUS_SUCCESS) && (__atomic_load_n(&available_count, __ATOMIC_SEQ_CST) == 3) &&
+            (__atomic_load_n(&drained_count, __ATOMIC_SEQ_CST) == 2),
+            __FUNCTION__,
+            __LINE__,
+            "Speaker stop returned %s and left notifications pending.",
+            pv_speaker_status_to_string(status));
+
+    pv_speaker_delete(speaker);
+    free(pcm);
+}
+
+static void test_pv_speaker_shared_buffer(void) {
+    pv_speaker_t *speaker = NULL;
+    pv_speaker_status_t status;
+    int32_t written_length = 0;
+
+    // 100 ms of 16 kHz audio behind the header
+    const int32_t length = 1600;
+    const size_t memory_size = PV_SPEAKER_SHARED_BUFFER_HEADER_SIZE + (length * sizeof(int16_t));
+    int32_t *memory = calloc(memory_size / sizeof(int32_t), sizeof(int32_t));
+    check_condition(memory != NULL, __FUNCTION__, __LINE__, "Failed to allocate shared buffer.");
+    int32_t *write_index = &memory[PV_SPEAKER_SHARED_BUFFER_WRITE_INDEX];
+    int16_t *ring = (int16_t *) ((int8_t *) memory + PV_SPEAKER_SHARED_BUFFER_HEADER_SIZE);
+
+    status = pv_speaker_init(16000, 16, 1, 0, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call set shared buffer with invalid arguments\n");
+    status = pv_speaker_set_shared_buffer(NULL, (int8_t *) memory, length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker set shared buffer returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+    status = pv_speaker_set_shared_buffer(speaker, (int8_t *) memory + 1, length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker set shared buffer with unaligned memory returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+    status = pv_speaker_set_shared_buffer(speaker, (int8_t *) memory, 0);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker set shared buffer with no length returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    printf("Call set shared buffer with valid args\n");
+    status = pv_speaker_set_shared_buffer(speaker, (int8_t *) memory, length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker set shared buffer returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    status = pv_speaker_start(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker start returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    status = pv_speaker_set_shared_buffer(speaker, NULL, 0);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_STATE,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker set shared buffer while started returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_STATE));
+
+    printf("Write to the shared buffer directly\n");
+    // plays 320 ms through the 100 ms ring, publishing 40 ms at a time like a foreign writer would
+    const int32_t num_frames = 5120;
+    int32_t num_written = 0;
+    while (num_written < num_frames) {
+        const int32_t index = __atomic_load_n(write_index, __ATOMIC_RELAXED);
+        const int32_t read_index = __atomic_load_n(&memory[PV_SPEAKER_SHARED_BUFFER_READ_INDEX], __ATOMIC_ACQUIRE);
+        const int32_t count = (index - read_index + (2 * length)) % (2 * length);
+        if ((length - count) < 640) {
+            usleep(5 * 1000);
+            continue;
+        }
+        for (int32_t i = 0; i < 640; i++) {
+            ring[(index + i) % length] = (int16_t) (num_written + i);
+        }
+        __atomic_store_n(write_index, (index + 640) % (2 * length), __ATOMIC_RELEASE);
+        num_written += 640;
+    }
+
+    status = pv_speaker_flush(speaker, NULL, 0, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker flush returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    pv_speaker_stats_t stats;
+    pv_speaker_get_stats(speaker, &stats);
+    check_condition(
+            (stats.frames_played == num_frames) && (stats.frames_written == 0),
+            __FUNCTION__,
+            __LINE__,
+            "Played %lld frames and counted %lld as written - expected %d and 0.",
+            (long long) stats.frames_played,
+            (long long) stats.frames_written,
+            num_frames);
+
+    printf("Call write with a shared buffer\n");
+    int16_t pcm[100] = {0};
+    const int32_t index = __atomic_load_n(write_index, __ATOMIC_ACQUIRE);
+    status = pv_speaker_write(speaker, (int8_t *) pcm, 100, &written_length);
+    check_condition(
+            (status == PV_SPEAKER_STATUS_INVALID_STATE) && (__atomic_load_n(write_index, __ATOMIC_ACQUIRE) == index),
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write with a shared buffer returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_STATE));
+    status = pv_speaker_flush(speaker, (int8_t *) pcm, 100, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_STATE,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker flush with a shared buffer returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_STATE));
+    int8_t *pcm1 = NULL;
+    int32_t pcm1_length = 0;
+    int8_t *pcm2 = NULL;
+    int32_t pcm2_length = 0;
+    status = pv_speaker_write_reserve(speaker, 100, &pcm1, &pcm1_length, &pcm2, &pcm2_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_STATE,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write reserve with a shared buffer returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_STATE));
+
+    printf("Stop with frames left in the shared buffer\n");
+    for (int32_t i = 0; i < 640; i++) {
+        ring[(index + i) % length] = 0;
+    }
+    __atomic_store_n(write_index, (index + 640) % (2 * length), __ATOMIC_RELEASE);
+    pv_speaker_stop(speaker);
+    check_condition(
+            (__atomic_load_n(write_index, __ATOMIC_ACQUIRE) == ((index + 640) % (2 * length))) &&
+            (__atomic_load_n(&memory[PV_SPEAKER_SHARED_BUFFER_READ_INDEX], __ATOMIC_ACQUIRE) ==
+             ((index + 640) % (2 * length))),
+            __FUNCTION__,
+            __LINE__,
+            "Speaker stop did not leave the shared buffer empty at the write index of the writer.");
+
+    printf("Switch back to the internal buffer\n");
+    status = pv_speaker_set_shared_buffer(speaker, NULL, 0);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker set shared buffer returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+    free(memory);
+
+    pv_speaker_start(speaker);
+    int16_t internal_pcm[16000] = {0};
+    status = pv_speaker_write(speaker, (int8_t *) internal_pcm, 16000, &written_length);
+    check_condition(
+            (status == PV_SPEAKER_STATUS_SUCCESS) && (written_length == 16000),
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write returned %s and wrote %d samples - expected %s and 16000.",
+            pv_speaker_status_to_string(status),
+            written_length,
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    pv_speaker_stop(speaker);
+    pv_speaker_delete(speaker);
+}
+
+static void test_pv_speaker_flush_timeout(void) {
+    pv_speaker_t *speaker = NULL;
+    pv_speaker_status_t status;
+    int32_t written_length = 0;
+
+    // one second of audio in a buffer that holds all of it
+    const int32_t pcm_length = 16000;
+    int16_t *pcm = calloc(pcm_length, sizeof(int16_t));
+    check_condition(pcm != NULL, __FUNCTION__, __LINE__, "Failed to allocate PCM data.");
+
+    status = pv_speaker_init(16000, 16, 1, 0, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    status = pv_speaker_start(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker start returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call flush timeout with negative timeout\n");
+    status = pv_speaker_flush_timeout(speaker, (int8_t *) pcm, pcm_length, -1, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker flush timeout returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    printf("Call flush timeout with timeout shorter than the audio\n");
+    status = pv_speaker_flush_timeout(speaker, (int8_t *) pcm, pcm_length, 100, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_TIMEOUT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker flush timeout returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_TIMEOUT));
+    check_condition(
+            written_length == pcm_length,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker flush timeout wrote %d samples - expected %d.",
+            written_length,
+            pcm_length);
+
+    printf("Call flush timeout with timeout longer than the audio\n");
+    status = pv_speaker_flush_timeout(speaker, NULL, 0, 5000, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker flush timeout returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    status = pv_speaker_stop(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker stop returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    pv_speaker_delete(speaker);
+    free(pcm);
+}
+
+static void write_test_wav_file(const char *path, uint32_t sample_rate, int32_t num_samples) {
+    FILE *file = fopen(path, "wb");
+    check_condition(file != NULL, __FUNCTION__, __LINE__, "Failed to open %s.", path);
+
+    const uint16_t audio_format = 1;
+    const uint16_t num_channels = 1;
+    const uint16_t bits_per_sample = 16;
+    const uint16_t block_align = num_channels * bits_per_sample / 8;
+    const uint32_t byte_rate = sample_rate * block_align;
+    const uint32_t fmt_size = 16;
+    const uint32_t list_size = 5;
+    const uint32_t data_size = num_samples * block_align;
+    const uint32_t riff_size = 4 + (8 + fmt_size) + (8 + list_size + 1) + (8 + data_size);
+
+    fwrite("RIFF", 4, 1, file);
+    fwrite(&riff_size, sizeof(riff_size), 1, file);
+    fwrite("WAVE", 4, 1, file);
+    fwrite("fmt ", 4, 1, file);
+    fwrite(&fmt_size, sizeof(fmt_size), 1, file);
+    fwrite(&audio_format, sizeof(audio_format), 1, file);
+    fwrite(&num_channels, sizeof(num_channels), 1, file);
+    fwrite(&sample_rate, sizeof(sample_rate), 1, file);
+    fwrite(&byte_rate, sizeof(byte_rate), 1, file);
+    fwrite(&block_align, sizeof(block_align), 1, file);
+    fwrite(&bits_per_sample, sizeof(bits_per_sample), 1, file);
+    // odd-sized chunk the player has to skip, including its padding byte
+    fwrite("LIST", 4, 1, file);
+    fwrite(&list_size, sizeof(list_size), 1, file);
+    fwrite("abcde", list_size + 1, 1, file);
+    fwrite("data", 4, 1, file);
+    fwrite(&data_size, sizeof(data_size), 1, file);
+    for (int32_t i = 0; i < num_samples; i++) {
+        int16_t sample = (int16_t) ((rand() % 2001) - 1000);
+        fwrite(&sample, sizeof(sample), 1, file);
+    }
+
+    fclose(file);
+}
+
+static void test_pv_speaker_play_file(void) {
+    pv_speaker_t *speaker = NULL;
+    pv_speaker_status_t status;
+
+    const char *input_file = "tmp_play.wav";
+    const char *mismatched_file = "tmp_play_8k.wav";
+    write_test_wav_file(input_file, 16000, 4000);
+    write_test_wav_file(mismatched_file, 8000, 4000);
+
+    status = pv_speaker_init(16000, 16, 1, 0, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call play file before start\n");
+    status = pv_speaker_play_file(speaker, input_file);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_STATE,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker play file returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_STATE));
+
+    status = pv_speaker_start(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker start returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call play file with missing file\n");
+    status = pv_speaker_play_file(speaker, "does_not_exist.wav");
+    check_condition(
+            status == PV_SPEAKER_STATUS_IO_ERROR,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker play file returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_IO_ERROR));
+
+    printf("Call play file with mismatched sample rate\n");
+    status = pv_speaker_play_file(speaker, mismatched_file);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker play file returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    printf("Call play file with valid file\n");
+    status = pv_speaker_play_file(speaker, input_file);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker play file returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    status = pv_speaker_stop(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker stop returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    pv_speaker_delete(speaker);
+    remove(input_file);
+    remove(mismatched_file);
+}
+
+typedef struct {
+    int32_t num_calls;
+    int32_t num_samples;
+} test_pv_speaker_render_state_t;
+
+static void test_pv_speaker_render(void *user_data, int8_t *pcm, int32_t num_samples) {
+    test_pv_speaker_render_state_t *state = (test_pv_speaker_render_state_t *) user_data;
+    memset(pcm, 0, num_samples * sizeof(int16_t));
+    __atomic_add_fetch(&state->num_calls, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&state->num_samples, num_samples, __ATOMIC_RELAXED);
+}
+
+static void test_pv_speaker_render_callback(void) {
+    pv_speaker_t *speaker = NULL;
+    pv_speaker_status_t status;
+    test_pv_speaker_render_state_t state = {0, 0};
+    int16_t pcm[512] = {0};
+    int32_t written_length = 0;
+
+    status = pv_speaker_init(16000, 16, 1, 0, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call set render callback on null speaker\n");
+    status = pv_speaker_set_render_callback(NULL, test_pv_speaker_render, &state);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker set render callback returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    printf("Call set render callback with valid args\n");
+    status = pv_speaker_set_render_callback(speaker, test_pv_speaker_render, &state);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker set render callback returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    status = pv_speaker_start(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker start returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call set render callback while started\n");
+    status = pv_speaker_set_render_callback(speaker, NULL, NULL);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_STATE,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker set render callback returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_STATE));
+
+    printf("Call write in pull mode\n");
+    status = pv_speaker_write(speaker, (int8_t *) pcm, 512, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_STATE,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_STATE));
+
+    usleep(200 * 1000);
+
+    status = pv_speaker_stop(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker stop returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+    check_condition(
+            state.num_calls > 0 && state.num_samples > 0,
+            __FUNCTION__,
+            __LINE__,
+            "Render callback was called %d times - expected at least once.",
+            state.num_calls);
+
+    printf("Call write after switching back to push mode\n");
+    status = pv_speaker_set_render_callback(speaker, NULL, NULL);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker set render callback returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    status = pv_speaker_start(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker start returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    status = pv_speaker_write(speaker, (int8_t *) pcm, 512, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    status = pv_speaker_stop(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker stop returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    pv_speaker_delete(speaker);
+}
+
+static void test_pv_speaker_set_gain(void) {
+    pv_speaker_t *speaker = NULL;
+    pv_speaker_status_t status = pv_speaker_init(16000, 16, 1, -1, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call set gain with invalid arguments\n");
+    status = pv_speaker_set_gain(NULL, 1.f, 0);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker set gain returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    status = pv_speaker_set_gain(speaker, -0.5f, 0);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker set gain returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    status = pv_speaker_set_gain(speaker, 1.f, -1);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker set gain returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    status = pv_speaker_start(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker start returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Change the gain while playing\n");
+    const float gains[] = {0.5f, 0.f, 2.f, 1.f};
+    const int32_t ramps_ms[] = {20, 5, 0, 50};
+    int16_t pcm[1600] = {0};
+    for (int32_t i = 0; i < (int32_t) (sizeof(gains) / sizeof(gains[0])); i++) {
+        status = pv_speaker_set_gain(speaker, gains[i], ramps_ms[i]);
+        check_condition(
+                status == PV_SPEAKER_STATUS_SUCCESS,
+                __FUNCTION__,
+                __LINE__,
+                "Speaker set gain returned %s - expected %s.",
+                pv_speaker_status_to_string(status),
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+        int32_t written_length = 0;
+        status = pv_speaker_flush(speaker, (int8_t *) pcm, 1600, &written_length);
+        check_condition(
+                status == PV_SPEAKER_STATUS_SUCCESS && written_length == 1600,
+                __FUNCTION__,
+                __LINE__,
+                "Speaker flush wrote %d frames - expected %d.",
+                written_length,
+                1600);
+    }
+
+    status = pv_speaker_stop(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker stop returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    pv_speaker_delete(speaker);
+}
+
+static void test_pv_speaker_pause_resume(void) {
+    pv_speaker_t *speaker = NULL;
+    pv_speaker_status_t status;
+    pv_speaker_stats_t stats;
+
+    const int32_t pcm_length = 8000;
+    int16_t *pcm = calloc(pcm_length, sizeof(int16_t));
+    check_condition(pcm != NULL, __FUNCTION__, __LINE__, "Failed to allocate PCM data.");
+
+    status = pv_speaker_init(16000, 16, 1, 0, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call pause and resume before start\n");
+    status = pv_speaker_pause(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_STATE,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker pause returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_STATE));
+
+    status = pv_speaker_resume(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_STATE,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker resume returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_STATE));
+
+    status = pv_speaker_start(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker start returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
     int32_t written_length = 0;
+    status = pv_speaker_write(speaker, (int8_t *) pcm, pcm_length, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS && written_length == pcm_length,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write returned %s and wrote %d frames - expected %s and %d frames.",
+            pv_speaker_status_to_string(status),
+            written_length,
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS),
+            pcm_length);
+
+    printf("Pause while playing\n");
+    usleep(100 * 1000);
+    status = pv_speaker_pause(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS && pv_speaker_get_is_paused(speaker),
+            __FUNCTION__,
+            __LINE__,
+            "Speaker pause returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    // the fade out finishes within a period, after which nothing is taken from the buffer
+    usleep(100 * 1000);
+    pv_speaker_get_stats(speaker, &stats);
+    const int64_t frames_played = stats.frames_played;
+    usleep(300 * 1000);
+    pv_speaker_get_stats(speaker, &stats);
+    check_condition(
+            (stats.frames_played == frames_played) && (frames_played < pcm_length) && (stats.num_underruns == 0),
+            __FUNCTION__,
+            __LINE__,
+            "Speaker played %lld frames while paused - expected none and no underruns.",
+            (long long) (stats.frames_played - frames_played));
+
+    printf("Call start while paused\n");
+    status = pv_speaker_start(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_STATE && pv_speaker_get_is_paused(speaker),
+            __FUNCTION__,
+            __LINE__,
+            "Speaker start returned %s - expected %s and the speaker to stay paused.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_STATE));
+
+    printf("Resume and flush\n");
+    status = pv_speaker_resume(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS && !pv_speaker_get_is_paused(speaker),
+            __FUNCTION__,
+            __LINE__,
+            "Speaker resume returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    status = pv_speaker_flush(speaker, NULL, 0, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker flush returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    pv_speaker_get_stats(speaker, &stats);
+    check_condition(
+            stats.frames_played == pcm_length,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker played %lld frames - expected %d.",
+            (long long) stats.frames_played,
+            pcm_length);
+
+    status = pv_speaker_stop(speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker stop returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    pv_speaker_delete(speaker);
+    free(pcm);
+}
+
+typedef struct {
+    int32_t num_markers;
+    int64_t frame_indices[8];
+} test_pv_speaker_markers_t;
+
+static void test_pv_speaker_marker(void *user_data, int64_t frame_index) {
+    test_pv_speaker_markers_t *markers = (test_pv_speaker_markers_t *) user_data;
+    const int32_t i = __atomic_load_n(&markers->num_markers, __ATOMIC_RELAXED);
+    if (i < 8) {
+        markers->frame_indices[i] = frame_index;
+        __atomic_store_n(&markers->num_markers, i + 1, __ATOMIC_RELEASE);
+    }
+}
+
+static void test_pv_speaker_position(void) {
+    pv_speaker_t *speaker = NULL;
+    pv_speaker_status_t status;
+    test_pv_speaker_markers_t markers = {0};
+
+    const int32_t pcm_length = 8000;
+    int16_t *pcm = calloc(pcm_length, sizeof(int16_t));
+    check_condition(pcm != NULL, __FUNCTION__, __LINE__, "Failed to allocate PCM data.");
+
+    status = pv_speaker_init(16000, 16, 1, -1, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    printf("Call get position and add marker with invalid arguments\n");
+    int64_t frames_played = -1;
+    uint64_t timestamp_ns = 0;
+    status = pv_speaker_get_position(speaker, NULL, &timestamp_ns);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker get position returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    status = pv_speaker_add_marker(speaker, -1, test_pv_speaker_marker, &markers);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker add marker returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    status = pv_speaker_add_marker(speaker, 0, NULL, &markers);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker add marker returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
 
-    status = pv_speaker_init(16000, 16, 20, 0, &speaker);
+    status = pv_speaker_get_position(speaker, &frames_played, &timestamp_ns);
+    check_condition(
+            (status == PV_SPEAKER_STATUS_SUCCESS) && (frames_played == 0) && (timestamp_ns > 0),
+            __FUNCTION__,
+            __LINE__,
+            "Speaker position before playing is %lld - expected 0.",
+            (long long) frames_played);
+
+    status = pv_speaker_start(speaker);
     check_condition(
             status == PV_SPEAKER_STATUS_SUCCESS,
             __FUNCTION__,
             __LINE__,
-            "Speaker initialization returned %s - expected %s.",
+            "Speaker start returned %s - expected %s.",
             pv_speaker_status_to_string(status),
             pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
 
-    printf("Check is_started on NULL\n");
-    bool is_started = pv_speaker_get_is_started(NULL);
+    printf("Add markers out of order and follow the position while playing\n");
+    const int64_t marker_frames[] = {7999, 0, 4000};
+    for (int32_t i = 0; i < 3; i++) {
+        status = pv_speaker_add_marker(speaker, marker_frames[i], test_pv_speaker_marker, &markers);
+        check_condition(
+                status == PV_SPEAKER_STATUS_SUCCESS,
+                __FUNCTION__,
+                __LINE__,
+                "Speaker add marker returned %s - expected %s.",
+                pv_speaker_status_to_string(status),
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+    }
+
+    int32_t written_length = 0;
+    pv_speaker_write(speaker, (int8_t *) pcm, pcm_length, &written_length);
+
+    int64_t last_frames_played = 0;
+    for (int32_t i = 0; i < 20; i++) {
+        usleep(10 * 1000);
+        pv_speaker_get_position(speaker, &frames_played, &timestamp_ns);
+        check_condition(
+                (frames_played >= last_frames_played) && (frames_played <= pcm_length),
+                __FUNCTION__,
+                __LINE__,
+                "Speaker position went from %lld to %lld.",
+                (long long) last_frames_played,
+                (long long) frames_played);
+        last_frames_played = frames_played;
+    }
     check_condition(
-            is_started == false,
+            last_frames_played > 0,
             __FUNCTION__,
             __LINE__,
-            "get_is_started returned true on a NULL object.");
+            "Speaker position did not advance while playing.");
 
-    printf("Check is_started on before start\n");
-    is_started = pv_speaker_get_is_started(speaker);
+    status = pv_speaker_flush(speaker, NULL, 0, &written_length);
     check_condition(
-            is_started == false,
+            status == PV_SPEAKER_STATUS_SUCCESS,
             __FUNCTION__,
             __LINE__,
-            "get_is_started returned true - expected false.");
+            "Speaker flush returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
 
-    printf("Call start on null object\n");
-    status = pv_speaker_start(NULL);
+    // the device's own buffer still has to play out
+    usleep(200 * 1000);
+    pv_speaker_get_position(speaker, &frames_played, &timestamp_ns);
+    const int32_t num_markers = __atomic_load_n(&markers.num_markers, __ATOMIC_ACQUIRE);
     check_condition(
-            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            (frames_played == pcm_length) && (num_markers == 3),
             __FUNCTION__,
             __LINE__,
-            "Speaker start returned %s - expected %s.",
-            pv_speaker_status_to_string(status),
-            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+            "Speaker position is %lld with %d markers fired - expected %d with %d.",
+            (long long) frames_played,
+            num_markers,
+            pcm_length,
+            3);
+    for (int32_t i = 0; i < num_markers; i++) {
+        const int64_t expected = (i == 0) ? 0 : ((i == 1) ? 4000 : 7999);
+        check_condition(
+                markers.frame_indices[i] == expected,
+                __FUNCTION__,
+                __LINE__,
+                "Marker %d fired for frame %lld - expected %lld.",
+                i,
+                (long long) markers.frame_indices[i],
+                (long long) expected);
+    }
 
-    printf("Call write before start object\n");
-    status = pv_speaker_write(speaker, pcm_ptr, pcm_length, &written_length);
+    printf("Cancel drops the markers of discarded frames\n");
+    pv_speaker_write(speaker, (int8_t *) pcm, pcm_length, &written_length);
+    pv_speaker_add_marker(speaker, pcm_length + 7000, test_pv_speaker_marker, &markers);
+    usleep(100 * 1000);
+    int32_t discarded_length = 0;
+    pv_speaker_cancel(speaker, 0, &discarded_length);
+    usleep(200 * 1000);
+    pv_speaker_get_position(speaker, &frames_played, &timestamp_ns);
     check_condition(
-            status == PV_SPEAKER_STATUS_INVALID_STATE,
+            (frames_played == (2 * pcm_length)) && (__atomic_load_n(&markers.num_markers, __ATOMIC_ACQUIRE) == 3),
             __FUNCTION__,
             __LINE__,
-            "Speaker read returned %s - expected %s.",
-            pv_speaker_status_to_string(status),
-            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_STATE));
+            "Speaker position after cancel is %lld - expected %d without firing the marker.",
+            (long long) frames_played,
+            2 * pcm_length);
 
-    printf("Call start on valid speaker object\n");
-    status = pv_speaker_start(speaker);
+    pv_speaker_stop(speaker);
+    pv_speaker_delete(speaker);
+    free(pcm);
+}
+
+static void test_pv_speaker_get_stats(void) {
+    pv_speaker_t *speaker = NULL;
+    pv_speaker_status_t status;
+    pv_speaker_stats_t stats;
+
+    const int32_t pcm_length = 8000;
+    int16_t *pcm = calloc(pcm_length, sizeof(int16_t));
+    check_condition(pcm != NULL, __FUNCTION__, __LINE__, "Failed to allocate PCM data.");
+
+    status = pv_speaker_init(16000, 16, 1, 0, &speaker);
     check_condition(
             status == PV_SPEAKER_STATUS_SUCCESS,
             __FUNCTION__,
             __LINE__,
-            "Speaker start returned %s - expected %s.",
+            "Speaker initialization returned %s - expected %s.",
             pv_speaker_status_to_string(status),
             pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
 
-    printf("Call write on null speaker\n");
-    status = pv_speaker_write(NULL, pcm_ptr, pcm_length, &written_length);
+    printf("Call get stats with null stats\n");
+    status = pv_speaker_get_stats(speaker, NULL);
     check_condition(
             status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
             __FUNCTION__,
             __LINE__,
-            "Speaker write returned %s - expected %s.",
+            "Speaker get stats returned %s - expected %s.",
             pv_speaker_status_to_string(status),
             pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
 
-    printf("Call write with null pcm\n");
-    status = pv_speaker_write(speaker, NULL, pcm_length, &written_length);
+    status = pv_speaker_start(speaker);
     check_condition(
-            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            status == PV_SPEAKER_STATUS_SUCCESS,
             __FUNCTION__,
             __LINE__,
-            "Speaker write returned %s - expected %s.",
+            "Speaker start returned %s - expected %s.",
             pv_speaker_status_to_string(status),
-            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
 
-    printf("Call write with null written length\n");
-    status = pv_speaker_write(speaker, pcm_ptr, pcm_length, NULL);
+    int32_t written_length = 0;
+    status = pv_speaker_write(speaker, (int8_t *) pcm, pcm_length, &written_length);
     check_condition(
-            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            status == PV_SPEAKER_STATUS_SUCCESS,
             __FUNCTION__,
             __LINE__,
             "Speaker write returned %s - expected %s.",
             pv_speaker_status_to_string(status),
-            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
 
-    printf("Call write with valid args\n");
-    status = pv_speaker_write(speaker, pcm_ptr, pcm_length, &written_length);
+    printf("Call get stats after the buffer ran dry\n");
+    usleep(1000 * 1000);
+    status = pv_speaker_get_stats(speaker, &stats);
     check_condition(
             status == PV_SPEAKER_STATUS_SUCCESS,
             __FUNCTION__,
             __LINE__,
-            "Speaker write returned %s - expected %s.",
+            "Speaker get stats returned %s - expected %s.",
             pv_speaker_status_to_string(status),
             pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
-
-    printf("Check is_started on started speaker\n");
-    is_started = pv_speaker_get_is_started(speaker);
     check_condition(
-            is_started == true,
+            stats.frames_written == pcm_length && stats.frames_played == pcm_length,
             __FUNCTION__,
             __LINE__,
-            "get_is_started returned false - expected true.");
+            "Speaker stats report %ld samples written and %ld played - expected %d.",
+            (long) stats.frames_written,
+            (long) stats.frames_played,
+            pcm_length);
+    check_condition(
+            stats.peak_fill > 0 && stats.fill == 0,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker stats report a fill of %d and a peak fill of %d.",
+            stats.fill,
+            stats.peak_fill);
+    check_condition(
+            stats.num_underruns == 1,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker stats report %ld underruns - expected %d.",
+            (long) stats.num_underruns,
+            1);
 
-    printf("Call flush on null speaker\n");
-    status = pv_speaker_flush(NULL, pcm_ptr, pcm_length, &written_length);
+    int64_t num_callbacks = 0;
+    for (int32_t i = 0; i < PV_SPEAKER_STATS_NUM_CALLBACK_DURATION_BUCKETS; i++) {
+        num_callbacks += stats.callback_durations[i];
+    }
     check_condition(
-            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            num_callbacks > 0,
             __FUNCTION__,
             __LINE__,
-            "Speaker flush returned %s - expected %s.",
-            pv_speaker_status_to_string(status),
-            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+            "Speaker stats report no audio callbacks.");
 
-    printf("Call flush with valid args\n");
-    status = pv_speaker_flush(speaker, pcm_ptr, pcm_length, &written_length);
+    status = pv_speaker_stop(speaker);
     check_condition(
             status == PV_SPEAKER_STATUS_SUCCESS,
             __FUNCTION__,
             __LINE__,
-            "Speaker flush returned %s - expected %s.",
+            "Speaker stop returned %s - expected %s.",
             pv_speaker_status_to_string(status),
             pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
 
-    printf("Call flush with null pcm\n");
-    status = pv_speaker_flush(speaker, NULL, pcm_length, &written_length);
+    pv_speaker_delete(speaker);
+    free(pcm);
+}
+
+#define NUM_CONCURRENT_SPEAKERS (4)
+
+typedef struct {
+    pv_speaker_t *speaker;
+    int8_t *pcm;
+    int32_t pcm_length;
+    pv_speaker_status_t status;
+    int32_t written_length;
+} test_pv_speaker_flush_args_t;
+
+static void *test_pv_speaker_flush_thread(void *arg) {
+    test_pv_speaker_flush_args_t *args = (test_pv_speaker_flush_args_t *) arg;
+    args->status = pv_speaker_flush(args->speaker, args->pcm, args->pcm_length, &args->written_length);
+    return NULL;
+}
+
+static void *test_pv_speaker_write_blocking_thread(void *arg) {
+    test_pv_speaker_flush_args_t *args = (test_pv_speaker_flush_args_t *) arg;
+    args->status = pv_speaker_write_blocking(args->speaker, args->pcm, args->pcm_length, -1, &args->written_length);
+    return NULL;
+}
+
+static void test_pv_speaker_concurrent_flush(void) {
+    pv_speaker_t *speakers[NUM_CONCURRENT_SPEAKERS] = {NULL};
+    test_pv_speaker_flush_args_t args[NUM_CONCURRENT_SPEAKERS];
+    pthread_t threads[NUM_CONCURRENT_SPEAKERS];
+    pv_speaker_status_t status;
+
+    // more than the one second circular buffer holds, so every flush has to wait on its own callback
+    const int32_t pcm_length = 24000;
+    int16_t *pcm = calloc(pcm_length, sizeof(int16_t));
+    check_condition(pcm != NULL, __FUNCTION__, __LINE__, "Failed to allocate PCM data.");
+
+    for (int32_t i = 0; i < NUM_CONCURRENT_SPEAKERS; i++) {
+        status = pv_speaker_init(16000, 16, 1, -1, &speakers[i]);
+        check_condition(
+                status == PV_SPEAKER_STATUS_SUCCESS,
+                __FUNCTION__,
+                __LINE__,
+                "Speaker initialization returned %s - expected %s.",
+                pv_speaker_status_to_string(status),
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+        status = pv_speaker_start(speakers[i]);
+        check_condition(
+                status == PV_SPEAKER_STATUS_SUCCESS,
+                __FUNCTION__,
+                __LINE__,
+                "Speaker start returned %s - expected %s.",
+                pv_speaker_status_to_string(status),
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+    }
+
+    printf("Call flush on %d speakers in parallel\n", NUM_CONCURRENT_SPEAKERS);
+    for (int32_t i = 0; i < NUM_CONCURRENT_SPEAKERS; i++) {
+        args[i].speaker = speakers[i];
+        args[i].pcm = (int8_t *) pcm;
+        args[i].pcm_length = pcm_length;
+        args[i].status = PV_SPEAKER_STATUS_RUNTIME_ERROR;
+        args[i].written_length = 0;
+        check_condition(
+                pthread_create(&threads[i], NULL, test_pv_speaker_flush_thread, &args[i]) == 0,
+                __FUNCTION__,
+                __LINE__,
+                "Failed to create flush thread.");
+    }
+
+    printf("Stop one speaker while the others are flushing\n");
+    usleep(100 * 1000);
+    status = pv_speaker_stop(speakers[0]);
     check_condition(
             status == PV_SPEAKER_STATUS_SUCCESS,
             __FUNCTION__,
             __LINE__,
-            "Speaker flush returned %s - expected %s.",
+            "Speaker stop returned %s - expected %s.",
             pv_speaker_status_to_string(status),
             pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
 
-    printf("Call stop on valid speaker object\n");
-    status = pv_speaker_stop(speaker);
+    for (int32_t i = 0; i < NUM_CONCURRENT_SPEAKERS; i++) {
+        pthread_join(threads[i], NULL);
+        check_condition(
+                args[i].status == PV_SPEAKER_STATUS_SUCCESS,
+                __FUNCTION__,
+                __LINE__,
+                "Speaker flush returned %s - expected %s.",
+                pv_speaker_status_to_string(args[i].status),
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+        if (i > 0) {
+            check_condition(
+                    args[i].written_length == pcm_length,
+                    __FUNCTION__,
+                    __LINE__,
+                    "Speaker flush wrote %d samples - expected %d.",
+                    args[i].written_length,
+                    pcm_length);
+        }
+    }
+
+    for (int32_t i = 1; i < NUM_CONCURRENT_SPEAKERS; i++) {
+        status = pv_speaker_stop(speakers[i]);
+        check_condition(
+                status == PV_SPEAKER_STATUS_SUCCESS,
+                __FUNCTION__,
+                __LINE__,
+                "Speaker stop returned %s - expected %s.",
+                pv_speaker_status_to_string(status),
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+    }
+
+    printf("Stop a speaker with %d blocked writers\n", NUM_CONCURRENT_SPEAKERS);
+    status = pv_speaker_start(speakers[0]);
     check_condition(
             status == PV_SPEAKER_STATUS_SUCCESS,
             __FUNCTION__,
             __LINE__,
-            "Speaker stop returned %s - expected %s.",
+            "Speaker start returned %s - expected %s.",
             pv_speaker_status_to_string(status),
             pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
 
-    printf("Check is_started on stopped speaker\n");
-    is_started = pv_speaker_get_is_started(speaker);
+    for (int32_t i = 0; i < NUM_CONCURRENT_SPEAKERS; i++) {
+        args[i].speaker = speakers[0];
+        args[i].status = PV_SPEAKER_STATUS_RUNTIME_ERROR;
+        args[i].written_length = 0;
+        check_condition(
+                pthread_create(&threads[i], NULL, test_pv_speaker_write_blocking_thread, &args[i]) == 0,
+                __FUNCTION__,
+                __LINE__,
+                "Failed to create write blocking thread.");
+    }
+
+    // the writers share one second of buffer, so they are all still waiting when the device stops. Every one of them
+    // has to be woken up, since no callback follows.
+    usleep(100 * 1000);
+    status = pv_speaker_stop(speakers[0]);
     check_condition(
-            is_started == false,
+            status == PV_SPEAKER_STATUS_SUCCESS,
             __FUNCTION__,
             __LINE__,
-            "get_is_started returned true - expected false.");
+            "Speaker stop returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
 
-    pv_speaker_delete(speaker);
+    for (int32_t i = 0; i < NUM_CONCURRENT_SPEAKERS; i++) {
+        pthread_join(threads[i], NULL);
+        check_condition(
+                (args[i].status == PV_SPEAKER_STATUS_SUCCESS) && (args[i].written_length < pcm_length),
+                __FUNCTION__,
+                __LINE__,
+                "Speaker write blocking returned %s after writing %d samples - expected %s before %d.",
+                pv_speaker_status_to_string(args[i].status),
+                args[i].written_length,
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS),
+                pcm_length);
+    }
+
+    for (int32_t i = 0; i < NUM_CONCURRENT_SPEAKERS; i++) {
+        pv_speaker_delete(speakers[i]);
+    }
+    free(pcm);
 }
 
-static void test_pv_speaker_write_flow(void) {
+static int32_t test_pv_speaker_stall_state = 0;
+
+// holds up the audio thread like a stalled backend would, until the test moves the state on from 1
+static void test_pv_speaker_stall_callback(void *user_data, int64_t frame_index) {
+    (void) user_data;
+    (void) frame_index;
+
+    __atomic_store_n(&test_pv_speaker_stall_state, 1, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&test_pv_speaker_stall_state, __ATOMIC_ACQUIRE) == 1) {
+        usleep(1000);
+    }
+}
+
+static void test_pv_speaker_cancel(void) {
     pv_speaker_t *speaker = NULL;
     pv_speaker_status_t status;
-    int32_t sample_rate = 16000;
-    int32_t buffer_size_secs = 1;
-    int32_t circular_buffer_size = sample_rate * buffer_size_secs;
-    int32_t pcm_length = circular_buffer_size + 1;
-    int16_t pcm[pcm_length];
-    memset(pcm, 0, sizeof(pcm));
-    int8_t *pcm_ptr = (int8_t *) pcm;
-    int32_t written_length = 0;
+    pv_speaker_stats_t stats;
 
-    status = pv_speaker_init(sample_rate, 16, buffer_size_secs, 0, &speaker);
+    const int32_t pcm_length = 24000;
+    int16_t *pcm = calloc(pcm_length, sizeof(int16_t));
+    check_condition(pcm != NULL, __FUNCTION__, __LINE__, "Failed to allocate PCM data.");
+
+    status = pv_speaker_init(16000, 16, 1, -1, &speaker);
     check_condition(
             status == PV_SPEAKER_STATUS_SUCCESS,
             __FUNCTION__,
@@ -260,7 +2699,26 @@ static void test_pv_speaker_write_flow(void) {
             pv_speaker_status_to_string(status),
             pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
 
-    printf("Call start\n");
+    int32_t discarded_length = -1;
+    printf("Call cancel with invalid arguments\n");
+    status = pv_speaker_cancel(speaker, -1, &discarded_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker cancel returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    status = pv_speaker_cancel(speaker, 10, &discarded_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_STATE,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker cancel returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_STATE));
+
     status = pv_speaker_start(speaker);
     check_condition(
             status == PV_SPEAKER_STATUS_SUCCESS,
@@ -270,57 +2728,140 @@ static void test_pv_speaker_write_flow(void) {
             pv_speaker_status_to_string(status),
             pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
 
-    const char *output_file = "tmp.wav";
-    printf("Call write to file\n");
-    status = pv_speaker_write_to_file(speaker, output_file);
+    printf("Cancel while playing\n");
+    int32_t written_length = 0;
+    status = pv_speaker_write(speaker, (int8_t *) pcm, 8000, &written_length);
     check_condition(
-            status == PV_SPEAKER_STATUS_SUCCESS,
+            status == PV_SPEAKER_STATUS_SUCCESS && written_length == 8000,
             __FUNCTION__,
             __LINE__,
-            "Speaker write to file returned %s - expected %s.",
+            "Speaker write returned %s and wrote %d frames - expected %s and %d frames.",
             pv_speaker_status_to_string(status),
-            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+            written_length,
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS),
+            8000);
+
+    usleep(100 * 1000);
+    status = pv_speaker_cancel(speaker, 10, &discarded_length);
+    pv_speaker_get_stats(speaker, &stats);
     check_condition(
-            access(output_file, F_OK) == 0,
+            (status == PV_SPEAKER_STATUS_SUCCESS) &&
+                    (discarded_length > 0) &&
+                    ((stats.frames_played + discarded_length) == 8000) &&
+                    (stats.fill == 0),
             __FUNCTION__,
             __LINE__,
-            "Speaker write to file returned %s - expected %s.",
-            access(output_file, F_OK),
-            true);
+            "Speaker cancel played %lld frames and discarded %d - expected %d in total and an empty buffer.",
+            (long long) stats.frames_played,
+            discarded_length,
+            8000);
 
-    printf("Call write with pcm length greater than circular buffer's capacity/available space\n");
-    status = pv_speaker_write(speaker, pcm_ptr, pcm_length, &written_length);
+    status = pv_speaker_cancel(speaker, 0, &discarded_length);
     check_condition(
-            status == PV_SPEAKER_STATUS_SUCCESS,
+            (status == PV_SPEAKER_STATUS_SUCCESS) && (discarded_length == 0),
             __FUNCTION__,
             __LINE__,
-            "Speaker write returned %s - expected %s.",
-            pv_speaker_status_to_string(status),
-            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+            "Speaker cancel of an empty buffer discarded %d frames - expected none.",
+            discarded_length);
+
+    printf("Cancel a blocked flush\n");
+    test_pv_speaker_flush_args_t args = {
+            .speaker = speaker,
+            .pcm = (int8_t *) pcm,
+            .pcm_length = pcm_length,
+            .status = PV_SPEAKER_STATUS_RUNTIME_ERROR,
+            .written_length = 0,
+    };
+    pthread_t thread;
     check_condition(
-            written_length == circular_buffer_size,
+            pthread_create(&thread, NULL, test_pv_speaker_flush_thread, &args) == 0,
             __FUNCTION__,
             __LINE__,
-            "Speaker write returned %s - expected %s.",
+            "Failed to create flush thread.");
+
+    usleep(200 * 1000);
+    status = pv_speaker_cancel(speaker, 0, &discarded_length);
+    pthread_join(thread, NULL);
+    check_condition(
+            (status == PV_SPEAKER_STATUS_SUCCESS) &&
+                    (args.status == PV_SPEAKER_STATUS_SUCCESS) &&
+                    (discarded_length > 0) &&
+                    (args.written_length < pcm_length),
+            __FUNCTION__,
+            __LINE__,
+            "Cancelled flush returned %s after writing %d frames, %d were discarded.",
+            pv_speaker_status_to_string(args.status),
+            args.written_length,
+            discarded_length);
+
+    printf("Cancel while the audio thread is stalled\n");
+    status = pv_speaker_write(speaker, (int8_t *) pcm, 8000, &written_length);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS && written_length == 8000,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write returned %s and wrote %d frames - expected %s and %d frames.",
+            pv_speaker_status_to_string(status),
             written_length,
-            circular_buffer_size);
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS),
+            8000);
 
-    printf("Call flush with pcm length greater than circular buffer's capacity/available space\n");
-    status = pv_speaker_flush(speaker, pcm_ptr, pcm_length, &written_length);
+    int64_t frames_played = 0;
+    uint64_t timestamp_ns = 0;
+    pv_speaker_get_position(speaker, &frames_played, &timestamp_ns);
+    status = pv_speaker_add_marker(speaker, frames_played, test_pv_speaker_stall_callback, NULL);
     check_condition(
             status == PV_SPEAKER_STATUS_SUCCESS,
             __FUNCTION__,
             __LINE__,
-            "Speaker flush returned %s - expected %s.",
+            "Speaker add marker returned %s - expected %s.",
             pv_speaker_status_to_string(status),
             pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+    while (__atomic_load_n(&test_pv_speaker_stall_state, __ATOMIC_ACQUIRE) != 1) {
+        usleep(1000);
+    }
+
+    status = pv_speaker_cancel(speaker, 0, &discarded_length);
     check_condition(
-            written_length == pcm_length,
+            (status == PV_SPEAKER_STATUS_TIMEOUT) && (discarded_length == 0),
             __FUNCTION__,
             __LINE__,
-            "Speaker flush returned %s - expected %s.",
+            "Speaker cancel on a stalled device returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_TIMEOUT));
+
+    // the mutex is released, so writers are not stuck behind the cancel
+    pv_speaker_get_stats(speaker, &stats);
+    const int64_t frames_played_before = stats.frames_played;
+    status = pv_speaker_write(speaker, (int8_t *) pcm, 1600, &written_length);
+    check_condition(
+            (status == PV_SPEAKER_STATUS_SUCCESS) && (written_length == 1600),
+            __FUNCTION__,
+            __LINE__,
+            "Speaker write after a timed out cancel returned %s and wrote %d frames - expected %s and %d frames.",
+            pv_speaker_status_to_string(status),
             written_length,
-            pcm_length);
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS),
+            1600);
+
+    __atomic_store_n(&test_pv_speaker_stall_state, 2, __ATOMIC_RELEASE);
+
+    // the callback applies the cancel as soon as it runs again, and only drops what was written before it
+    for (int32_t i = 0; i < 1000; i++) {
+        pv_speaker_get_stats(speaker, &stats);
+        if (stats.fill == 0) {
+            break;
+        }
+        usleep(1000);
+    }
+    check_condition(
+            (stats.fill == 0) && ((stats.frames_played - frames_played_before) == 1600),
+            __FUNCTION__,
+            __LINE__,
+            "Played %lld frames after the stall and holds %d - expected the %d frames written after the cancel.",
+            (long long) (stats.frames_played - frames_played_before),
+            stats.fill,
+            1600);
 
     status = pv_speaker_stop(speaker);
     check_condition(
@@ -332,7 +2873,7 @@ static void test_pv_speaker_write_flow(void) {
             pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
 
     pv_speaker_delete(speaker);
-    remove(output_file);
+    free(pcm);
 }
 
 static void test_pv_speaker_get_selected_device(void) {
@@ -404,6 +2945,81 @@ static void test_pv_speaker_get_available_devices(void) {
             __LINE__,
             "device_list should have not been NULL");
 
+    printf("Refresh the device list\n");
+    status = pv_speaker_refresh_available_devices();
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "pv_speaker_refresh_available_devices returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+
+    int32_t refreshed_list_length = -1;
+    char **refreshed_list = NULL;
+    status = pv_speaker_get_available_devices(&refreshed_list_length, &refreshed_list);
+    check_condition(
+            status == PV_SPEAKER_STATUS_SUCCESS,
+            __FUNCTION__,
+            __LINE__,
+            "pv_speaker_get_available_devices returned %s - expected %s.",
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+    check_condition(
+            refreshed_list_length == device_list_length,
+            __FUNCTION__,
+            __LINE__,
+            "Refreshed device list has %d devices - expected %d.",
+            refreshed_list_length,
+            device_list_length);
+    for (int32_t i = 0; (i < refreshed_list_length) && (i < device_list_length); i++) {
+        check_condition(
+                strcmp(refreshed_list[i], device_list[i]) == 0,
+                __FUNCTION__,
+                __LINE__,
+                "Refreshed device %d is `%s` - expected `%s`.",
+                i,
+                refreshed_list[i],
+                device_list[i]);
+    }
+    pv_speaker_free_available_devices(refreshed_list_length, refreshed_list);
+
+    printf("Initialize speakers on every device at the same time\n");
+    pv_speaker_t *speakers[8] = {NULL};
+    const int32_t num_speakers = (device_list_length < 8) ? device_list_length : 8;
+    for (int32_t i = 0; i < num_speakers; i++) {
+        status = pv_speaker_init(16000, 16, 1, i, &speakers[i]);
+        check_condition(
+                status == PV_SPEAKER_STATUS_SUCCESS,
+                __FUNCTION__,
+                __LINE__,
+                "Speaker initialization on device %d returned %s - expected %s.",
+                i,
+                pv_speaker_status_to_string(status),
+                pv_speaker_status_to_string(PV_SPEAKER_STATUS_SUCCESS));
+        check_condition(
+                speakers[i] != NULL,
+                __FUNCTION__,
+                __LINE__,
+                "Speaker initialized on device %d should not have been NULL.",
+                i);
+    }
+
+    pv_speaker_t *speaker = NULL;
+    status = pv_speaker_init(16000, 16, 1, device_list_length, &speaker);
+    check_condition(
+            status == PV_SPEAKER_STATUS_INVALID_ARGUMENT,
+            __FUNCTION__,
+            __LINE__,
+            "Speaker initialization on device %d returned %s - expected %s.",
+            device_list_length,
+            pv_speaker_status_to_string(status),
+            pv_speaker_status_to_string(PV_SPEAKER_STATUS_INVALID_ARGUMENT));
+
+    for (int32_t i = 0; i < num_speakers; i++) {
+        pv_speaker_delete(speakers[i]);
+    }
+
     pv_speaker_free_available_devices(device_list_length, device_list);
 }
 
@@ -422,8 +3038,27 @@ int main() {
     test_pv_speaker_get_available_devices();
     test_pv_speaker_version();
     test_pv_speaker_init();
+    test_pv_speaker_init_ex();
+    test_pv_speaker_float_stereo();
+    test_pv_speaker_resampler();
+    test_pv_speaker_mixer();
     test_pv_speaker_start_stop();
     test_pv_speaker_write_flow();
+    test_pv_speaker_file_drop_int24();
+    test_pv_speaker_write_reserve_commit();
+    test_pv_speaker_write_blocking();
+    test_pv_speaker_pack_int24();
+    test_pv_speaker_notify();
+    test_pv_speaker_shared_buffer();
+    test_pv_speaker_flush_timeout();
+    test_pv_speaker_play_file();
+    test_pv_speaker_render_callback();
+    test_pv_speaker_set_gain();
+    test_pv_speaker_pause_resume();
+    test_pv_speaker_position();
+    test_pv_speaker_get_stats();
+    test_pv_speaker_concurrent_flush();
+    test_pv_speaker_cancel();
     test_pv_speaker_get_selected_device();
 
     return 0;